@@ -13,6 +13,10 @@
 #include <list>
 #include <math.h>
 #include <stdlib.h>
+#include <new>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "delaunay_voronoi.h"
 #include "execution_report.h"
 #include "remap_common_utils.h"
@@ -153,26 +157,46 @@ void Triangle::check_and_set_twin_edge_relationship(Triangle *another_triangle)
 }
 
 
+/* For a large triangle, the remained points are scanned by OpenMP threads over contiguous ranges. The first point
+   with the maximum distance is selected as in the serial scan, so the triangulation does not depend on threads */
 int Triangle::find_best_candidate_point()
 {
-    double max_min_dist = -1, min_dist, dist;
-    int best_candidate_id;
+    double max_min_dist = -1;
+    int best_candidate_id = -1;
+    int num_points = remained_points_in_triangle.size();
 
     
-    if (remained_points_in_triangle.size() == 0)
+    if (num_points == 0)
         return -1;
 
-    for (int i = 0; i < remained_points_in_triangle.size(); i ++) {
-        min_dist = remained_points_in_triangle[i]->calculate_distance(v[0]);
-        dist = remained_points_in_triangle[i]->calculate_distance(v[1]);
-        if (min_dist > dist)
-            min_dist = dist;
-        dist = remained_points_in_triangle[i]->calculate_distance(v[2]);
-        if (min_dist > dist)
-            min_dist = dist;
-        if (max_min_dist < min_dist) {
-            max_min_dist = min_dist;
-            best_candidate_id = i;
+#ifdef _OPENMP
+#pragma omp parallel if(num_points >= MIN_NUM_POINTS_FOR_PARALLEL_TRIANGLE_SCAN)
+#endif
+    {
+        double thread_max_min_dist = -1, min_dist, dist;
+        int thread_best_candidate_id = -1;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < num_points; i ++) {
+            min_dist = remained_points_in_triangle[i]->calculate_distance(v[0]);
+            dist = remained_points_in_triangle[i]->calculate_distance(v[1]);
+            if (min_dist > dist)
+                min_dist = dist;
+            dist = remained_points_in_triangle[i]->calculate_distance(v[2]);
+            if (min_dist > dist)
+                min_dist = dist;
+            if (thread_max_min_dist < min_dist) {
+                thread_max_min_dist = min_dist;
+                thread_best_candidate_id = i;
+            }
+        }
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+        if (thread_best_candidate_id != -1 && (max_min_dist < thread_max_min_dist || (max_min_dist == thread_max_min_dist && thread_best_candidate_id < best_candidate_id))) {
+            max_min_dist = thread_max_min_dist;
+            best_candidate_id = thread_best_candidate_id;
         }
     }
 
@@ -244,7 +268,6 @@ Point::Point(double lat, double lon, int id)
 {
     this->id = id;
     update_coord_values(lon, lat);
-    this->current_triangle = NULL;
 }
 
 
@@ -504,6 +527,8 @@ Delaunay_Voronoi::Delaunay_Voronoi(int num_points, double *lat_values, double *l
     current_delaunay_voronoi = this;
 
     num_cells = num_points;
+    num_triangles_in_last_chunk = 0;
+    num_edges_in_last_chunk = 0;
     
     mark = new bool [num_points];
     for (i = 0; i < num_points; i ++)
@@ -525,10 +550,8 @@ Delaunay_Voronoi::Delaunay_Voronoi(int num_points, double *lat_values, double *l
         cells[i].center = point;
         if (!mark[i])
             continue;
-        if (redundant_cell_mark == NULL || !redundant_cell_mark[i]) {
-            point->current_triangle = root;
+        if (redundant_cell_mark == NULL || !redundant_cell_mark[i])
             root->remained_points_in_triangle.push_back(point);
-        }
     }
     
     delete [] mark;
@@ -611,8 +634,10 @@ Delaunay_Voronoi::Delaunay_Voronoi(int num_points, double *lat_values, double *l
         root->children[i]->reference_count ++;
 
     distribute_points_into_triangles(&(root->remained_points_in_triangle), &(root->children));
+    vector<Point*>().swap(root->remained_points_in_triangle);
     for (int i = 0; i < root->children.size(); i ++)
         triangularization_process(root->children[i], is_global_grid);
+    delete root;
 
     generate_Voronoi_diagram();
     extract_vertex_coordinate_values(num_points, is_global_grid, output_vertex_lon_values, output_vertex_lat_values, output_num_vertexes);
@@ -703,27 +728,37 @@ Triangle *Delaunay_Voronoi::search_triangle_with_point(Triangle *cur_triangle, c
 }
 
 
+/* The triangle of each point is located in parallel for a large set of points, while the points are appended to
+   the triangles serially so that their order is the same as in the serial version */
 void Delaunay_Voronoi::distribute_points_into_triangles(vector<Point*> *pnts, vector<Triangle*> *triangles)
 {
-    bool find_triangle;
+    int num_points = pnts->size(), num_triangles = triangles->size();
+    vector<int> points_triangle_indx(num_points);
 
 
-    for (int i = 0; i < pnts->size(); i ++) {
-        find_triangle = false;
-        for (int j = 0; j < triangles->size(); j ++) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(num_points >= MIN_NUM_POINTS_FOR_PARALLEL_TRIANGLE_SCAN)
+#endif
+    for (int i = 0; i < num_points; i ++) {
+        points_triangle_indx[i] = -1;
+        for (int j = 0; j < num_triangles; j ++) {
             if (!((*triangles)[j])->is_leaf)
                 continue;
             if ((*pnts)[i]->position_to_triangle(((*triangles)[j])) >= 0) {
-                (*pnts)[i]->current_triangle = (*triangles)[j];
-                (*triangles)[j]->remained_points_in_triangle.push_back((*pnts)[i]);
-                find_triangle = true;
+                points_triangle_indx[i] = j;
                 break;
             }
         }
-        if (!find_triangle) 
-            if (is_global_grid)
-                EXECUTION_REPORT(REPORT_ERROR, -1, false, "CoR may have bugs, please contact liuli-cess@tsinghua.edu.cn");
-            else EXECUTION_REPORT(REPORT_ERROR, -1, false, "please enlarge the boundary of the regional grid: point (%lf %lf): ", (*pnts)[i]->lon, (*pnts)[i]->lat); 
+    }
+
+    for (int i = 0; i < num_points; i ++) {
+        if (points_triangle_indx[i] != -1) {
+            (*triangles)[points_triangle_indx[i]]->remained_points_in_triangle.push_back((*pnts)[i]);
+            continue;
+        }
+        if (is_global_grid)
+            EXECUTION_REPORT(REPORT_ERROR, -1, false, "CoR may have bugs, please contact liuli-cess@tsinghua.edu.cn");
+        else EXECUTION_REPORT(REPORT_ERROR, -1, false, "please enlarge the boundary of the regional grid: point (%lf %lf): ", (*pnts)[i]->lon, (*pnts)[i]->lat); 
     }
 }
 
@@ -855,6 +890,7 @@ void Delaunay_Voronoi::triangularization_process(Triangle *triangle, bool is_glo
         if (leaf_triangles[i]->is_leaf)
             continue;
         distribute_points_into_triangles(&(leaf_triangles[i]->remained_points_in_triangle), &leaf_triangles);
+        vector<Point*>().swap(leaf_triangles[i]->remained_points_in_triangle);
     }        
     for (int i = 0; i < leaf_triangles.size(); i ++)
         triangularization_process(leaf_triangles[i], is_global_grid);
@@ -868,10 +904,18 @@ Delaunay_Voronoi::~Delaunay_Voronoi()
     for (int i = 0; i < num_cells; i ++)
         delete cells[i].center;
     delete [] cells;
-    for (int i = 0; i < edge_pool.size(); i ++)
-        delete edge_pool[i];
-    for (int i = 0; i < triangle_pool.size(); i ++)
-        delete triangle_pool[i];
+    for (int i = 0; i < edge_pool_chunks.size(); i ++) {
+        int num_edges = i == edge_pool_chunks.size()-1? num_edges_in_last_chunk : NUM_OBJECTS_IN_DELAUNAY_VORONOI_POOL_CHUNK;
+        for (int j = 0; j < num_edges; j ++)
+            ((Edge*) edge_pool_chunks[i])[j].~Edge();
+        delete [] edge_pool_chunks[i];
+    }
+    for (int i = 0; i < triangle_pool_chunks.size(); i ++) {
+        int num_triangles = i == triangle_pool_chunks.size()-1? num_triangles_in_last_chunk : NUM_OBJECTS_IN_DELAUNAY_VORONOI_POOL_CHUNK;
+        for (int j = 0; j < num_triangles; j ++)
+            ((Triangle*) triangle_pool_chunks[i])[j].~Triangle();
+        delete [] triangle_pool_chunks[i];
+    }
     current_delaunay_voronoi = NULL;
 }
 
@@ -964,10 +1008,24 @@ void Delaunay_Voronoi::generate_Voronoi_diagram()
         }
 }
 
+/* Triangles and edges are constructed in chunks of NUM_OBJECTS_IN_DELAUNAY_VORONOI_POOL_CHUNK objects, which are
+   released together by the destructor. The count of objects in the last chunk is only increased once an object has 
+   been constructed */
+void *Delaunay_Voronoi::get_free_slot_in_pool(vector<char*> &pool_chunks, int &num_objects_in_last_chunk, int object_size)
+{
+    if (pool_chunks.size() == 0 || num_objects_in_last_chunk == NUM_OBJECTS_IN_DELAUNAY_VORONOI_POOL_CHUNK) {
+        pool_chunks.push_back(new char [((long)object_size)*NUM_OBJECTS_IN_DELAUNAY_VORONOI_POOL_CHUNK]);
+        num_objects_in_last_chunk = 0;
+    }
+
+    return pool_chunks.back() + ((long)object_size)*num_objects_in_last_chunk;
+}
+
+
 Edge *Delaunay_Voronoi::allocate_edge(Point *head, Point *tail)
 {
-    Edge *new_edge = new Edge(head, tail);
-    edge_pool.push_back(new_edge);
+    Edge *new_edge = new (get_free_slot_in_pool(edge_pool_chunks, num_edges_in_last_chunk, sizeof(Edge))) Edge(head, tail);
+    num_edges_in_last_chunk ++;
 
     return new_edge;
 }
@@ -975,8 +1033,8 @@ Edge *Delaunay_Voronoi::allocate_edge(Point *head, Point *tail)
 
 Triangle *Delaunay_Voronoi::allocate_Triangle(Point *point1, Point *point2, Point *point3)
 {
-    Triangle *new_triangle = new Triangle(point1, point2, point3);
-    triangle_pool.push_back(new_triangle);
+    Triangle *new_triangle = new (get_free_slot_in_pool(triangle_pool_chunks, num_triangles_in_last_chunk, sizeof(Triangle))) Triangle(point1, point2, point3);
+    num_triangles_in_last_chunk ++;
 
     return new_triangle;
 }
@@ -984,8 +1042,8 @@ Triangle *Delaunay_Voronoi::allocate_Triangle(Point *point1, Point *point2, Poin
 
 Triangle *Delaunay_Voronoi::allocate_Triangle(Edge *edge1, Edge *edge2, Edge *edge3)
 {
-    Triangle *new_triangle = new Triangle(edge1, edge2, edge3);
-    triangle_pool.push_back(new_triangle);
+    Triangle *new_triangle = new (get_free_slot_in_pool(triangle_pool_chunks, num_triangles_in_last_chunk, sizeof(Triangle))) Triangle(edge1, edge2, edge3);
+    num_triangles_in_last_chunk ++;
 
     return new_triangle;
 }
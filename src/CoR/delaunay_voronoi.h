@@ -19,6 +19,10 @@
 #include <iostream>
 
 
+#define NUM_OBJECTS_IN_DELAUNAY_VORONOI_POOL_CHUNK       4096
+#define MIN_NUM_POINTS_FOR_PARALLEL_TRIANGLE_SCAN        8192
+
+
 using namespace std;
 
 
@@ -36,7 +40,6 @@ class Point
         double y;
         double z;
         int id;
-        Triangle *current_triangle;
 
         Point(double lat = double(), double lon = double(), int id = -1);
         double calculate_distance(const Point *pt) const;
@@ -107,8 +110,10 @@ class Delaunay_Voronoi
     public:
         Cell *cells;
         vector<Triangle*> result_leaf_triangles;
-        vector<Triangle*> triangle_pool;
-        vector<Edge*> edge_pool;
+        vector<char*> triangle_pool_chunks;
+        vector<char*> edge_pool_chunks;
+        int num_triangles_in_last_chunk;
+        int num_edges_in_last_chunk;
         bool is_global_grid;
         int num_cells;
 
@@ -122,6 +127,7 @@ class Delaunay_Voronoi
 
 
     private:
+        void *get_free_slot_in_pool(vector<char*>&, int&, int);
         void check_and_set_twin_edge_relationship(vector<Triangle*>*);
         Point *generate_boundary_point(double, double, Triangle*, bool);
         void generate_initial_triangles(Triangle*, vector<Point*>*, vector<Point*>*, bool);
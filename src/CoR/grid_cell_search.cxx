@@ -10,6 +10,10 @@
 #include "remap_utils_nearest_points.h"
 #include "quick_sort.h"
 #include <math.h>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 void seperate_cells_in_children_tiles(int num_cells, H2D_grid_cell_search_cell **cells, double center_lon, double center_lat, 
@@ -71,6 +75,15 @@ H2D_grid_cell_cartesian_coord::~H2D_grid_cell_cartesian_coord()
 
 H2D_grid_cell_search_cell::H2D_grid_cell_search_cell(int cell_index, double center_lon, double center_lat, bool mask, 
                                                        int num_vertex, const double *vertex_lons, const double *vertex_lats, int edge_type)
+{
+    initialize(cell_index, center_lon, center_lat, mask, num_vertex, vertex_lons, vertex_lats, edge_type, NULL, NULL);
+}
+
+
+/* When vertex_lons_buffer and vertex_lats_buffer are not NULL, the vertexes are kept in the given buffers (of num_vertex 
+   elements) that belong to the contiguous cell storage of the search engine */
+void H2D_grid_cell_search_cell::initialize(int cell_index, double center_lon, double center_lat, bool mask, int num_vertex, const double *vertex_lons, 
+                                           const double *vertex_lats, int edge_type, double *vertex_lons_buffer, double *vertex_lats_buffer)
 {
     int i, j;
 
@@ -89,6 +102,7 @@ H2D_grid_cell_search_cell::H2D_grid_cell_search_cell(int cell_index, double cent
     this->bounding_circle_center_lat = center_lat;
     this->edge_type = edge_type;
     this->cartesian_coord = NULL;
+    this->own_vertex_buffers = vertex_lons_buffer == NULL;
     
     if (num_vertex > 0) {
         EXECUTION_REPORT(REPORT_ERROR, vertex_lons != NULL && vertex_lats != NULL, "Software error2 in H2D_grid_cell_search_cell::H2D_grid_cell_search_cell");
@@ -97,8 +111,14 @@ H2D_grid_cell_search_cell::H2D_grid_cell_search_cell(int cell_index, double cent
                 EXECUTION_REPORT(REPORT_ERROR, vertex_lons[i] == NULL_COORD_VALUE && vertex_lats[i] == NULL_COORD_VALUE, "Software error3 in H2D_grid_cell_search_cell::H2D_grid_cell_search_cell");
             else this->num_vertex ++;
         if (this->num_vertex > 0) {
-            this->vertex_lons = new double [this->num_vertex];
-            this->vertex_lats = new double [this->num_vertex];
+            if (own_vertex_buffers) {
+                this->vertex_lons = new double [this->num_vertex];
+                this->vertex_lats = new double [this->num_vertex];
+            }
+            else {
+                this->vertex_lons = vertex_lons_buffer;
+                this->vertex_lats = vertex_lats_buffer;
+            }
             for (i = 0, j = 0; i < num_vertex; i ++) {
                 if (vertex_lons[i] == NULL_COORD_VALUE)
                     continue;
@@ -152,7 +172,7 @@ H2D_grid_cell_search_cell::H2D_grid_cell_search_cell(int cell_index, double cent
 
 H2D_grid_cell_search_cell::~H2D_grid_cell_search_cell()
 {
-    if (vertex_lons != NULL) {
+    if (own_vertex_buffers && vertex_lons != NULL) {
         delete [] vertex_lons;
         delete [] vertex_lats;
     }
@@ -549,6 +569,239 @@ void H2D_grid_cell_search_tile::search_overlapping_cells(int &num_overlapping_ce
 }
 
 
+static double chord_length_of_arc_distance(double arc_distance)
+{
+    if (arc_distance >= PI)
+        return 2.0 * 1.00001;
+    return 2.0 * sin(arc_distance/2) * 1.00001 + 1.0e-12;
+}
+
+
+static double square_distance_to_bounding_box(const double *bounding_box, const double *point_coord)
+{
+    double square_distance = 0, diff;
+
+
+    for (int i = 0; i < 3; i ++) {
+        if (point_coord[i] < bounding_box[i])
+            diff = bounding_box[i] - point_coord[i];
+        else if (point_coord[i] > bounding_box[i+3])
+            diff = point_coord[i] - bounding_box[i+3];
+        else continue;
+        square_distance += diff * diff;
+    }
+
+    return square_distance;
+}
+
+
+struct Kd_tree_coord_comparator
+{
+    const double *coord_values;
+
+    Kd_tree_coord_comparator(const double *coord_values) { this->coord_values = coord_values; }
+    bool operator () (int i, int j) const { return coord_values[i] < coord_values[j]; }
+};
+
+
+/* The k-d tree indexes the 3D cartesian coordinates of the cell centers. The cells are reordered so that the cells of each 
+   node are contiguous, and the coordinates used during the traversal are kept in arrays of this order. */
+H2D_grid_cell_search_kd_tree::H2D_grid_cell_search_kd_tree(const H2D_grid_cell_search_cell *cells, int num_cells, H2D_grid_cell_search_cell **indexed_cells)
+{
+    this->cells = cells;
+    this->num_cells = num_cells;
+    cells_index = new int [num_cells];
+    centers_x = new double [num_cells];
+    centers_y = new double [num_cells];
+    centers_z = new double [num_cells];
+    cells_reach = new double [num_cells];
+
+    for (int i = 0; i < num_cells; i ++) {
+        const H2D_grid_cell_search_cell *cell = indexed_cells[i];
+        cells_index[i] = cell->get_cell_index();
+        get_3D_cartesian_coord_of_sphere_coord(centers_x[i], centers_y[i], centers_z[i], cell->get_center_lon(), cell->get_center_lat());
+        cells_reach[i] = 0;
+        if (cell->get_bounding_circle_radius() > 0)
+            cells_reach[i] = calculate_distance_of_two_points_2D(cell->get_center_lon(), cell->get_center_lat(), cell->get_bounding_circle_center_lon(), cell->get_bounding_circle_center_lat(), true) + cell->get_bounding_circle_radius();
+    }
+
+    if (num_cells > 0)
+        build_node(0, num_cells);
+}
+
+
+H2D_grid_cell_search_kd_tree::~H2D_grid_cell_search_kd_tree()
+{
+    delete [] cells_index;
+    delete [] centers_x;
+    delete [] centers_y;
+    delete [] centers_z;
+    delete [] cells_reach;
+}
+
+
+int H2D_grid_cell_search_kd_tree::build_node(int cells_start, int cells_end)
+{
+    H2D_grid_cell_search_kd_node node;
+    double *coord_values[3] = {centers_x, centers_y, centers_z};
+    int node_indx = nodes.size(), split_dim, i, j;
+
+
+    node.cells_start = cells_start;
+    node.cells_end = cells_end;
+    node.children[0] = -1;
+    node.children[1] = -1;
+    node.max_cell_reach = 0;
+    for (j = 0; j < 3; j ++) {
+        node.bounding_box[j] = coord_values[j][cells_start];
+        node.bounding_box[j+3] = coord_values[j][cells_start];
+    }
+    for (i = cells_start; i < cells_end; i ++) {
+        for (j = 0; j < 3; j ++) {
+            if (node.bounding_box[j] > coord_values[j][i])
+                node.bounding_box[j] = coord_values[j][i];
+            if (node.bounding_box[j+3] < coord_values[j][i])
+                node.bounding_box[j+3] = coord_values[j][i];
+        }
+        if (node.max_cell_reach < cells_reach[i])
+            node.max_cell_reach = cells_reach[i];
+    }
+    nodes.push_back(node);
+
+    if (cells_end - cells_start <= MAX_NUM_CELLS_IN_KD_LEAF)
+        return node_indx;
+
+    split_dim = 0;
+    for (j = 1; j < 3; j ++)
+        if (node.bounding_box[j+3]-node.bounding_box[j] > node.bounding_box[split_dim+3]-node.bounding_box[split_dim])
+            split_dim = j;
+
+    /* Partition the cells around the median of the split dimension and reorder all per-cell arrays accordingly */
+    int num_node_cells = cells_end - cells_start, cells_middle = (cells_start + cells_end) / 2;
+    std::vector<int> permutation(num_node_cells);
+    std::vector<int> temp_index(num_node_cells);
+    std::vector<double> temp_values(num_node_cells);
+    for (i = 0; i < num_node_cells; i ++)
+        permutation[i] = cells_start + i;
+    std::nth_element(permutation.begin(), permutation.begin()+(cells_middle-cells_start), permutation.end(), Kd_tree_coord_comparator(coord_values[split_dim]));
+    for (i = 0; i < num_node_cells; i ++)
+        temp_index[i] = cells_index[permutation[i]];
+    memcpy(cells_index+cells_start, &temp_index[0], num_node_cells*sizeof(int));
+    double *cells_values[4] = {centers_x, centers_y, centers_z, cells_reach};
+    for (j = 0; j < 4; j ++) {
+        for (i = 0; i < num_node_cells; i ++)
+            temp_values[i] = cells_values[j][permutation[i]];
+        memcpy(cells_values[j]+cells_start, &temp_values[0], num_node_cells*sizeof(double));
+    }
+
+    int left_child = build_node(cells_start, cells_middle);
+    int right_child = build_node(cells_middle, cells_end);
+    nodes[node_indx].children[0] = left_child;
+    nodes[node_indx].children[1] = right_child;
+
+    return node_indx;
+}
+
+
+void H2D_grid_cell_search_kd_tree::search_nearest_cells_in_node(int node_indx, const double *point_coord, int num_required_cells, std::vector<std::pair<double,int> > &nearest_cells) const
+{
+    const H2D_grid_cell_search_kd_node &node = nodes[node_indx];
+    double square_distance, diff_x, diff_y, diff_z;
+
+
+    if (nearest_cells.size() == num_required_cells && square_distance_to_bounding_box(node.bounding_box, point_coord) > nearest_cells.front().first)
+        return;
+
+    if (node.children[0] == -1) {
+        for (int i = node.cells_start; i < node.cells_end; i ++) {
+            if (!cells[cells_index[i]].get_mask())
+                continue;
+            diff_x = centers_x[i] - point_coord[0];
+            diff_y = centers_y[i] - point_coord[1];
+            diff_z = centers_z[i] - point_coord[2];
+            square_distance = diff_x*diff_x + diff_y*diff_y + diff_z*diff_z;
+            if (nearest_cells.size() < num_required_cells) {
+                nearest_cells.push_back(std::make_pair(square_distance, cells_index[i]));
+                std::push_heap(nearest_cells.begin(), nearest_cells.end());
+            }
+            else if (square_distance < nearest_cells.front().first) {
+                std::pop_heap(nearest_cells.begin(), nearest_cells.end());
+                nearest_cells.back() = std::make_pair(square_distance, cells_index[i]);
+                std::push_heap(nearest_cells.begin(), nearest_cells.end());
+            }
+        }
+        return;
+    }
+
+    int nearer_child = 0;
+    if (square_distance_to_bounding_box(nodes[node.children[1]].bounding_box, point_coord) < square_distance_to_bounding_box(nodes[node.children[0]].bounding_box, point_coord))
+        nearer_child = 1;
+    search_nearest_cells_in_node(node.children[nearer_child], point_coord, num_required_cells, nearest_cells);
+    search_nearest_cells_in_node(node.children[1-nearer_child], point_coord, num_required_cells, nearest_cells);
+}
+
+
+void H2D_grid_cell_search_kd_tree::search_cells_within_distance_in_node(int node_indx, const double *point_coord, double arc_distance, bool with_cell_reach, std::vector<int> &found_cells) const
+{
+    const H2D_grid_cell_search_kd_node &node = nodes[node_indx];
+    double chord_length, diff_x, diff_y, diff_z;
+
+
+    chord_length = chord_length_of_arc_distance(with_cell_reach? arc_distance + node.max_cell_reach : arc_distance);
+    if (square_distance_to_bounding_box(node.bounding_box, point_coord) > chord_length*chord_length)
+        return;
+
+    if (node.children[0] == -1) {
+        for (int i = node.cells_start; i < node.cells_end; i ++) {
+            if (with_cell_reach)
+                chord_length = chord_length_of_arc_distance(arc_distance + cells_reach[i]);
+            diff_x = centers_x[i] - point_coord[0];
+            diff_y = centers_y[i] - point_coord[1];
+            diff_z = centers_z[i] - point_coord[2];
+            if (diff_x*diff_x + diff_y*diff_y + diff_z*diff_z <= chord_length*chord_length)
+                found_cells.push_back(cells_index[i]);
+        }
+        return;
+    }
+
+    search_cells_within_distance_in_node(node.children[0], point_coord, arc_distance, with_cell_reach, found_cells);
+    search_cells_within_distance_in_node(node.children[1], point_coord, arc_distance, with_cell_reach, found_cells);
+}
+
+
+/* Search the num_required_cells nearest unmasked cell centers (the chord distance and the great-circle distance have the same order) */
+void H2D_grid_cell_search_kd_tree::search_nearest_cells(double point_lon, double point_lat, int num_required_cells, std::vector<int> &found_cells) const
+{
+    std::vector<std::pair<double,int> > nearest_cells;
+    double point_coord[3];
+
+
+    found_cells.clear();
+    if (nodes.size() == 0 || num_required_cells <= 0)
+        return;
+    get_3D_cartesian_coord_of_sphere_coord(point_coord[0], point_coord[1], point_coord[2], point_lon, point_lat);
+    nearest_cells.reserve(num_required_cells+1);
+    search_nearest_cells_in_node(0, point_coord, num_required_cells, nearest_cells);
+    for (int i = 0; i < nearest_cells.size(); i ++)
+        found_cells.push_back(nearest_cells[i].second);
+}
+
+
+/* Search the candidate cells whose centers (or bounding circles when with_cell_reach is true) may be within arc_distance of 
+   the point. The candidates are a superset of the result; the callers apply the exact checks. */
+void H2D_grid_cell_search_kd_tree::search_cells_within_distance(double point_lon, double point_lat, double arc_distance, bool with_cell_reach, std::vector<int> &found_cells) const
+{
+    double point_coord[3];
+
+
+    found_cells.clear();
+    if (nodes.size() == 0)
+        return;
+    get_3D_cartesian_coord_of_sphere_coord(point_coord[0], point_coord[1], point_coord[2], point_lon, point_lat);
+    search_cells_within_distance_in_node(0, point_coord, arc_distance, with_cell_reach, found_cells);
+}
+
+
 H2D_grid_cell_search_engine::H2D_grid_cell_search_engine(const Remap_grid_class *remap_grid, const double *center_lons, const double *center_lats, const bool *masks, 
                                                          const bool *redundant_mask, int num_vertex, const double *vertex_lons, const double *vertex_lats, int edge_type, bool build_search_structure)
 {
@@ -568,6 +821,13 @@ H2D_grid_cell_search_engine::H2D_grid_cell_search_engine(const Remap_grid_class
                 num_cells ++;
     }
         
+    cells_storage = new H2D_grid_cell_search_cell [remap_grid->get_grid_size()];
+    cells_vertex_lons = NULL;
+    cells_vertex_lats = NULL;
+    if (num_vertex > 0) {
+        cells_vertex_lons = new double [((long)remap_grid->get_grid_size())*num_vertex];
+        cells_vertex_lats = new double [((long)remap_grid->get_grid_size())*num_vertex];
+    }
     cells = new H2D_grid_cell_search_cell* [remap_grid->get_grid_size()];
     cells_ptr = new H2D_grid_cell_search_cell* [num_cells];
     cells_buffer = new H2D_grid_cell_search_cell* [num_cells];
@@ -578,7 +838,10 @@ H2D_grid_cell_search_engine::H2D_grid_cell_search_engine(const Remap_grid_class
     for (int i = 0, num_cells = 0; i < remap_grid->get_grid_size(); i ++) {
         if (masks != NULL)
             mask = masks[i];
-        cells[i] = new H2D_grid_cell_search_cell(i, center_lons[i], center_lats[i], mask, num_vertex, vertex_lons+num_vertex*i, vertex_lats+num_vertex*i, edge_type);
+        cells[i] = cells_storage + i;
+        if (num_vertex > 0)
+            cells[i]->initialize(i, center_lons[i], center_lats[i], mask, num_vertex, vertex_lons+num_vertex*i, vertex_lats+num_vertex*i, edge_type, cells_vertex_lons+((long)num_vertex)*i, cells_vertex_lats+((long)num_vertex)*i);
+        else cells[i]->initialize(i, center_lons[i], center_lats[i], mask, num_vertex, vertex_lons+num_vertex*i, vertex_lats+num_vertex*i, edge_type, NULL, NULL);
         if (redundant_mask != NULL && redundant_mask[i])
             continue;
         cells_ptr[num_cells] = cells[i];
@@ -593,22 +856,36 @@ H2D_grid_cell_search_engine::H2D_grid_cell_search_engine(const Remap_grid_class
     EXECUTION_REPORT(REPORT_ERROR, center_lon != NULL_COORD_VALUE && center_lat != NULL_COORD_VALUE && dlon != NULL_COORD_VALUE && dlat != NULL_COORD_VALUE, 
                      "Software error2 in in H2D_grid_cell_search_engine::H2D_grid_cell_search_engine");
     
-    if (build_search_structure)
+    root_tile = NULL;
+    kd_tree = NULL;
+    if (build_search_structure) {
+/* The k-d tree is an opt-in alternative to the quad tiles (-DUSE_KD_TREE_GRID_CELL_SEARCH): it may break ties and choose 
+   the early-quit cell differently, so that the remapping weights can differ from the default search */
+#ifdef USE_KD_TREE_GRID_CELL_SEARCH
+        kd_tree = new H2D_grid_cell_search_kd_tree(cells_storage, num_cells, cells_ptr);
+#else
         root_tile = new H2D_grid_cell_search_tile(num_cells, cells_ptr, cells_buffer, index_buffer, NULL, center_lon, center_lat, dlon, dlat);
-    else root_tile = NULL;
+#endif
+    }
 }
 
 
 H2D_grid_cell_search_engine::~H2D_grid_cell_search_engine()
 {
-    for (int i = 0; i < remap_grid->get_grid_size(); i ++)
-        delete cells[i];
+    delete [] cells_storage;
+    if (cells_vertex_lons != NULL) {
+        delete [] cells_vertex_lons;
+        delete [] cells_vertex_lats;
+    }
     delete [] cells;
     delete [] cells_ptr;
     delete [] cells_buffer;
     delete [] index_buffer;
     delete [] dist_buffer;
-    delete root_tile;
+    if (root_tile != NULL)
+        delete root_tile;
+    if (kd_tree != NULL)
+        delete kd_tree;
 }
 
 
@@ -653,6 +930,15 @@ void H2D_grid_cell_search_engine::recursively_search_initial_boundary(double cen
 
 
 void H2D_grid_cell_search_engine::search_nearest_points_var_number(int num_required_points, double dst_point_lon, double dst_point_lat, int &num_found_points, long *found_points_indx, double *found_points_dist, bool early_quit)
+{
+    search_nearest_points_var_number(num_required_points, dst_point_lon, dst_point_lat, num_found_points, found_points_indx, found_points_dist, early_quit, index_buffer, dist_buffer, dist_threshold);
+}
+
+
+/* The scratch arrays index_buffer and dist_buffer must have num_cells elements; dist_threshold is the adaptive search radius
+   that is carried from one query to the next */
+void H2D_grid_cell_search_engine::search_nearest_points_var_number(int num_required_points, double dst_point_lon, double dst_point_lat, int &num_found_points, long *found_points_indx, double *found_points_dist, bool early_quit,
+                                                                   long *index_buffer, double *dist_buffer, double &dist_threshold) const
 {
     bool have_the_same_point = false;
 
@@ -661,6 +947,21 @@ void H2D_grid_cell_search_engine::search_nearest_points_var_number(int num_requi
         num_required_points = remap_grid->get_grid_size();
     
     num_found_points = 0;
+
+    if (kd_tree != NULL) {
+        std::vector<int> nearest_cells;
+        int num_requested_cells = num_required_points;
+        /* As the tile search, keep widening until enough unmasked points are found or all cells have been considered */
+        while (true) {
+            kd_tree->search_nearest_cells(dst_point_lon, dst_point_lat, num_requested_cells, nearest_cells);
+            num_found_points = kd_tree_search_results_to_nearest_points(nearest_cells, -1.0, dst_point_lon, dst_point_lat, found_points_indx, found_points_dist, early_quit, index_buffer, dist_buffer);
+            if (num_found_points >= num_required_points || num_requested_cells >= num_cells || (early_quit && num_found_points == 1 && found_points_dist[0] == 0))
+                break;
+            num_requested_cells = num_requested_cells*2 < num_cells? num_requested_cells*2 : num_cells;
+        }
+        EXECUTION_REPORT(REPORT_ERROR, -1, num_found_points <= num_required_points, "Software error in H2D_grid_cell_search_engine::search_nearest_points_var_number: too many points found by the k-d tree");
+        return;
+    }
     
     while (num_found_points < num_required_points) {
         num_found_points = 0;
@@ -696,10 +997,17 @@ void H2D_grid_cell_search_engine::search_nearest_points_var_distance(double dist
     bool have_the_same_point;
 
 
-    EXECUTION_REPORT(REPORT_ERROR, root_tile != NULL, "Software error1 in H2D_grid_cell_search_engine::search_nearest_points_var_distance");
+    EXECUTION_REPORT(REPORT_ERROR, root_tile != NULL || kd_tree != NULL, "Software error1 in H2D_grid_cell_search_engine::search_nearest_points_var_distance");
     
     this->dist_threshold = dist_threshold;
     num_found_points = 0;
+
+    if (kd_tree != NULL) {
+        std::vector<int> candidate_cells;
+        kd_tree->search_cells_within_distance(dst_point_lon, dst_point_lat, dist_threshold, false, candidate_cells);
+        num_found_points = kd_tree_search_results_to_nearest_points(candidate_cells, dist_threshold, dst_point_lon, dst_point_lat, found_points_indx, found_points_dist, early_quit, index_buffer, dist_buffer);
+        return;
+    }
     have_the_same_point = root_tile->search_points_within_distance(dist_threshold, dst_point_lon, dst_point_lat, num_found_points, index_buffer, dist_buffer, early_quit);
 
     do_quick_sort(dist_buffer, index_buffer, 0, num_found_points-1);
@@ -720,11 +1028,70 @@ void H2D_grid_cell_search_engine::search_nearest_points_var_distance(double dist
 
 
 
+/* Turn the cells found by the k-d tree into the result of a nearest points search: the unmasked cells within dist_threshold
+   (when it is not negative) sorted by distance, or only the cell at the same location when early_quit is true */
+int H2D_grid_cell_search_engine::kd_tree_search_results_to_nearest_points(const std::vector<int> &found_cells, double dist_threshold, double dst_point_lon, double dst_point_lat, 
+                                                                          long *found_points_indx, double *found_points_dist, bool early_quit, long *index_buffer, double *dist_buffer) const
+{
+    int num_found_points = 0, same_point_indx = -1;
+    double distance;
+
+
+    for (int i = 0; i < found_cells.size(); i ++) {
+        const H2D_grid_cell_search_cell *cell = cells[found_cells[i]];
+        if (!cell->get_mask())
+            continue;
+        if (cell->get_center_lon() == dst_point_lon && cell->get_center_lat() == dst_point_lat) {
+            distance = 0;
+            if (same_point_indx == -1 || same_point_indx > found_cells[i])
+                same_point_indx = found_cells[i];
+        }
+        else distance = calculate_distance_of_two_points_2D(cell->get_center_lon(), cell->get_center_lat(), dst_point_lon, dst_point_lat, true);
+        if (dist_threshold >= 0 && distance > dist_threshold)
+            continue;
+        index_buffer[num_found_points] = found_cells[i];
+        dist_buffer[num_found_points] = distance;
+        num_found_points ++;
+    }
+
+    if (early_quit && same_point_indx != -1) {
+        found_points_indx[0] = same_point_indx;
+        found_points_dist[0] = 0;
+        return 1;
+    }
+
+    do_quick_sort(dist_buffer, index_buffer, 0, num_found_points-1);
+    for (int i = 0; i < num_found_points; i ++) {
+        found_points_indx[i] = index_buffer[i];
+        found_points_dist[i] = dist_buffer[i];
+    }
+
+    return num_found_points;
+}
+
+
 void H2D_grid_cell_search_engine::search_overlapping_cells(int &num_overlapping_cells, long *overlapping_cells_index, const H2D_grid_cell_search_cell *dst_cell, bool accurately_match, bool early_quit) const
 {
-    EXECUTION_REPORT(REPORT_ERROR, -1, root_tile != NULL, "Software error1 in H2D_grid_cell_search_engine::search_overlapping_cells");
+    EXECUTION_REPORT(REPORT_ERROR, -1, root_tile != NULL || kd_tree != NULL, "Software error1 in H2D_grid_cell_search_engine::search_overlapping_cells");
 
     num_overlapping_cells = 0;
+
+    /* With the k-d tree, all overlapping cells are found and the one with the smallest index is kept when early_quit is true */
+    if (kd_tree != NULL) {
+        std::vector<int> candidate_cells;
+        kd_tree->search_cells_within_distance(dst_cell->get_bounding_circle_center_lon(), dst_cell->get_bounding_circle_center_lat(), dst_cell->get_bounding_circle_radius(), true, candidate_cells);
+        for (int i = 0; i < candidate_cells.size(); i ++)
+            if (dst_cell->check_overlapping(cells[candidate_cells[i]], accurately_match)) {
+                if (early_quit && num_overlapping_cells > 0) {
+                    if (overlapping_cells_index[0] > candidate_cells[i])
+                        overlapping_cells_index[0] = candidate_cells[i];
+                }
+                else overlapping_cells_index[num_overlapping_cells++] = candidate_cells[i];
+            }
+        if (!early_quit)
+            do_quick_sort(overlapping_cells_index, (long*) NULL, 0, num_overlapping_cells-1);
+        return;
+    }
     root_tile->search_overlapping_cells(num_overlapping_cells, index_buffer, dst_cell, accurately_match, early_quit);
     
     if (early_quit)
@@ -786,12 +1153,95 @@ int H2D_grid_cell_search_engine::search_cell_of_locating_point(double point_lon,
     temp_cell = new H2D_grid_cell_search_cell(0, point_lon, point_lat, true, 0, NULL, NULL, EDGE_TYPE_LATLON);
 
     search_overlapping_cells(num_overlapping_cells, index_buffer, temp_cell, accurately_match, true);
+    delete temp_cell;
 
     if (num_overlapping_cells == 0)
         return -1;
     else return index_buffer[0];
-    
-    delete temp_cell;
+}
+
+
+/* Position of a point along a Hilbert curve over a 65536 x 65536 lon-lat raster, so that queries close to each other on the 
+   sphere are answered one after another and walk through the same branches of the search structure */
+static unsigned long long compute_hilbert_curve_position(double point_lon, double point_lat)
+{
+    unsigned long long position = 0;
+    unsigned int x, y, rx, ry, s, temp;
+
+
+    while (point_lon < 0)
+        point_lon += 360;
+    while (point_lon >= 360)
+        point_lon -= 360;
+    x = (unsigned int) (point_lon / 360.0 * 65535.0);
+    y = (unsigned int) ((std::min(std::max(point_lat, -90.0), 90.0) + 90.0) / 180.0 * 65535.0);
+    for (s = 65536/2; s > 0; s /= 2) {
+        rx = (x & s) > 0;
+        ry = (y & s) > 0;
+        position += ((unsigned long long) s) * ((unsigned long long) s) * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - (x & (s-1));
+                y = s - 1 - (y & (s-1));
+            }
+            temp = x;
+            x = y;
+            y = temp;
+        }
+    }
+
+    return position;
+}
+
+
+static void sort_points_along_hilbert_curve(int num_points, const double *points_lon, const double *points_lat, std::vector<int> &points_order)
+{
+    std::vector<std::pair<unsigned long long, int> > positions(num_points);
+
+
+    for (int i = 0; i < num_points; i ++)
+        positions[i] = std::make_pair(compute_hilbert_curve_position(points_lon[i], points_lat[i]), i);
+    std::sort(positions.begin(), positions.end());
+    points_order.resize(num_points);
+    for (int i = 0; i < num_points; i ++)
+        points_order[i] = positions[i].second;
+}
+
+
+/* Batched version of search_nearest_points_var_number: the results of point i are at found_points_indx+i*num_required_points
+   and found_points_dist+i*num_required_points. The points are visited along a Hilbert curve and are shared among OpenMP threads,
+   each of which owns its scratch arrays and adaptive search radius */
+void H2D_grid_cell_search_engine::search_nearest_points_var_number_batch(int num_points, const double *points_lon, const double *points_lat, int num_required_points, 
+                                                                         int *num_found_points, long *found_points_indx, double *found_points_dist, bool early_quit)
+{
+    std::vector<int> points_order;
+    double initial_dist_threshold = dist_threshold;
+
+
+    if (num_points <= 0)
+        return;
+
+    EXECUTION_REPORT(REPORT_ERROR, -1, root_tile != NULL || kd_tree != NULL, "Software error in H2D_grid_cell_search_engine::search_nearest_points_var_number_batch");
+    sort_points_along_hilbert_curve(num_points, points_lon, points_lat, points_order);
+
+#ifdef _OPENMP
+#pragma omp parallel if(num_points >= MIN_NUM_POINTS_PER_SEARCH_THREAD*2)
+#endif
+    {
+        long *thread_index_buffer = new long [num_cells];
+        double *thread_dist_buffer = new double [num_cells];
+        double thread_dist_threshold = initial_dist_threshold;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int i = 0; i < num_points; i ++) {
+            int j = points_order[i];
+            search_nearest_points_var_number(num_required_points, points_lon[j], points_lat[j], num_found_points[j], found_points_indx+((long)j)*num_required_points, 
+                                             found_points_dist+((long)j)*num_required_points, early_quit, thread_index_buffer, thread_dist_buffer, thread_dist_threshold);
+        }
+        delete [] thread_index_buffer;
+        delete [] thread_dist_buffer;
+    }
 }
 
 
@@ -807,7 +1257,7 @@ void H2D_grid_cell_search_engine::update(const bool *new_masks)
 
 const H2D_grid_cell_search_cell* H2D_grid_cell_search_engine::get_cell(int cell_index) const
 {
-        EXECUTION_REPORT(REPORT_ERROR, -1, root_tile == NULL, "Software error1 in H2D_grid_cell_search_engine::get_cell");
+        EXECUTION_REPORT(REPORT_ERROR, -1, root_tile == NULL && kd_tree == NULL, "Software error1 in H2D_grid_cell_search_engine::get_cell");
         EXECUTION_REPORT(REPORT_ERROR, -1, cell_index >= 0 && cell_index < remap_grid->get_grid_size(), "Software error2 in H2D_grid_cell_search_engine::get_cell");
         EXECUTION_REPORT(REPORT_ERROR, -1, cells[cell_index]->get_mask(), "Software error3 in H2D_grid_cell_search_engine::get_cell");
 
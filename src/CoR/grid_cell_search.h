@@ -10,10 +10,13 @@
 
 
 #include "remap_grid_class.h"
+#include <vector>
 
 
 #define TILE_DIVIDE_FACTOR         2
 #define MAX_NUM_CELLS_IN_TILE      8
+#define MAX_NUM_CELLS_IN_KD_LEAF   8
+#define MIN_NUM_POINTS_PER_SEARCH_THREAD   256
 
 #define EDGE_TYPE_LATLON           1
 #define EDGE_TYPE_GREAT_ARC        2
@@ -53,6 +56,7 @@ class H2D_grid_cell_search_cell
         double bounding_circle_radius;
         bool mask;
         int edge_type;   // 1: latlon edge; 2: great arc edge
+        bool own_vertex_buffers;
         H2D_grid_cell_cartesian_coord *cartesian_coord;
 
         bool check_overlapping_for_latlon_grid(const H2D_grid_cell_search_cell*) const;
@@ -63,8 +67,9 @@ class H2D_grid_cell_search_cell
 
     public:
         H2D_grid_cell_search_cell(int, double, double, bool, int, const double*, const double*, int);
-        H2D_grid_cell_search_cell() {}
+        H2D_grid_cell_search_cell() { vertex_lons = NULL; vertex_lats = NULL; own_vertex_buffers = false; cartesian_coord = NULL; }
         ~H2D_grid_cell_search_cell();
+        void initialize(int, double, double, bool, int, const double*, const double*, int, double*, double*);
         double get_center_lon() const { return center_lon; }
         double get_center_lat() const { return center_lat; }
         int get_num_vertex() const { return num_vertex; }
@@ -107,10 +112,48 @@ class H2D_grid_cell_search_tile
 };
 
 
+struct H2D_grid_cell_search_kd_node
+{
+    double bounding_box[6];          // min x, y, z and max x, y, z of the cell centers
+    double max_cell_reach;           // max arc distance from a cell center to the boundary of the cell's bounding circle
+    int cells_start;
+    int cells_end;
+    int children[2];
+};
+
+
+class H2D_grid_cell_search_kd_tree
+{
+    private:
+        const H2D_grid_cell_search_cell *cells;
+        std::vector<H2D_grid_cell_search_kd_node> nodes;
+        int num_cells;
+        int *cells_index;
+        double *centers_x;
+        double *centers_y;
+        double *centers_z;
+        double *cells_reach;
+
+        int build_node(int, int);
+        void search_nearest_cells_in_node(int, const double*, int, std::vector<std::pair<double,int> >&) const;
+        void search_cells_within_distance_in_node(int, const double*, double, bool, std::vector<int>&) const;
+
+    public:
+        H2D_grid_cell_search_kd_tree(const H2D_grid_cell_search_cell*, int, H2D_grid_cell_search_cell**);
+        ~H2D_grid_cell_search_kd_tree();
+        void search_nearest_cells(double, double, int, std::vector<int>&) const;
+        void search_cells_within_distance(double, double, double, bool, std::vector<int>&) const;
+};
+
+
 class H2D_grid_cell_search_engine
 {
     private:
         const Remap_grid_class *remap_grid;
+        H2D_grid_cell_search_cell *cells_storage;
+        double *cells_vertex_lons;
+        double *cells_vertex_lats;
+        H2D_grid_cell_search_kd_tree *kd_tree;
         H2D_grid_cell_search_cell **cells;
         H2D_grid_cell_search_cell **cells_ptr;
         H2D_grid_cell_search_cell **cells_buffer;
@@ -119,6 +162,9 @@ class H2D_grid_cell_search_engine
         H2D_grid_cell_search_tile *root_tile;
         double dist_threshold;
         int num_cells;
+
+        int kd_tree_search_results_to_nearest_points(const std::vector<int>&, double, double, double, long*, double*, bool, long*, double*) const;
+        void search_nearest_points_var_number(int, double, double, int&, long*, double *, bool, long*, double*, double&) const;
         
     public:
         H2D_grid_cell_search_engine(const Remap_grid_class*, const double*, const double*, const bool*, const bool*, int, const double*, const double*, int, bool);
@@ -128,6 +174,7 @@ class H2D_grid_cell_search_engine
         void search_nearest_points_var_distance(double, double, double, int&, long*, double*, bool);
         void search_overlapping_cells(int&, long*, const H2D_grid_cell_search_cell*, bool, bool) const;
         int search_cell_of_locating_point(double, double, bool) const;
+        void search_nearest_points_var_number_batch(int, const double*, const double*, int, int*, long*, double*, bool);
         const H2D_grid_cell_search_cell* get_cell(int) const;
         void update(const bool*);
 };
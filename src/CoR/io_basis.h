@@ -38,7 +38,7 @@ class IO_basis
         
     public:
         IO_basis(){}
-        ~IO_basis(){}
+        virtual ~IO_basis(){}
         bool match_IO_object(const char*);
         const char* get_file_name() { return file_name; }
         char *get_file_type() { return file_type; }
@@ -14,6 +14,38 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
+
+
+#ifdef USE_ASYNC_IO
+static pthread_mutex_t netcdf_access_mutex;
+static pthread_once_t netcdf_access_mutex_once = PTHREAD_ONCE_INIT;
+
+
+static void initialize_netcdf_access_mutex()
+{
+    pthread_mutexattr_t mutex_attr;
+
+
+    pthread_mutexattr_init(&mutex_attr);
+    pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&netcdf_access_mutex, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+}
+
+
+Netcdf_access_guard::Netcdf_access_guard()
+{
+    pthread_once(&netcdf_access_mutex_once, initialize_netcdf_access_mutex);
+    pthread_mutex_lock(&netcdf_access_mutex);
+}
+
+
+Netcdf_access_guard::~Netcdf_access_guard()
+{
+    pthread_mutex_unlock(&netcdf_access_mutex);
+}
+#endif
 
 
 IO_netcdf::IO_netcdf(int ncfile_id)
@@ -25,23 +57,36 @@ IO_netcdf::IO_netcdf(int ncfile_id)
     strcpy(this->open_format, "NULL");
     this->is_external_file = true;
     this->ncfile_id = ncfile_id;
+    this->session_opened = false;
+    this->file_opened_for_write = false;
+    this->in_define_mode = false;
+    this->time_record_cached = false;
 }
 
 
 IO_netcdf::IO_netcdf(const char *object_name, const char *file_name, const char *format, bool io_with_time_info)
 {
+    NETCDF_ACCESS_GUARD;
     this->io_with_time_info = io_with_time_info;
     strcpy(this->object_name, object_name);
     strcpy(this->file_type, FILE_TYPE_NETCDF);
     strcpy(this->file_name, file_name);
     strcpy(this->open_format, format);
     this->is_external_file = false;
+    this->session_opened = false;
+    this->file_opened_for_write = false;
+    this->in_define_mode = false;
+    this->time_record_cached = false;
     if (words_are_the_same(format, "r"))
         rcode = nc_open(file_name, NC_NOWRITE, &ncfile_id);
     else if (words_are_the_same(format, "w")) {
+#ifdef USE_PARALLEL_NETCDF
+        rcode = nc_create(file_name, NC_CLOBBER|NC_NETCDF4|NC_CLASSIC_MODEL, &ncfile_id);
+#else
         rcode = nc_create(file_name, NC_CLOBBER, &ncfile_id);
+#endif
         report_nc_error();
-        nc_enddef(ncfile_id);        
+        rcode = nc__enddef(ncfile_id, NETCDF_HEADER_FREE_SPACE, 4, 0, 4);
     }
     else EXECUTION_REPORT(REPORT_ERROR, -1, false, "the format of openning netcdf file must be read or write (\"r\" or \"w\")\n");
     report_nc_error();
@@ -53,6 +98,115 @@ IO_netcdf::IO_netcdf(const char *object_name, const char *file_name, const char
 
 IO_netcdf::~IO_netcdf()
 {
+    NETCDF_ACCESS_GUARD;
+    if (session_opened)
+        end_session();
+    for (int i = 0; i < predefined_field_names.size(); i ++)
+        delete [] predefined_field_names[i];
+}
+
+
+void IO_netcdf::open_file_for_write()
+{
+    if (file_opened_for_write)
+        return;
+
+    rcode = nc_open(file_name, NC_WRITE, &ncfile_id);
+    report_nc_error();
+    file_opened_for_write = true;
+    in_define_mode = false;
+}
+
+
+void IO_netcdf::close_file_for_write()
+{
+    if (session_opened || !file_opened_for_write)
+        return;
+
+    leave_define_mode();
+    rcode = nc_close(ncfile_id);
+    report_nc_error();
+    file_opened_for_write = false;
+}
+
+
+void IO_netcdf::enter_define_mode()
+{
+    if (in_define_mode)
+        return;
+
+    rcode = nc_redef(ncfile_id);
+    report_nc_error();
+    in_define_mode = true;
+}
+
+
+/* The header keeps NETCDF_HEADER_FREE_SPACE bytes of free space, so that the variables defined later
+   in a classic-format file do not move the data already written */
+void IO_netcdf::leave_define_mode()
+{
+    if (!in_define_mode)
+        return;
+
+    rcode = nc__enddef(ncfile_id, NETCDF_HEADER_FREE_SPACE, 4, 0, 4);
+    report_nc_error();
+    in_define_mode = false;
+}
+
+
+/* Within a session, the file is opened only once, and a define phase is left only when data must be
+   accessed, so that the variables of all fields can be defined in one define phase before their data
+   is written */
+void IO_netcdf::begin_session()
+{
+    NETCDF_ACCESS_GUARD;
+    EXECUTION_REPORT(REPORT_ERROR, -1, words_are_the_same(open_format, "w") && !is_external_file, "Software error in IO_netcdf::begin_session: netcdf file \"%s\" is not opened for writing", file_name);
+    if (session_opened)
+        return;
+
+    session_opened = true;
+    time_record_cached = false;
+}
+
+
+void IO_netcdf::flush_session()
+{
+    NETCDF_ACCESS_GUARD;
+    if (!file_opened_for_write)
+        return;
+
+    leave_define_mode();
+    rcode = nc_close(ncfile_id);
+    report_nc_error();
+    file_opened_for_write = false;
+}
+
+
+void IO_netcdf::end_session()
+{
+    NETCDF_ACCESS_GUARD;
+    flush_session();
+    session_opened = false;
+    time_record_cached = false;
+    for (int i = 0; i < predefined_field_names.size(); i ++)
+        delete [] predefined_field_names[i];
+    predefined_field_names.clear();
+}
+
+
+bool IO_netcdf::is_predefined_field(const char *field_IO_name, bool remove)
+{
+    NETCDF_ACCESS_GUARD;
+    for (int i = 0; i < predefined_field_names.size(); i ++)
+        if (words_are_the_same(predefined_field_names[i], field_IO_name)) {
+            if (remove) {
+                delete [] predefined_field_names[i];
+                predefined_field_names.erase(predefined_field_names.begin()+i);
+            }
+            return true;
+        }
+
+    return false;
 }
 
 
@@ -110,6 +264,7 @@ void IO_netcdf::datatype_from_application_to_netcdf(const char *application_data
 
 bool IO_netcdf::read_data(Remap_data_field *read_data_field, int time_pos, bool check_existence)
 {
+    NETCDF_ACCESS_GUARD;
     int i, num_attributes, num_dimensions, variable_id, dimension_ids[256];
     char variable_name[256];
     nc_type nc_data_type;
@@ -271,6 +426,7 @@ bool IO_netcdf::read_data(Remap_data_field *read_data_field, int time_pos, bool
 
 void IO_netcdf::write_grid(Remap_grid_class *associated_grid, bool write_grid_name, bool use_script_format)
 {
+    NETCDF_ACCESS_GUARD;
     int num_sized_sub_grids, num_leaf_grids, num_masked_sub_grids, num_sphere_leaf_grids, i, dim_ncid;
     Remap_grid_class *sized_sub_grids[256], *leaf_grids[256], *masked_sub_grids[256];
     Remap_grid_data_class *grid_data_field;
@@ -280,11 +436,7 @@ void IO_netcdf::write_grid(Remap_grid_class *associated_grid, bool write_grid_na
     if (associated_grid == NULL)
         return;
 
-    rcode = nc_open(file_name, NC_WRITE, &ncfile_id);
-    report_nc_error();
-
-    rcode = nc_redef(ncfile_id);
-    report_nc_error();
+    open_file_for_write();
     associated_grid->get_sized_sub_grids(&num_sized_sub_grids, sized_sub_grids);
     for (i = 0; i < num_sized_sub_grids; i ++)
         if (sized_grids_map.find(sized_sub_grids[i]) == sized_grids_map.end()) {
@@ -298,6 +450,7 @@ void IO_netcdf::write_grid(Remap_grid_class *associated_grid, bool write_grid_na
             else if (sized_sub_grids[i]->get_num_dimensions() == 1)
                 sprintf(tmp_string, "%s", sized_sub_grids[i]->get_coord_label()); 
             else sprintf(tmp_string, "grid_size", sized_sub_grids[i]->get_grid_name()); 
+            enter_define_mode();
             rcode = nc_def_dim(ncfile_id, tmp_string, sized_sub_grids[i]->get_grid_size(), &dim_ncid);
             EXECUTION_REPORT_LOG(REPORT_LOG, -1, true, "define dim %s for grid \"%s\" (%lx) in ncfile %s", tmp_string, sized_sub_grids[i]->get_grid_name(), sized_sub_grids[i], file_name);
             report_nc_error();
@@ -305,6 +458,7 @@ void IO_netcdf::write_grid(Remap_grid_class *associated_grid, bool write_grid_na
             recorded_grids.push_back(sized_sub_grids[i]);
         }
     if (use_script_format) {
+        enter_define_mode();
         if (sized_grids_map.find(associated_grid) == sized_grids_map.end()) {
             rcode = nc_def_dim(ncfile_id, "grid_size", associated_grid->get_grid_size(), &dim_ncid);
             report_nc_error();
@@ -318,15 +472,10 @@ void IO_netcdf::write_grid(Remap_grid_class *associated_grid, bool write_grid_na
             grid_dim_size[i] = sized_sub_grids[i]->get_grid_size();
         rcode = nc_def_var(ncfile_id, "grid_dims", NC_INT, 1, &dim_ncid, &dims_ncid);
         report_nc_error();
-        rcode = nc_enddef(ncfile_id);
-        report_nc_error();
+        leave_define_mode();
         nc_put_var_int(ncfile_id, dims_ncid, grid_dim_size);
         report_nc_error();
-        rcode = nc_redef(ncfile_id);
-        report_nc_error();
     }
-    nc_enddef(ncfile_id);
-    report_nc_error();
 
     associated_grid->get_leaf_grids(&num_leaf_grids, leaf_grids, associated_grid);
     for (i = 0; i < num_leaf_grids; i ++) {
@@ -342,12 +491,9 @@ void IO_netcdf::write_grid(Remap_grid_class *associated_grid, bool write_grid_na
             if (write_grid_name)
                 sprintf(tmp_string, "grid_%d_P0", get_recorded_grid_num(leaf_grids[i]));
             double P0 = leaf_grids[i]->get_sigma_grid_top_value();            
-            rcode = nc_redef(ncfile_id);
-            report_nc_error();
+            enter_define_mode();
             rcode = nc_put_att_double(ncfile_id, NC_GLOBAL, tmp_string, NC_DOUBLE, 1, &P0);
             report_nc_error();
-            nc_enddef(ncfile_id);
-            report_nc_error();
         }
         grid_data_field = leaf_grids[i]->get_grid_vertex_field();
         if (grid_data_field != NULL && !grid_data_field->get_coord_value_grid()->get_are_vertex_values_set_in_default()) {
@@ -358,10 +504,8 @@ void IO_netcdf::write_grid(Remap_grid_class *associated_grid, bool write_grid_na
             else sprintf(tmp_string, "num_vertexes_H2D");
             rcode = nc_inq_dimid(ncfile_id, tmp_string, &dim_ncid);            
             if (rcode == NC_EBADDIM) {
-                rcode = nc_redef(ncfile_id);
-                report_nc_error();
+                enter_define_mode();
                 rcode = nc_def_dim(ncfile_id, tmp_string, grid_data_field->get_coord_value_grid()->get_num_vertexes(), &dim_ncid);
-                nc_enddef(ncfile_id);
                 report_nc_error();
             }
             write_field_data(grid_data_field, associated_grid, true, GRID_VERTEX_LABEL, dim_ncid, write_grid_name, use_script_format);            
@@ -374,8 +518,7 @@ void IO_netcdf::write_grid(Remap_grid_class *associated_grid, bool write_grid_na
     if (associated_grid->get_grid_imported_area() != NULL)
         write_field_data(associated_grid->get_grid_imported_area(), associated_grid, true, "area", -1, write_grid_name, use_script_format);
 
-    rcode = nc_close(ncfile_id);
-    report_nc_error();
+    close_file_for_write();
 }
 
 
@@ -386,6 +529,21 @@ void IO_netcdf::write_field_data(Remap_grid_data_class *field_data,
                                 int dim_ncid_num_vertex,
                                 bool write_grid_name,
                                 bool use_script_format)
+{
+    write_field_data(field_data, interchange_grid, is_grid_data, grid_field_type, dim_ncid_num_vertex, write_grid_name, use_script_format, false);
+}
+
+
+/* When is_prepared_data is true, the missing values and the order of the data have already been set by
+   prepare_grided_data_for_async_IO, so that neither the field data nor the grid masks are changed here */
+void IO_netcdf::write_field_data(Remap_grid_data_class *field_data, 
+                                Remap_grid_class *interchange_grid,
+                                bool is_grid_data, 
+                                const char *grid_field_type, 
+                                int dim_ncid_num_vertex,
+                                bool write_grid_name,
+                                bool use_script_format,
+                                bool is_prepared_data)
 {
     int num_sized_sub_grids, num_dims, i;
     unsigned long io_data_size, dimension_size;
@@ -396,7 +554,7 @@ void IO_netcdf::write_field_data(Remap_grid_data_class *field_data,
     nc_type nc_data_type;
 
 
-    if (!is_grid_data)
+    if (!is_grid_data && !is_prepared_data)
         field_data->set_masked_cell_to_missing_value();
 
     tmp_string[0] = '\0';
@@ -438,13 +596,15 @@ void IO_netcdf::write_field_data(Remap_grid_data_class *field_data,
     if (rcode != NC_ENOTVAR) {
         if (is_grid_data)
             return;
-        else EXECUTION_REPORT(REPORT_WARNING, -1, io_with_time_info,
+        else if (!is_predefined_field(tmp_string, true))
+            EXECUTION_REPORT(REPORT_WARNING, -1, io_with_time_info,
                             "field data \"%s\" has been written to netcdf file \"%s\" before. The old data will be overwritten\n",
                             field_data->get_grid_data_field()->field_name_in_application, file_name);
     }
 
     if (interchange_grid != NULL) {
-        field_data->interchange_grid_data(interchange_grid);        
+        if (!is_prepared_data)
+            field_data->interchange_grid_data(interchange_grid);        
         if (sized_grids_map.find(field_data->get_coord_value_grid()) != sized_grids_map.end()) {
             num_sized_sub_grids = 1;
             sized_sub_grids[0] = field_data->get_coord_value_grid();
@@ -486,43 +646,13 @@ void IO_netcdf::write_field_data(Remap_grid_data_class *field_data,
 
     rcode = nc_inq_varid(ncfile_id, tmp_string, &var_ncid);
     if (rcode == NC_ENOTVAR) {
-        rcode = nc_redef(ncfile_id);
-        report_nc_error();
+        enter_define_mode();
         datatype_from_application_to_netcdf(field_data->get_grid_data_field()->data_type_in_IO_file, &nc_data_type);
         rcode = nc_def_var(ncfile_id, tmp_string, nc_data_type, num_dims, dim_ncids, &var_ncid);
         report_nc_error();
-        for (i = 0; i < field_data->get_grid_data_field()->field_attributes.size(); i ++) {
-            datatype_from_application_to_netcdf(field_data->get_grid_data_field()->field_attributes[i].attribute_type, &nc_data_type);
-            switch (nc_data_type) {
-                case NC_BYTE:
-                case NC_CHAR:
-                    rcode = nc_put_att_text(ncfile_id, var_ncid, field_data->get_grid_data_field()->field_attributes[i].attribute_name,
-                                            field_data->get_grid_data_field()->field_attributes[i].attribute_size, field_data->get_grid_data_field()->field_attributes[i].attribute_value);
-                    break;
-                case NC_SHORT:
-                    rcode = nc_put_att_short(ncfile_id, var_ncid, field_data->get_grid_data_field()->field_attributes[i].attribute_name, nc_data_type,
-                                             field_data->get_grid_data_field()->field_attributes[i].attribute_size, (short*)field_data->get_grid_data_field()->field_attributes[i].attribute_value);
-                    break;
-                case NC_INT:
-                    rcode = nc_put_att_int(ncfile_id, var_ncid, field_data->get_grid_data_field()->field_attributes[i].attribute_name, nc_data_type,
-                                             field_data->get_grid_data_field()->field_attributes[i].attribute_size, (int*)field_data->get_grid_data_field()->field_attributes[i].attribute_value);
-                    break;
-                case NC_FLOAT:
-                    rcode = nc_put_att_float(ncfile_id, var_ncid, field_data->get_grid_data_field()->field_attributes[i].attribute_name, nc_data_type,
-                                             field_data->get_grid_data_field()->field_attributes[i].attribute_size, (float*)field_data->get_grid_data_field()->field_attributes[i].attribute_value);
-                    break;
-                case NC_DOUBLE:
-                    rcode = nc_put_att_double(ncfile_id, var_ncid, field_data->get_grid_data_field()->field_attributes[i].attribute_name, nc_data_type,
-                                             field_data->get_grid_data_field()->field_attributes[i].attribute_size, (double*)field_data->get_grid_data_field()->field_attributes[i].attribute_value);
-                    break;
-                default:
-                    EXECUTION_REPORT(REPORT_ERROR, -1, false, "remap software error2 in write_field_data\n");
-            }
-            report_nc_error();
-        }
-        nc_enddef(ncfile_id);
-        report_nc_error();
+        put_field_attributes(var_ncid, field_data->get_grid_data_field());
     }
+    leave_define_mode();
 
     if (words_are_the_same(field_data->get_grid_data_field()->data_type_in_application, DATA_TYPE_BOOL)) {
         int *temp_buffer = new int [field_data->get_grid_data_field()->required_data_size];
@@ -548,83 +678,130 @@ void IO_netcdf::write_field_data(Remap_grid_data_class *field_data,
 }
 
 
-void IO_netcdf::write_grided_data(Remap_grid_data_class *grided_data, bool write_grid_name, int date, int datesec, bool is_restart_field)
+void IO_netcdf::put_field_attributes(int var_ncid, Remap_data_field *data_field)
+{
+    nc_type nc_data_type;
+
+
+    for (int i = 0; i < data_field->field_attributes.size(); i ++) {
+        datatype_from_application_to_netcdf(data_field->field_attributes[i].attribute_type, &nc_data_type);
+        switch (nc_data_type) {
+            case NC_BYTE:
+            case NC_CHAR:
+                rcode = nc_put_att_text(ncfile_id, var_ncid, data_field->field_attributes[i].attribute_name,
+                                        data_field->field_attributes[i].attribute_size, data_field->field_attributes[i].attribute_value);
+                break;
+            case NC_SHORT:
+                rcode = nc_put_att_short(ncfile_id, var_ncid, data_field->field_attributes[i].attribute_name, nc_data_type,
+                                         data_field->field_attributes[i].attribute_size, (short*)data_field->field_attributes[i].attribute_value);
+                break;
+            case NC_INT:
+                rcode = nc_put_att_int(ncfile_id, var_ncid, data_field->field_attributes[i].attribute_name, nc_data_type,
+                                         data_field->field_attributes[i].attribute_size, (int*)data_field->field_attributes[i].attribute_value);
+                break;
+            case NC_FLOAT:
+                rcode = nc_put_att_float(ncfile_id, var_ncid, data_field->field_attributes[i].attribute_name, nc_data_type,
+                                         data_field->field_attributes[i].attribute_size, (float*)data_field->field_attributes[i].attribute_value);
+                break;
+            case NC_DOUBLE:
+                rcode = nc_put_att_double(ncfile_id, var_ncid, data_field->field_attributes[i].attribute_name, nc_data_type,
+                                         data_field->field_attributes[i].attribute_size, (double*)data_field->field_attributes[i].attribute_value);
+                break;
+            default:
+                EXECUTION_REPORT(REPORT_ERROR, -1, false, "remap software error2 in write_field_data\n");
+        }
+        report_nc_error();
+    }
+}
+
+
+void IO_netcdf::write_time_record(int date, int datesec)
 {
     unsigned long starts, counts, dim_len;
     int current_date, current_datesec;
-    int time_var_id, date_var_id, datesec_var_id, tmp_var_id;;
-    Remap_grid_data_class *tmp_field_data_for_io;
+    int time_var_id, date_var_id, datesec_var_id;
 
 
-    if (execution_phase_number == 0)
+    if (!io_with_time_info) {
+        EXECUTION_REPORT(REPORT_ERROR, -1, date == -1 && datesec == -1, "remap software error in write_grided_data \n");
+        return;
+    }
+    if (time_record_cached && cached_record_date == date && cached_record_datesec == datesec)
         return;
-    
-    rcode = nc_open(file_name, NC_WRITE, &ncfile_id);
-    report_nc_error();
 
-    if (!io_with_time_info)
-        EXECUTION_REPORT(REPORT_ERROR, -1, date == -1 && datesec == -1, "remap software error in write_grided_data \n");
+    open_file_for_write();
+    EXECUTION_REPORT(REPORT_ERROR, -1, date > 0 && datesec >= 0, "remap software error in write_grided_data \n");
+    rcode = nc_inq_dimid(ncfile_id, "time", &time_dim_id); 
+    if (rcode == NC_EBADDIM) {
+        enter_define_mode();
+        rcode = nc_def_dim(ncfile_id, "time", NC_UNLIMITED, &time_dim_id);
+        report_nc_error();
+        rcode = nc_def_var(ncfile_id, "time", NC_INT, 1, &time_dim_id, &time_var_id);
+        report_nc_error();
+        rcode = nc_def_var(ncfile_id, "date", NC_INT, 1, &time_dim_id, &date_var_id);
+        report_nc_error();
+        rcode = nc_def_var(ncfile_id, "datesec", NC_INT, 1, &time_dim_id, &datesec_var_id);
+        report_nc_error();
+        leave_define_mode();
+        time_count = 0;
+        current_date = -1;
+        current_datesec = -1;
+    }
     else {
-        EXECUTION_REPORT(REPORT_ERROR, -1, date > 0 && datesec >= 0, "remap software error in write_grided_data \n");
-        rcode = nc_inq_dimid(ncfile_id, "time", &time_dim_id); 
-        if (rcode == NC_EBADDIM) {
-            rcode = nc_redef(ncfile_id);
-            report_nc_error();
-            rcode = nc_def_dim(ncfile_id, "time", NC_UNLIMITED, &time_dim_id);
-            report_nc_error();
-            rcode = nc_def_var(ncfile_id, "time", NC_INT, 1, &time_dim_id, &time_var_id);
-            report_nc_error();
-            rcode = nc_def_var(ncfile_id, "date", NC_INT, 1, &time_dim_id, &date_var_id);
-            report_nc_error();
-            rcode = nc_def_var(ncfile_id, "datesec", NC_INT, 1, &time_dim_id, &datesec_var_id);
-            report_nc_error();
-            nc_enddef(ncfile_id);
-            report_nc_error();
-            time_count = 0;
-            current_date = -1;
-            current_datesec = -1;
-        }
-        else {
-            rcode = nc_inq_dimlen(ncfile_id, time_dim_id, &dim_len);
-            time_count = dim_len;
-            report_nc_error();
-            starts = time_count - 1;
-            counts = 1;
-            rcode = nc_inq_varid(ncfile_id, "date", &date_var_id);
-            report_nc_error();
-            rcode = nc_get_vara_int(ncfile_id, date_var_id, &starts, &counts, &current_date);
-            report_nc_error();
-            rcode = nc_inq_varid(ncfile_id, "datesec", &datesec_var_id);
-            report_nc_error();
-            rcode = nc_get_vara_int(ncfile_id, datesec_var_id, &starts, &counts, &current_datesec);
-            report_nc_error();
-        }
-        if (current_date != date || current_datesec != datesec) {
-            time_count ++;
-            starts = time_count - 1;
-            counts = 1;
-            rcode = nc_inq_varid(ncfile_id, "time", &time_var_id);  
-            report_nc_error();
-            rcode = nc_put_vara_int(ncfile_id, time_var_id, &starts, &counts, &time_count);   
-            report_nc_error();
-            rcode = nc_inq_varid(ncfile_id, "date", &date_var_id);  
-            report_nc_error();
-            rcode = nc_put_vara_int(ncfile_id, date_var_id, &starts, &counts, &date);   
-            report_nc_error();
-            rcode = nc_inq_varid(ncfile_id, "datesec", &datesec_var_id);  
-            report_nc_error();
-            rcode = nc_put_vara_int(ncfile_id, datesec_var_id, &starts, &counts, &datesec);   
-            report_nc_error();
-        }
+        leave_define_mode();
+        rcode = nc_inq_dimlen(ncfile_id, time_dim_id, &dim_len);
+        time_count = dim_len;
+        report_nc_error();
+        starts = time_count - 1;
+        counts = 1;
+        rcode = nc_inq_varid(ncfile_id, "date", &date_var_id);
+        report_nc_error();
+        rcode = nc_get_vara_int(ncfile_id, date_var_id, &starts, &counts, &current_date);
+        report_nc_error();
+        rcode = nc_inq_varid(ncfile_id, "datesec", &datesec_var_id);
+        report_nc_error();
+        rcode = nc_get_vara_int(ncfile_id, datesec_var_id, &starts, &counts, &current_datesec);
+        report_nc_error();
     }
+    if (current_date != date || current_datesec != datesec) {
+        time_count ++;
+        starts = time_count - 1;
+        counts = 1;
+        rcode = nc_inq_varid(ncfile_id, "time", &time_var_id);  
+        report_nc_error();
+        rcode = nc_put_vara_int(ncfile_id, time_var_id, &starts, &counts, &time_count);   
+        report_nc_error();
+        rcode = nc_inq_varid(ncfile_id, "date", &date_var_id);  
+        report_nc_error();
+        rcode = nc_put_vara_int(ncfile_id, date_var_id, &starts, &counts, &date);   
+        report_nc_error();
+        rcode = nc_inq_varid(ncfile_id, "datesec", &datesec_var_id);  
+        report_nc_error();
+        rcode = nc_put_vara_int(ncfile_id, datesec_var_id, &starts, &counts, &datesec);   
+        report_nc_error();
+    }
+    time_record_cached = session_opened;
+    cached_record_date = date;
+    cached_record_datesec = datesec;
 
-    rcode = nc_close(ncfile_id);
-    report_nc_error();
+    close_file_for_write();
+}
+
+
+void IO_netcdf::write_grided_data(Remap_grid_data_class *grided_data, bool write_grid_name, int date, int datesec, bool is_restart_field)
+{
+    NETCDF_ACCESS_GUARD;
+    Remap_grid_data_class *tmp_field_data_for_io;
+
+
+    if (execution_phase_number == 0)
+        return;
+
+    write_time_record(date, datesec);
 
     write_grid(grided_data->get_coord_value_grid(), write_grid_name, false);
 
-    rcode = nc_open(file_name, NC_WRITE, &ncfile_id);
-    report_nc_error();
+    open_file_for_write();
 
     if (strlen(grided_data->get_grid_data_field()->data_type_in_IO_file) == 0)
         strcpy(grided_data->get_grid_data_field()->data_type_in_IO_file, grided_data->get_grid_data_field()->data_type_in_application);
@@ -633,13 +810,221 @@ void IO_netcdf::write_grided_data(Remap_grid_data_class *grided_data, bool write
     if (tmp_field_data_for_io != grided_data)
         delete tmp_field_data_for_io;
 
+    close_file_for_write();
+}
+
+
+/* Called by the model thread before a field is handed to the background IO thread (USE_ASYNC_IO). The grid is
+   written into the file the first time, and the returned copy of the field data is ready for writing, so that the
+   background IO thread never changes the grids, the grid masks or the field of the model */
+Remap_grid_data_class *IO_netcdf::prepare_grided_data_for_async_IO(Remap_grid_data_class *grided_data, bool write_grid_name, bool is_restart_field)
+{
+    Remap_grid_class *grid = grided_data->get_coord_value_grid();
+    Remap_grid_data_class *field_data_for_io;
+    int i;
+
+
+    EXECUTION_REPORT(REPORT_ERROR, -1, grid != NULL, "Software error in IO_netcdf::prepare_grided_data_for_async_IO");
+    if (execution_phase_number != 0) {
+        for (i = 0; i < grids_written_before_async_IO.size(); i ++)
+            if (grids_written_before_async_IO[i] == grid)
+                break;
+        if (i == grids_written_before_async_IO.size()) {
+            write_grid(grid, write_grid_name, false);
+            grids_written_before_async_IO.push_back(grid);
+        }
+    }
+
+    if (strlen(grided_data->get_grid_data_field()->data_type_in_IO_file) == 0)
+        strcpy(grided_data->get_grid_data_field()->data_type_in_IO_file, grided_data->get_grid_data_field()->data_type_in_application);
+    field_data_for_io = generate_field_data_for_IO(grided_data, is_restart_field);
+    field_data_for_io->set_masked_cell_to_missing_value();
+    field_data_for_io->interchange_grid_data(grid);
+
+    return field_data_for_io;
+}
+
+
+/* Called by the background IO thread with the field data returned by prepare_grided_data_for_async_IO */
+void IO_netcdf::write_prepared_grided_data(Remap_grid_data_class *field_data_for_io, bool write_grid_name, int date, int datesec)
+{
+    NETCDF_ACCESS_GUARD;
+
+
+    if (execution_phase_number == 0)
+        return;
+
+    write_time_record(date, datesec);
+    open_file_for_write();
+    write_field_data(field_data_for_io, field_data_for_io->get_coord_value_grid(), false, "", -1, write_grid_name, false, true);
+    close_file_for_write();
+}
+
+
+void IO_netcdf::define_field_variable(Remap_data_field *data_field, Remap_grid_class *grid, const char *field_IO_name, const char *data_type, bool write_grid_name, int date, int datesec)
+{
+    NETCDF_ACCESS_GUARD;
+    int num_sized_sub_grids, num_dims = 0, var_ncid, dim_ncids[256];
+    Remap_grid_class *sized_sub_grids[256];
+    nc_type nc_data_type;
+
+
+    if (execution_phase_number == 0)
+        return;
+
+    write_time_record(date, datesec);
+    write_grid(grid, write_grid_name, false);
+
+    open_file_for_write();
+    if (grid == NULL)
+        num_sized_sub_grids = 0;
+    else if (sized_grids_map.find(grid) != sized_grids_map.end()) {
+        num_sized_sub_grids = 1;
+        sized_sub_grids[0] = grid;
+    }
+    else grid->get_sized_sub_grids(&num_sized_sub_grids, sized_sub_grids);
+    if (io_with_time_info)
+        dim_ncids[num_dims++] = time_dim_id;
+    for (int i = num_sized_sub_grids-1; i >= 0; i --) {
+        EXECUTION_REPORT(REPORT_ERROR, -1, sized_grids_map.find(sized_sub_grids[i]) != sized_grids_map.end(), "remap software error1 in define_field_variable\n");
+        dim_ncids[num_dims++] = sized_grids_map[sized_sub_grids[i]];
+    }
+
+    rcode = nc_inq_varid(ncfile_id, field_IO_name, &var_ncid);
+    if (rcode == NC_ENOTVAR) {
+        enter_define_mode();
+        datatype_from_application_to_netcdf(data_type, &nc_data_type);
+        rcode = nc_def_var(ncfile_id, field_IO_name, nc_data_type, num_dims, dim_ncids, &var_ncid);
+        report_nc_error();
+        put_field_attributes(var_ncid, data_field);
+        char *predefined_field_name = new char [strlen(field_IO_name)+1];
+        strcpy(predefined_field_name, field_IO_name);
+        predefined_field_names.push_back(predefined_field_name);
+    }
+    else if (!is_predefined_field(field_IO_name, false))
+        EXECUTION_REPORT(REPORT_WARNING, -1, io_with_time_info, "field data \"%s\" has been written to netcdf file \"%s\" before. The old data will be overwritten\n", field_IO_name, file_name);
+
+    close_file_for_write();
+}
+
+
+#ifdef USE_PARALLEL_NETCDF
+bool IO_netcdf::access_field_data_block(const char *file_name, const char *field_IO_name, const char *data_type, int time_pos, long block_start, long block_size, void *data_buf, MPI_Comm IO_comm, bool is_write)
+{
+    NETCDF_ACCESS_GUARD;
+    int ncfile_id, var_ncid, time_dim_id, num_dims, dim_ncids[256], num_slabs, max_num_slabs, i, j;
+    size_t dim_sizes[256], starts[256], counts[256];
+    long strides[256], block_end, total_size, current_pos, num_rows;
+    std::vector<size_t> slab_starts, slab_counts;
+    int data_type_size = get_data_type_size(data_type);
+    int rcode;
+
+
+    if (is_write)
+        rcode = nc_open_par(file_name, NC_WRITE|NC_MPIIO, IO_comm, MPI_INFO_NULL, &ncfile_id);
+    else rcode = nc_open_par(file_name, NC_NOWRITE|NC_MPIIO, IO_comm, MPI_INFO_NULL, &ncfile_id);
+    EXECUTION_REPORT(REPORT_ERROR, -1, rcode == NC_NOERR, "Netcdf error: %s for file %s\n", nc_strerror(rcode), file_name);
+    rcode = nc_inq_varid(ncfile_id, field_IO_name, &var_ncid);
+    if (rcode == NC_ENOTVAR) {
+        nc_close(ncfile_id);
+        return false;
+    }
+    EXECUTION_REPORT(REPORT_ERROR, -1, rcode == NC_NOERR, "Netcdf error: %s for file %s\n", nc_strerror(rcode), file_name);
+    rcode = nc_var_par_access(ncfile_id, var_ncid, NC_COLLECTIVE);
+    EXECUTION_REPORT(REPORT_ERROR, -1, rcode == NC_NOERR, "Netcdf error: %s for file %s\n", nc_strerror(rcode), file_name);
+
+    nc_inq_varndims(ncfile_id, var_ncid, &num_dims);
+    nc_inq_vardimid(ncfile_id, var_ncid, dim_ncids);
+    for (i = 0; i < num_dims; i ++)
+        nc_inq_dimlen(ncfile_id, dim_ncids[i], &dim_sizes[i]);
+
+    /* the leading unlimited time dimension selects one record: the latest one for writing and the given one for reading */
+    int first_data_dim = 0;
+    if (nc_inq_dimid(ncfile_id, "time", &time_dim_id) == NC_NOERR && num_dims > 0 && dim_ncids[0] == time_dim_id) {
+        if (is_write)
+            time_pos = dim_sizes[0] - 1;
+        EXECUTION_REPORT(REPORT_ERROR, -1, time_pos >= 0 && time_pos < dim_sizes[0], "C-Coupler error in IO_netcdf::access_field_data_block");
+        first_data_dim = 1;
+    }
+    EXECUTION_REPORT(REPORT_ERROR, -1, num_dims > first_data_dim, "C-Coupler error in IO_netcdf::access_field_data_block: variable \"%s\" in netcdf file \"%s\" has no spatial dimension", field_IO_name, file_name);
+    for (i = num_dims-1, total_size = 1; i >= first_data_dim; i --) {
+        strides[i] = total_size;
+        total_size *= dim_sizes[i];
+    }
+    EXECUTION_REPORT(REPORT_ERROR, -1, block_start >= 0 && block_start + block_size <= total_size, "the data size of field \"%s\" in netcdf file \"%s\" is different from the data size of the field determined by grid", field_IO_name, file_name);
+
+    /* split the contiguous block into hyperslabs: each one fills the remaining rows of the outermost dimension that is aligned with the current position */
+    block_end = block_start + block_size;
+    for (current_pos = block_start; current_pos < block_end; current_pos += num_rows*strides[j]) {
+        for (j = first_data_dim; j < num_dims-1; j ++)
+            if (current_pos % strides[j] == 0 && current_pos + strides[j] <= block_end)
+                break;
+        num_rows = (block_end-current_pos) / strides[j];
+        if (num_rows > dim_sizes[j] - (current_pos/strides[j])%dim_sizes[j])
+            num_rows = dim_sizes[j] - (current_pos/strides[j])%dim_sizes[j];
+        for (i = 0; i < num_dims; i ++) {
+            if (i < first_data_dim) {
+                slab_starts.push_back(time_pos);
+                slab_counts.push_back(1);
+            }
+            else if (i < j) {
+                slab_starts.push_back((current_pos/strides[i])%dim_sizes[i]);
+                slab_counts.push_back(1);
+            }
+            else if (i == j) {
+                slab_starts.push_back((current_pos/strides[i])%dim_sizes[i]);
+                slab_counts.push_back(num_rows);
+            }
+            else {
+                slab_starts.push_back(0);
+                slab_counts.push_back(dim_sizes[i]);
+            }
+        }
+    }
+
+    /* collective access requires all processes to make the same number of calls */
+    num_slabs = slab_starts.size() / num_dims;
+    MPI_Allreduce(&num_slabs, &max_num_slabs, 1, MPI_INT, MPI_MAX, IO_comm);
+    char *current_buf = (char*) data_buf;
+    for (i = 0; i < max_num_slabs; i ++) {
+        long slab_size = 1;
+        for (j = 0; j < num_dims; j ++) {
+            if (i < num_slabs) {
+                starts[j] = slab_starts[i*num_dims+j];
+                counts[j] = slab_counts[i*num_dims+j];
+            }
+            else {
+                starts[j] = 0;
+                counts[j] = 0;
+            }
+            slab_size *= counts[j];
+        }
+        if (i >= num_slabs)
+            slab_size = 0;
+        if (words_are_the_same(data_type, DATA_TYPE_DOUBLE))
+            rcode = is_write? nc_put_vara_double(ncfile_id, var_ncid, starts, counts, (double*) current_buf) : nc_get_vara_double(ncfile_id, var_ncid, starts, counts, (double*) current_buf);
+        else if (words_are_the_same(data_type, DATA_TYPE_FLOAT))
+            rcode = is_write? nc_put_vara_float(ncfile_id, var_ncid, starts, counts, (float*) current_buf) : nc_get_vara_float(ncfile_id, var_ncid, starts, counts, (float*) current_buf);
+        else if (words_are_the_same(data_type, DATA_TYPE_INT))
+            rcode = is_write? nc_put_vara_int(ncfile_id, var_ncid, starts, counts, (int*) current_buf) : nc_get_vara_int(ncfile_id, var_ncid, starts, counts, (int*) current_buf);
+        else if (words_are_the_same(data_type, DATA_TYPE_SHORT))
+            rcode = is_write? nc_put_vara_short(ncfile_id, var_ncid, starts, counts, (short*) current_buf) : nc_get_vara_short(ncfile_id, var_ncid, starts, counts, (short*) current_buf);
+        else EXECUTION_REPORT(REPORT_ERROR, -1, false, "remap software error in IO_netcdf::access_field_data_block: data type \"%s\" is not supported", data_type);
+        EXECUTION_REPORT(REPORT_ERROR, -1, rcode == NC_NOERR, "Netcdf error: %s for file %s\n", nc_strerror(rcode), file_name);
+        current_buf += slab_size*data_type_size;
+    }
+
     rcode = nc_close(ncfile_id);
-    report_nc_error();
+    EXECUTION_REPORT(REPORT_ERROR, -1, rcode == NC_NOERR, "Netcdf error: %s for file %s\n", nc_strerror(rcode), file_name);
+
+    return true;
 }
+#endif
 
 
 long IO_netcdf::get_dimension_size(const char *dim_name, MPI_Comm comm, bool is_root_proc)
 {
+    NETCDF_ACCESS_GUARD;
     int dimension_id;
     long dimension_size = -1;
 
@@ -665,6 +1050,7 @@ long IO_netcdf::get_dimension_size(const char *dim_name, MPI_Comm comm, bool is_
 
 void IO_netcdf::write_remap_weights(Remap_weight_of_strategy_class *remap_weights)
 {
+    NETCDF_ACCESS_GUARD;
     Remap_grid_class *remap_grid_src, *remap_grid_dst, *leaf_grids[256];
     int dim_ncid_n_a, dim_ncid_n_b, dim_ncid_n_s, dim_ncid_nv_a, dim_ncid_nv_b;
     int col_id, row_id, S_id, area_a_id, area_b_id, yc_a_id, xc_a_id, yv_a_id, xv_a_id;
@@ -770,6 +1156,7 @@ void IO_netcdf::write_remap_weights(Remap_weight_of_strategy_class *remap_weight
         report_nc_error();
         rcode = nc_enddef(ncfile_id);
         report_nc_error();
+        bool coo_was_released = weight_sparse_matrix->restore_coo_format();
         temp_int_values = new int [weight_sparse_matrix->get_num_weights()];
         for (j = 0; j < weight_sparse_matrix->get_num_weights(); j ++)
             temp_int_values[j] = weight_sparse_matrix->get_indexes_src_grid()[j] + 1;
@@ -782,6 +1169,8 @@ void IO_netcdf::write_remap_weights(Remap_weight_of_strategy_class *remap_weight
         report_nc_error();
         rcode = nc_put_var_double(ncfile_id, S_id, weight_sparse_matrix->get_weight_values());
         report_nc_error();
+        if (coo_was_released)
+            weight_sparse_matrix->release_coo_format();
 		if (area_or_volumn_a != NULL) {
         	rcode = nc_put_var_double(ncfile_id, area_a_id, area_or_volumn_a);
 	        report_nc_error();
@@ -852,15 +1241,13 @@ void IO_netcdf::write_remap_weights(Remap_weight_of_strategy_class *remap_weight
 
 void IO_netcdf::put_global_attr(const char *text_title, const void *attr_value, const char *local_data_type, const char *nc_data_type, int size)
 {
+    NETCDF_ACCESS_GUARD;
     int nc_datatype;
 
     
-    if (!is_external_file) {
-        rcode = nc_open(file_name, NC_WRITE, &ncfile_id);
-        report_nc_error();
-    }
-    rcode = nc_redef(ncfile_id);
-    report_nc_error();
+    if (!is_external_file)
+        open_file_for_write();
+    enter_define_mode();
 
     if (words_are_the_same(nc_data_type, DATA_TYPE_STRING))
         EXECUTION_REPORT(REPORT_ERROR, -1, words_are_the_same(local_data_type, DATA_TYPE_STRING), "software error in IO_netcdf::put_global_attr: miss match of data type");
@@ -880,12 +1267,9 @@ void IO_netcdf::put_global_attr(const char *text_title, const void *attr_value,
         rcode = nc_put_att_double(ncfile_id, NC_GLOBAL, text_title, NC_DOUBLE, size, (const double*)attr_value);
     else EXECUTION_REPORT(REPORT_ERROR, -1, false, "software error in IO_netcdf::put_global_attr: wrong local data type %s", local_data_type);
     report_nc_error();
-    nc_enddef(ncfile_id);
-    report_nc_error();
-    if (!is_external_file) {
-        rcode = nc_close(ncfile_id);
-        report_nc_error();
-    }
+    if (!is_external_file)
+        close_file_for_write();
+    else leave_define_mode();
 }
 
 
@@ -959,6 +1343,7 @@ bool IO_netcdf::get_file_field_attribute(const char *field_name, const char *att
 
 bool IO_netcdf::get_file_field_string_attribute(const char *field_name, const char *attribute_name, char *attribute_value, char *data_type, MPI_Comm comm, bool is_root_proc)
 {
+    NETCDF_ACCESS_GUARD;
     int success;
 
     attribute_value[0] = '\0';
@@ -981,6 +1366,7 @@ bool IO_netcdf::get_file_field_string_attribute(const char *field_name, const ch
 
 void IO_netcdf::read_file_field(const char *field_name, void **data_array_ptr, int *field_size, char *data_type, MPI_Comm comm, bool is_root_proc)
 {
+    NETCDF_ACCESS_GUARD;
     int i, variable_id, *dim_ids, *dim_size, total_size, have_field = 1;
     size_t dim_len;
     nc_type nc_var_type;
@@ -1062,8 +1448,53 @@ void IO_netcdf::read_file_field(const char *field_name, void **data_array_ptr, i
 }
 
 
+/* Reads the elements [block_start, block_start+block_size) of a one-dimensional variable, converted to the given data type.
+   It is called independently by each process, so that a large variable can be read in parallel without any process
+   holding the whole variable */
+bool IO_netcdf::read_file_field_block(const char *field_name, long block_start, long block_size, void *data_buf, const char *data_type)
+{
+    NETCDF_ACCESS_GUARD;
+    int variable_id, num_dims;
+    size_t starts[1], counts[1];
+    nc_type nc_var_type;
+    char file_data_type[NAME_STR_SIZE];
+
+
+    rcode = nc_open(file_name, NC_NOWRITE, &ncfile_id);
+    report_nc_error();
+    rcode = nc_inq_varid(ncfile_id, field_name, &variable_id);
+    if (rcode != NC_NOERR) {
+        rcode = nc_close(ncfile_id);
+        report_nc_error();
+        return false;
+    }
+    rcode = nc_inq_varndims(ncfile_id, variable_id, &num_dims);
+    report_nc_error();
+    EXECUTION_REPORT(REPORT_ERROR, -1, num_dims == 1, "Error happens when reading the variable \"%s\" in the file \"%s\": it must be a one-dimensional array. Please verify.", field_name, file_name);
+    rcode = nc_inq_vartype(ncfile_id, variable_id, &nc_var_type);
+    report_nc_error();
+    datatype_from_netcdf_to_application(nc_var_type, file_data_type, field_name);
+    EXECUTION_REPORT(REPORT_ERROR, -1, words_are_the_same(file_data_type, data_type), "Error happens when reading the variable \"%s\" in the file \"%s\": its data type must be %s. Please verify.", field_name, file_name, data_type);
+    if (block_size > 0) {
+        starts[0] = block_start;
+        counts[0] = block_size;
+        if (words_are_the_same(data_type, DATA_TYPE_INT))
+            rcode = nc_get_vara_int(ncfile_id, variable_id, starts, counts, (int*) data_buf);
+        else if (words_are_the_same(data_type, DATA_TYPE_DOUBLE))
+            rcode = nc_get_vara_double(ncfile_id, variable_id, starts, counts, (double*) data_buf);
+        else EXECUTION_REPORT(REPORT_ERROR, -1, false, "software error in IO_netcdf::read_file_field_block: data type %s is not supported", data_type);
+        report_nc_error();
+    }
+    rcode = nc_close(ncfile_id);
+    report_nc_error();
+
+    return true;
+}
+
+
 void IO_netcdf::read_remap_weights(Remap_weight_of_strategy_class *remap_weights, Remap_strategy_class *remap_strategy, bool read_weight_values)
 {
+    NETCDF_ACCESS_GUARD;
     double *area, *weight_values;
     int var_id;
     unsigned long grid_size, num_weights, i;
@@ -14,7 +14,11 @@
 
 #include "io_basis.h"
 #include <netcdf.h>
+#ifdef USE_PARALLEL_NETCDF
+#include <netcdf_par.h>
+#endif
 #include "remap_weight_of_strategy_class.h"
+#include <vector>
 
 
 #define SCRIP_CENTER_LON_LABEL          "grid_center_lon"
@@ -23,6 +27,24 @@
 #define SCRIP_VERTEX_LAT_LABEL          "grid_corner_lat"
 #define SCRIP_MASK_LABEL                "grid_imask"
 
+#define NETCDF_HEADER_FREE_SPACE        65536
+
+
+/* The netCDF library is not thread-safe. When the output is written by a background thread (USE_ASYNC_IO),
+   each public method of IO_netcdf holds a process-wide recursive lock */
+#ifdef USE_ASYNC_IO
+#include <pthread.h>
+class Netcdf_access_guard
+{
+    public:
+        Netcdf_access_guard();
+        ~Netcdf_access_guard();
+};
+#define NETCDF_ACCESS_GUARD             Netcdf_access_guard netcdf_access_guard
+#else
+#define NETCDF_ACCESS_GUARD
+#endif
+
 
 class IO_netcdf: public IO_basis
 {
@@ -33,8 +55,23 @@ class IO_netcdf: public IO_basis
         int time_dim_id;
         int time_count;
         bool is_external_file;
+        bool session_opened;
+        bool file_opened_for_write;
+        bool in_define_mode;
+        bool time_record_cached;
+        int cached_record_date;
+        int cached_record_datesec;
+        std::vector<char*> predefined_field_names;
+        std::vector<Remap_grid_class*> grids_written_before_async_IO;
         
+        void open_file_for_write();
+        void close_file_for_write();
+        void enter_define_mode();
+        void leave_define_mode();
         void write_field_data(Remap_grid_data_class*, Remap_grid_class*, bool, const char*, int, bool, bool);
+        void write_field_data(Remap_grid_data_class*, Remap_grid_class*, bool, const char*, int, bool, bool, bool);
+        void write_time_record(int, int);
+        void put_field_attributes(int, Remap_data_field*);
         void datatype_from_netcdf_to_application(nc_type, char*, const char*);
         void datatype_from_application_to_netcdf(const char*, nc_type*);
         void report_nc_error();
@@ -46,13 +83,24 @@ class IO_netcdf: public IO_basis
         ~IO_netcdf();
         bool read_data(Remap_data_field*, int, bool);
         void write_grided_data(Remap_grid_data_class*, bool, int, int, bool);
+        Remap_grid_data_class *prepare_grided_data_for_async_IO(Remap_grid_data_class*, bool, bool);
+        void write_prepared_grided_data(Remap_grid_data_class*, bool, int, int);
         void write_remap_weights(Remap_weight_of_strategy_class*);
         long get_dimension_size(const char*, MPI_Comm, bool);
         void read_remap_weights(Remap_weight_of_strategy_class*, Remap_strategy_class*, bool);
         void put_global_attr(const char*, const void*, const char *, const char *, int);
         void read_file_field(const char*, void**, int*, char*, MPI_Comm, bool);
+        bool read_file_field_block(const char*, long, long, void*, const char*);
         bool get_file_field_string_attribute(const char*, const char *, char*, char *, MPI_Comm, bool);
         void write_grid(Remap_grid_class*, bool, bool);
+        void define_field_variable(Remap_data_field*, Remap_grid_class*, const char*, const char*, bool, int, int);
+        void begin_session();
+        void flush_session();
+        void end_session();
+        bool is_predefined_field(const char*, bool);
+#ifdef USE_PARALLEL_NETCDF
+        static bool access_field_data_block(const char*, const char*, const char*, int, long, long, void*, MPI_Comm, bool);
+#endif
 };
 
 
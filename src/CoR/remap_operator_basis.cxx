@@ -59,6 +59,13 @@ Remap_operator_basis::~Remap_operator_basis()
 }
 
 
+void Remap_operator_basis::do_remap_values_caculation_of_multi_columns(double **data_values_src, double **data_values_dst, int num_columns, int dst_array_size, int num_threads)
+{
+    for (int i = 0; i < num_columns; i ++)
+        do_remap_values_caculation(data_values_src[i], data_values_dst[i], dst_array_size, num_threads);
+}
+
+
 void Remap_operator_basis::register_remap_grids(int num_remap_grids, Remap_grid_class **remap_grids)
 {
     int i, j, num_leaf_grids;
@@ -153,6 +160,10 @@ void Remap_operator_basis::calculate_grids_overlaping()
     for (cell_index_dst = 0; cell_index_dst < dst_grid->get_grid_size(); cell_index_dst ++) {
         finalize_computing_remap_weights_of_one_cell();
         initialize_computing_remap_weights_of_one_cell();
+        /* Only the search time is reduced here: the src grid and its search engine are still global on each process, 
+           so that the overlapping src cells, and thus the weights, do not depend on the parallel decomposition */
+        if (H2D_grid_decomp_mask != NULL && !H2D_grid_decomp_mask[cell_index_dst])
+            continue;
         get_cell_mask_of_dst_grid(cell_index_dst, &dst_cell_mask);
         if (!dst_cell_mask)
             continue;
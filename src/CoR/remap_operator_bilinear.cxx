@@ -644,9 +644,15 @@ void Remap_operator_bilinear::solve_two_bilinear_ratios(long *bilinear_box_verte
 }
 
 
-void Remap_operator_bilinear::do_remap_values_caculation(double *data_values_src, double *data_values_dst, int dst_array_size)
+void Remap_operator_bilinear::do_remap_values_caculation(double *data_values_src, double *data_values_dst, int dst_array_size, int num_threads)
 {
-    remap_weights_groups[0]->remap_values(data_values_src, data_values_dst, dst_array_size);
+    remap_weights_groups[0]->remap_values(data_values_src, data_values_dst, dst_array_size, num_threads);
+}
+
+
+void Remap_operator_bilinear::do_remap_values_caculation_of_multi_columns(double **data_values_src, double **data_values_dst, int num_columns, int dst_array_size, int num_threads)
+{
+    remap_weights_groups[0]->remap_values_of_multi_columns(data_values_src, data_values_dst, num_columns, num_threads);
 }
 
 
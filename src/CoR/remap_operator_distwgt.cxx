@@ -10,7 +10,9 @@
 #include "cor_global_data.h"
 #include "remap_operator_distwgt.h"
 #include "remap_utils_nearest_points.h"
+#include "grid_cell_search.h"
 #include <string.h>
+#include <algorithm>
 
 
 void Remap_operator_distwgt::set_parameter(const char *parameter_name, const char *parameter_value)
@@ -114,15 +116,81 @@ void Remap_operator_distwgt::compute_remap_weights_of_one_dst_cell(long dst_cell
 }
 
 
+/* The dst cells are processed in chunks: the cells requiring nearest points are collected serially, the nearest points of 
+   a chunk are searched in batch (a cell near a pole may be searched in the rotated src grid), and the remapping weights 
+   are added in the order of dst cells as before */
 void Remap_operator_distwgt::calculate_remap_weights()
 {    
+    std::vector<long> query_cells_index;
+    std::vector<double> query_points_lon, query_points_lat;
+    std::vector<H2D_grid_cell_search_engine*> query_engines;
+    std::vector<double> batch_points_lon, batch_points_lat, batch_found_dist;
+    std::vector<long> batch_found_indx;
+    std::vector<int> batch_num_found, num_found_points;
+    std::vector<long> found_points_indx;
+    std::vector<double> found_points_dist;
+    std::vector<int> batch_queries;
+    double dst_cell_center_values[256];
+    long chunk_start, chunk_end, i;
+    int j, k;
+
+
     threshold_distance = 1.0/6000.0;
     clear_remap_weight_info_in_sparse_matrix();
     
-    for (long dst_cell_index = 0; dst_cell_index < dst_grid->get_grid_size(); dst_cell_index ++) {
-        if (H2D_grid_decomp_mask != NULL && !H2D_grid_decomp_mask[dst_cell_index])
+    for (chunk_start = 0; chunk_start < dst_grid->get_grid_size(); chunk_start += NUM_DST_CELLS_PER_NEAREST_POINTS_BATCH) {
+        chunk_end = std::min(chunk_start+NUM_DST_CELLS_PER_NEAREST_POINTS_BATCH, dst_grid->get_grid_size());
+        query_cells_index.clear();
+        query_points_lon.clear();
+        query_points_lat.clear();
+        query_engines.clear();
+        for (i = chunk_start; i < chunk_end; i ++) {
+            if (H2D_grid_decomp_mask != NULL && !H2D_grid_decomp_mask[i])
+                continue;
+            initialize_computing_remap_weights_of_one_cell();
+            if (check_dst_cell_requiring_nearest_points(i, dst_cell_center_values, enable_extrapolate)) {
+                query_cells_index.push_back(i);
+                query_points_lon.push_back(dst_cell_center_values[0]);
+                query_points_lat.push_back(dst_cell_center_values[1]);
+                query_engines.push_back(get_current_grid2D_search_engine(true));
+            }
+            finalize_computing_remap_weights_of_one_cell();
+        }
+        if (query_cells_index.size() == 0)
             continue;
-        compute_remap_weights_of_one_dst_cell(dst_cell_index);
+
+        num_found_points.resize(query_cells_index.size());
+        found_points_indx.resize(query_cells_index.size()*num_nearest_points);
+        found_points_dist.resize(query_cells_index.size()*num_nearest_points);
+        for (j = 0; j < query_cells_index.size(); j ++) {
+            if (query_engines[j] == NULL)
+                continue;
+            H2D_grid_cell_search_engine *engine = query_engines[j];
+            batch_queries.clear();
+            batch_points_lon.clear();
+            batch_points_lat.clear();
+            for (k = j; k < query_cells_index.size(); k ++)
+                if (query_engines[k] == engine) {
+                    batch_queries.push_back(k);
+                    batch_points_lon.push_back(query_points_lon[k]);
+                    batch_points_lat.push_back(query_points_lat[k]);
+                    query_engines[k] = NULL;
+                }
+            batch_num_found.resize(batch_queries.size());
+            batch_found_indx.resize(batch_queries.size()*num_nearest_points);
+            batch_found_dist.resize(batch_queries.size()*num_nearest_points);
+            engine->search_nearest_points_var_number_batch(batch_queries.size(), &batch_points_lon[0], &batch_points_lat[0], num_nearest_points, 
+                                                           &batch_num_found[0], &batch_found_indx[0], &batch_found_dist[0], true);
+            for (k = 0; k < batch_queries.size(); k ++) {
+                num_found_points[batch_queries[k]] = batch_num_found[k];
+                memcpy(&found_points_indx[((long)batch_queries[k])*num_nearest_points], &batch_found_indx[((long)k)*num_nearest_points], sizeof(long)*num_nearest_points);
+                memcpy(&found_points_dist[((long)batch_queries[k])*num_nearest_points], &batch_found_dist[((long)k)*num_nearest_points], sizeof(double)*num_nearest_points);
+            }
+        }
+
+        for (j = 0; j < query_cells_index.size(); j ++)
+            add_dist_remap_weights_of_one_dst_cell(query_cells_index[j], num_nearest_points, num_found_points[j], num_power, &found_points_dist[((long)j)*num_nearest_points], 
+                                                   &found_points_indx[((long)j)*num_nearest_points], weigt_values_of_one_dst_cell);
     }
 }
 
@@ -138,9 +206,15 @@ Remap_operator_distwgt::~Remap_operator_distwgt()
 }
 
 
-void Remap_operator_distwgt::do_remap_values_caculation(double *data_values_src, double *data_values_dst, int dst_array_size)
+void Remap_operator_distwgt::do_remap_values_caculation(double *data_values_src, double *data_values_dst, int dst_array_size, int num_threads)
+{
+    remap_weights_groups[0]->remap_values(data_values_src, data_values_dst, dst_array_size, num_threads);
+}
+
+
+void Remap_operator_distwgt::do_remap_values_caculation_of_multi_columns(double **data_values_src, double **data_values_dst, int num_columns, int dst_array_size, int num_threads)
 {
-    remap_weights_groups[0]->remap_values(data_values_src, data_values_dst, dst_array_size);
+    remap_weights_groups[0]->remap_values_of_multi_columns(data_values_src, data_values_dst, num_columns, num_threads);
 }
 
 
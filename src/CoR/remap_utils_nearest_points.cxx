@@ -55,42 +55,48 @@ double calculate_distance_of_two_points_2D(double point1_coord1_value,
 }
 
 
-void compute_dist_remap_weights_of_one_dst_cell(long dst_cell_index,
-                                                int num_nearest_points,
-                                                double num_power,
-                                                double *threshold_distance,
-                                                double *found_nearest_points_distance,
-                                                long *found_nearest_points_src_indexes,
-                                                double *weigt_values_of_one_dst_cell,
-                                                bool is_sphere_grid,
-                                                bool enable_extrapolate)
+/* Check whether the nearest src points of the dst cell are required. If so, dst_cell_center_values returns the location to be 
+   searched in the src grid search engine that get_current_grid2D_search_engine(true) returns afterwards */
+bool check_dst_cell_requiring_nearest_points(long dst_cell_index, double *dst_cell_center_values, bool enable_extrapolate)
 {
-    bool successful = false, dst_cell_mask;
+    bool dst_cell_mask;
     long src_cell_index;
-    double sum_wgt_values, src_cell_center_values[256], dst_cell_center_values[256], dst_cell_vertex_values[65536];
-    int i, num_points_within_threshold_dist, num_vertexes_dst;
-    double current_dist;
+    double dst_cell_vertex_values[65536];
+    int num_vertexes_dst;
 
     
     get_cell_mask_of_dst_grid(dst_cell_index, &dst_cell_mask);
     if (!dst_cell_mask)
-        return;
+        return false;
 
     get_cell_center_coord_values_of_dst_grid(dst_cell_index, dst_cell_center_values);
     get_cell_vertex_coord_values_of_dst_grid(dst_cell_index, &num_vertexes_dst, dst_cell_vertex_values, true);
     EXECUTION_REPORT(REPORT_ERROR, -1, num_vertexes_dst <= 65536/2, "Software error in compute_dist_remap_weights_of_one_dst_cell: too big number of dst vertexes: %d", num_vertexes_dst);
     
     if (num_vertexes_dst > 0 && (!enable_extrapolate && !have_overlapped_src_cells_for_dst_cell(dst_cell_index)))
-        return;
+        return false;
 
     if (num_vertexes_dst == 0) {
         search_cell_in_src_grid(dst_cell_center_values, &src_cell_index, false);
         if (src_cell_index == -1 && (!enable_extrapolate))
-            return;
+            return false;
     }
 
-    get_current_grid2D_search_engine(true)->search_nearest_points_var_number(num_nearest_points, dst_cell_center_values[0], dst_cell_center_values[1], 
-                                                                                                      num_points_within_threshold_dist, found_nearest_points_src_indexes, found_nearest_points_distance, true);
+    return true;
+}
+
+
+void add_dist_remap_weights_of_one_dst_cell(long dst_cell_index,
+                                            int num_nearest_points,
+                                            int num_points_within_threshold_dist,
+                                            double num_power,
+                                            const double *found_nearest_points_distance,
+                                            long *found_nearest_points_src_indexes,
+                                            double *weigt_values_of_one_dst_cell)
+{
+    double sum_wgt_values;
+    int i;
+
 
     if (num_nearest_points > num_points_within_threshold_dist)
         num_nearest_points = num_points_within_threshold_dist;
@@ -114,3 +120,27 @@ void compute_dist_remap_weights_of_one_dst_cell(long dst_cell_index,
     }
 }
 
+
+void compute_dist_remap_weights_of_one_dst_cell(long dst_cell_index,
+                                                int num_nearest_points,
+                                                double num_power,
+                                                double *threshold_distance,
+                                                double *found_nearest_points_distance,
+                                                long *found_nearest_points_src_indexes,
+                                                double *weigt_values_of_one_dst_cell,
+                                                bool is_sphere_grid,
+                                                bool enable_extrapolate)
+{
+    double dst_cell_center_values[256];
+    int num_points_within_threshold_dist;
+
+    
+    if (!check_dst_cell_requiring_nearest_points(dst_cell_index, dst_cell_center_values, enable_extrapolate))
+        return;
+
+    get_current_grid2D_search_engine(true)->search_nearest_points_var_number(num_nearest_points, dst_cell_center_values[0], dst_cell_center_values[1], 
+                                                                                                      num_points_within_threshold_dist, found_nearest_points_src_indexes, found_nearest_points_distance, true);
+    add_dist_remap_weights_of_one_dst_cell(dst_cell_index, num_nearest_points, num_points_within_threshold_dist, num_power, found_nearest_points_distance, 
+                                           found_nearest_points_src_indexes, weigt_values_of_one_dst_cell);
+}
+
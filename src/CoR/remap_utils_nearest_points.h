@@ -12,6 +12,8 @@
 
 
 extern void compute_dist_remap_weights_of_one_dst_cell(long, int, double, double*, double*, long*, double*, bool, bool);
+extern bool check_dst_cell_requiring_nearest_points(long, double*, bool);
+extern void add_dist_remap_weights_of_one_dst_cell(long, int, int, double, const double*, long*, double*);
 extern double calculate_distance_of_two_points_2D(double, double, double, double, bool);
 
 
@@ -226,7 +226,7 @@ Remap_weight_of_operator_class::~Remap_weight_of_operator_class()
 }
 
 
-void Remap_weight_of_operator_class::do_remap(int comp_id, Remap_grid_data_class *field_data_src, Remap_grid_data_class *field_data_dst)
+void Remap_weight_of_operator_class::do_remap(Performance_timing_mgt *performance_timing_mgr, Remap_grid_data_class *field_data_src, Remap_grid_data_class *field_data_dst, int num_threads)
 {
 
     double *data_value_src, *data_value_dst;
@@ -239,12 +239,12 @@ void Remap_weight_of_operator_class::do_remap(int comp_id, Remap_grid_data_class
     EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR, -1, field_data_src->get_coord_value_grid()->is_similar_grid_with(field_data_grid_src), "C-Coupler error1 in do_remap of Remap_weight_of_operator_class");
     EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR, -1, field_data_dst->get_coord_value_grid()->is_similar_grid_with(field_data_grid_dst), "C-Coupler error2 in do_remap of Remap_weight_of_operator_class");
 
-    if (comp_id != -1)          
-        comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "interchange data");
+    if (performance_timing_mgr != NULL)          
+        performance_timing_mgr->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "interchange data");
     field_data_src->interchange_grid_data(field_data_grid_src);
     field_data_dst->interchange_grid_data(field_data_grid_dst);
-    if (comp_id != -1)          
-        comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "interchange data");
+    if (performance_timing_mgr != NULL)          
+        performance_timing_mgr->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "interchange data");
 
     field_data_size_src = field_data_src->get_grid_data_field()->read_data_size;
     field_data_size_dst = field_data_dst->get_grid_data_field()->read_data_size;
@@ -258,6 +258,8 @@ void Remap_weight_of_operator_class::do_remap(int comp_id, Remap_grid_data_class
         else if (i+1 < remap_weights_of_operator_instances.size())
                 remap_end_iter = remap_weights_of_operator_instances[i+1]->remap_beg_iter;
         else remap_end_iter = field_data_grid_src->get_grid_size()/operator_grid_src->get_grid_size();
+        batched_data_values_src.clear();
+        batched_data_values_dst.clear();
         for (j = remap_beg_iter; j < remap_end_iter; j ++) {
             field_array_offset = j;
             if (report_error_enabled) {
@@ -268,9 +270,15 @@ void Remap_weight_of_operator_class::do_remap(int comp_id, Remap_grid_data_class
             }    
             data_value_src = ((double*) field_data_src->get_grid_data_field()->data_buf) + field_array_offset*remap_weights_of_operator_instances[i]->get_operator_grid_src()->get_grid_size();
             data_value_dst = ((double*) field_data_dst->get_grid_data_field()->data_buf) + field_array_offset*remap_weights_of_operator_instances[i]->get_operator_grid_dst()->get_grid_size();
-            EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR, -1, remap_weights_of_operator_instances[i]->duplicated_remap_operator != NULL, "C-Coupler error3 in do_remap of Remap_weight_of_operator_class %s", remap_weights_of_operator_instances[i]->get_operator_grid_src()->get_grid_name());
-            remap_weights_of_operator_instances[i]->duplicated_remap_operator->do_remap_values_caculation(data_value_src, data_value_dst, field_data_dst->get_grid_data_field()->required_data_size);
+            batched_data_values_src.push_back(data_value_src);
+            batched_data_values_dst.push_back(data_value_dst);
         }
+        if (batched_data_values_src.size() == 0)
+            continue;
+        EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR, -1, remap_weights_of_operator_instances[i]->duplicated_remap_operator != NULL, "C-Coupler error3 in do_remap of Remap_weight_of_operator_class %s", remap_weights_of_operator_instances[i]->get_operator_grid_src()->get_grid_name());
+        if (batched_data_values_src.size() == 1)
+            remap_weights_of_operator_instances[i]->duplicated_remap_operator->do_remap_values_caculation(batched_data_values_src[0], batched_data_values_dst[0], field_data_dst->get_grid_data_field()->required_data_size, num_threads);
+        else remap_weights_of_operator_instances[i]->duplicated_remap_operator->do_remap_values_caculation_of_multi_columns(&batched_data_values_src[0], &batched_data_values_dst[0], batched_data_values_src.size(), field_data_dst->get_grid_data_field()->required_data_size, num_threads);
     }
 }
 
@@ -361,7 +369,7 @@ void Remap_weight_of_operator_class::renew_vertical_remap_weights(Remap_grid_cla
 }
 
 
-void Remap_weight_of_operator_class::write_overall_remapping_weights(int comp_id)
+void Remap_weight_of_operator_class::write_overall_remapping_weights(int comp_id, const char *wgt_cache_file_name, long wgt_cache_key, const bool *covered_dst_cells)
 {
 	char default_wgt_file_name[NAME_STR_SIZE], full_default_wgt_file_name[NAME_STR_SIZE*2];
 	Remap_operator_basis *overall_remap_operator;
@@ -385,6 +393,8 @@ void Remap_weight_of_operator_class::write_overall_remapping_weights(int comp_id
 		io_netcdf->write_remap_weights(overall_remap_weights);
 		execution_phase_number = last_execution_phase_number;
 		delete io_netcdf;
+		if (wgt_cache_file_name != NULL)
+			H2D_remapping_wgt_file_info::write_remapping_wgt_cache(wgt_cache_file_name, wgt_cache_key, operator_grid_src->get_grid_size(), operator_grid_dst->get_grid_size(), overall_remap_operator->get_remap_weights_group(0), covered_dst_cells);
 		delete overall_remap_weights;
 	}
 }
@@ -559,7 +569,7 @@ void Remap_weight_of_strategy_class::add_remap_weight_of_operator_instance(Remap
 }
 
 
-void Remap_weight_of_strategy_class::do_remap(int comp_id, Remap_grid_data_class *field_data_src, Remap_grid_data_class *field_data_dst)
+void Remap_weight_of_strategy_class::do_remap(Performance_timing_mgt *performance_timing_mgr, Remap_grid_data_class *field_data_src, Remap_grid_data_class *field_data_dst, int num_threads)
 {
     Remap_grid_class *sized_sub_grids[256];
     Remap_grid_class *field_data_grid_src, *field_data_grid_dst;
@@ -588,8 +598,8 @@ void Remap_weight_of_strategy_class::do_remap(int comp_id, Remap_grid_data_class
     tmp_field_data_dst = field_data_src;
     tmp_field_data_src = NULL;
     for (i = 0; i < remap_weights_of_operators.size(); i ++) {
-        if (comp_id != -1)        
-            comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, remap_weights_of_operators[i]->get_original_remap_operator()->get_operator_name());
+        if (performance_timing_mgr != NULL)        
+            performance_timing_mgr->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, remap_weights_of_operators[i]->get_original_remap_operator()->get_operator_name());
         if (tmp_field_data_src != NULL && tmp_field_data_src != field_data_src)
             delete tmp_field_data_src;
         tmp_field_data_src = tmp_field_data_dst;
@@ -601,9 +611,9 @@ void Remap_weight_of_strategy_class::do_remap(int comp_id, Remap_grid_data_class
 				EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR, -1, words_are_the_same(field_data_dst->get_grid_data_field()->field_name_in_application, V3D_GRID_3D_LEVEL_FIELD_NAME), "Software error in Remap_weight_of_strategy_class::do_remap");
         }    
         else tmp_field_data_dst = field_data_src->duplicate_grid_data_field(remap_weights_of_operators[i]->field_data_grid_dst, 1, false, false);
-        remap_weights_of_operators[i]->do_remap(comp_id, tmp_field_data_src, tmp_field_data_dst);
-        if (comp_id != -1)        
-            comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, remap_weights_of_operators[i]->get_original_remap_operator()->get_operator_name());
+        remap_weights_of_operators[i]->do_remap(performance_timing_mgr, tmp_field_data_src, tmp_field_data_dst, num_threads);
+        if (performance_timing_mgr != NULL)        
+            performance_timing_mgr->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, remap_weights_of_operators[i]->get_original_remap_operator()->get_operator_name());
 		if (i != remap_weights_of_operators.size()-1 && tmp_field_data_dst == field_data_dst) {
 			EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR, -1, words_are_the_same(field_data_dst->get_grid_data_field()->field_name_in_application, V3D_GRID_3D_LEVEL_FIELD_NAME), "Software error in Remap_weight_of_strategy_class::do_remap");
 			break;
@@ -612,13 +622,13 @@ void Remap_weight_of_strategy_class::do_remap(int comp_id, Remap_grid_data_class
 
     if (tmp_field_data_src != NULL && tmp_field_data_src != field_data_src)
         delete tmp_field_data_src;
-    if (comp_id != -1)          
-        comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "interchange data");
+    if (performance_timing_mgr != NULL)          
+        performance_timing_mgr->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "interchange data");
     field_data_src->interchange_grid_data(field_data_src->get_coord_value_grid());
     field_data_dst->interchange_grid_data(field_data_dst->get_coord_value_grid());
     field_data_dst->get_grid_data_field()->read_data_size = field_data_dst->get_grid_data_field()->required_data_size;
-    if (comp_id != -1)          
-        comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "interchange data");
+    if (performance_timing_mgr != NULL)          
+        performance_timing_mgr->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "interchange data");
 }
 
 
@@ -714,22 +724,12 @@ Remap_weight_of_strategy_class *Remap_weight_of_strategy_class::generate_paralle
 }
 
 
-void Remap_weight_of_strategy_class::write_data_into_array(void *data, int data_size, char **array, long &current_array_size, long &max_array_size)
+void Remap_weight_of_strategy_class::write_data_into_array(const void *data, long data_size, char **array, long &current_array_size, long &max_array_size)
 {
-    char *new_array;
+    if (data_size + current_array_size > max_array_size)
+        reserve_array_buffer((data_size+current_array_size)*2, array, max_array_size, current_array_size);
 
-    
-    if (data_size + current_array_size > max_array_size) {
-        max_array_size = (data_size+current_array_size)*2;
-        new_array = new char [max_array_size];
-        for (long i = 0; i < current_array_size; i ++)
-            new_array[i] = (*array)[i];
-        delete [] (*array);
-        (*array) = new_array;
-    }
-
-    for (long i = 0; i < data_size; i ++)
-        (*array)[current_array_size+i] = ((char*)data)[i];
+    memcpy((*array)+current_array_size, data, data_size);
     current_array_size += data_size;
 }
 
@@ -789,6 +789,16 @@ void Remap_weight_of_strategy_class::write_remap_weights_into_array(char **array
     
     array_size = 0;
     max_array_size = 1024*1024;
+    for (k = 0; k < remap_weights_of_operators.size(); k ++)
+        for (i = 0; i < remap_weights_of_operators[k]->remap_weights_of_operator_instances.size(); i ++) {
+            remap_operator_of_one_instance = remap_weights_of_operators[k]->remap_weights_of_operator_instances[i]->duplicated_remap_operator;
+            if (remap_operator_of_one_instance == NULL)
+                continue;
+            for (j = 0; j < remap_operator_of_one_instance->get_num_remap_weights_groups(); j ++) {
+                remap_weights_group = remap_operator_of_one_instance->get_remap_weights_group(j);
+                max_array_size += (sizeof(long)*2+sizeof(double))*remap_weights_group->get_num_weights() + sizeof(long)*remap_weights_group->get_num_remaped_dst_cells_indexes();
+            }
+        }
     output_array = new char [max_array_size];
 
     remap_grid_src = get_data_grid_src();
@@ -827,11 +837,14 @@ void Remap_weight_of_strategy_class::write_remap_weights_into_array(char **array
             write_data_into_array(&tmp_int_value, sizeof(int), &output_array, array_size, max_array_size);
             for (j = 0; j < remap_operator_of_one_instance->get_num_remap_weights_groups(); j ++) {
                 remap_weights_group = remap_operator_of_one_instance->get_remap_weights_group(j);
+                bool coo_was_released = remap_weights_group->restore_coo_format();
                 tmp_long_value = remap_weights_group->get_num_weights();
                 write_data_into_array(&tmp_long_value, sizeof(long), &output_array, array_size, max_array_size);
                 write_data_into_array(remap_weights_group->get_indexes_src_grid(), sizeof(long)*tmp_long_value, &output_array, array_size, max_array_size);
                 write_data_into_array(remap_weights_group->get_indexes_dst_grid(), sizeof(long)*tmp_long_value, &output_array, array_size, max_array_size);
                 write_data_into_array(remap_weights_group->get_weight_values(), sizeof(double)*tmp_long_value, &output_array, array_size, max_array_size);
+                if (coo_was_released)
+                    remap_weights_group->release_coo_format();
                 tmp_long_value = remap_weights_group->get_num_remaped_dst_cells_indexes();
                 write_data_into_array(&tmp_long_value, sizeof(long), &output_array, array_size, max_array_size);
                 write_data_into_array(remap_weights_group->get_remaped_dst_cells_indexes(), sizeof(long)*tmp_long_value, &output_array, array_size, max_array_size);
@@ -842,15 +855,13 @@ void Remap_weight_of_strategy_class::write_remap_weights_into_array(char **array
 }
 
 
-void Remap_weight_of_strategy_class::read_data_from_array(void *data, int data_size, const char *input_array, FILE *fp_binary, long &current_array_pos, long array_size, bool read_weight_values)
+void Remap_weight_of_strategy_class::read_data_from_array(void *data, long data_size, const char *input_array, FILE *fp_binary, long &current_array_pos, long array_size, bool read_weight_values)
 {
     EXECUTION_REPORT(REPORT_ERROR, -1, current_array_pos+data_size <= array_size, "the access of array is out-of-bound when reading for remapping weights %s", object_name);
 
     if (read_weight_values) {
-        if (input_array != NULL) {
-            for (long i = 0; i < data_size; i ++)
-                ((char*)data)[i] = input_array[current_array_pos+i];
-        }
+        if (input_array != NULL)
+            memcpy(data, input_array+current_array_pos, data_size);
         else fread((char*)data, 1, data_size, fp_binary);
     }
     else if (fp_binary != NULL)
@@ -1103,11 +1114,11 @@ Remap_weight_of_operator_class *Remap_weight_of_strategy_class::get_dynamic_V1D_
 }
 
 
-void Remap_weight_of_strategy_class::write_overall_H2D_remapping_weights(int comp_id)
+void Remap_weight_of_strategy_class::write_overall_H2D_remapping_weights(int comp_id, const char *wgt_cache_file_name, long wgt_cache_key, const bool *covered_dst_cells)
 {
 	for (int i = 0; i < remap_weights_of_operators.size(); i ++)
 		if (remap_weights_of_operators[i]->operator_grid_src->get_is_sphere_grid())
-			remap_weights_of_operators[i]->write_overall_remapping_weights(comp_id);
+			remap_weights_of_operators[i]->write_overall_remapping_weights(comp_id, wgt_cache_file_name, wgt_cache_key, covered_dst_cells);
 }
 
 
@@ -17,6 +17,9 @@
 #include <vector>
 
 
+class Performance_timing_mgt;
+
+
 class Remap_operator_basis;
 class Remap_strategy_class;
 class Remap_weight_sparse_matrix;
@@ -65,6 +68,8 @@ class Remap_weight_of_operator_class
         Remap_grid_class *operator_grid_dst;
         Remap_operator_basis *original_remap_operator;
         std::vector<Remap_weight_of_operator_instance_class*> remap_weights_of_operator_instances;
+        std::vector<double*> batched_data_values_src;
+        std::vector<double*> batched_data_values_dst;
         bool empty_remap_weight;
         
     public: 
@@ -76,13 +81,13 @@ class Remap_weight_of_operator_class
         Remap_grid_class *get_operator_grid_dst() { return operator_grid_dst; } 
         void calculate_src_decomp(long*, const long*);
         Remap_weight_of_operator_class *generate_parallel_remap_weights(Remap_grid_class**, Remap_grid_class**, int **, int &, Remap_weight_of_strategy_class*);
-        void do_remap(int, Remap_grid_data_class*, Remap_grid_data_class*);
+        void do_remap(Performance_timing_mgt*, Remap_grid_data_class*, Remap_grid_data_class*, int);
         void add_remap_weight_of_operator_instance(Remap_weight_of_operator_instance_class *);
         Remap_operator_basis *get_original_remap_operator() { return original_remap_operator; }
         void renew_vertical_remap_weights(Remap_grid_class *runtime_remap_grid_src, Remap_grid_class *runtime_remap_grid_dst);
         void mark_empty_remap_weight() { empty_remap_weight = true; }
         bool is_remap_weight_empty() { return empty_remap_weight; }        
-		void write_overall_remapping_weights(int);
+		void write_overall_remapping_weights(int, const char*, long, const bool*);
 };
 
 
@@ -102,10 +107,10 @@ class Remap_weight_of_strategy_class
         Remap_grid_data_class *runtime_mask_fields_in_remapping_process[512];
 
         void read_grid_info_from_array(Remap_grid_class*, bool, const char *, FILE*, long&, long);
-        void read_data_from_array(void*, int, const char*, FILE*, long&, long, bool);
+        void read_data_from_array(void*, long, const char*, FILE*, long&, long, bool);
         void read_remap_operator_instance_from_array(Remap_grid_class*, Remap_grid_class*, Remap_grid_class*, Remap_grid_class*, Remap_operator_basis*, long, long, const char*, FILE*, long&, long, bool);
         void write_grid_info_into_array(Remap_grid_class*, bool, char **, long&, long &);
-        void write_data_into_array(void*, int, char**, long&, long &);
+        void write_data_into_array(const void*, long, char**, long&, long &);
 
     public:
         Remap_weight_of_strategy_class(const char*, const char*, const char*, const char*, const char*, const char*, bool);
@@ -122,7 +127,7 @@ class Remap_weight_of_strategy_class
         Remap_strategy_class *get_remap_strategy() { return remap_strategy; }
         Remap_operator_basis *get_unique_remap_operator_of_weights();
         Remap_weight_of_operator_instance_class *add_remap_weight_of_operator_instance(Remap_grid_class*, Remap_grid_class*, long, Remap_operator_basis*);
-        void do_remap(int, Remap_grid_data_class*, Remap_grid_data_class*);
+        void do_remap(Performance_timing_mgt*, Remap_grid_data_class*, Remap_grid_data_class*, int);
         void add_remap_weight_of_operator_instance(Remap_weight_of_operator_instance_class *, Remap_grid_class *, Remap_grid_class *, Remap_operator_basis *, Remap_grid_class *, Remap_grid_class *);
         void calculate_src_decomp(Remap_grid_class*, Remap_grid_class*, long*, const long*);
 		void get_remap_related_grids(std::vector<std::pair<Remap_grid_class *, bool> > &);		
@@ -142,7 +147,7 @@ class Remap_weight_of_strategy_class
         Remap_grid_data_class *get_runtime_mask_field_in_remapping_process(int);
         Remap_weight_of_operator_class *get_dynamic_V1D_remap_weight_of_operator();
         void mark_empty_remap_weight() { remap_weights_of_operators[remap_weights_of_operators.size()-1]->mark_empty_remap_weight(); }
-		void write_overall_H2D_remapping_weights(int);
+		void write_overall_H2D_remapping_weights(int, const char*, long, const bool*);
 };
 
 
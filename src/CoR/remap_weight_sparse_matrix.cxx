@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 
 
 Remap_weight_sparse_matrix::Remap_weight_sparse_matrix(Remap_operator_basis *remap_operator, 
@@ -48,6 +49,8 @@ Remap_weight_sparse_matrix::Remap_weight_sparse_matrix(Remap_operator_basis *rem
     }
 
     this->remaped_dst_cells_indexes_array_size = this->num_remaped_dst_cells_indexes;
+    coo_is_released = false;
+    initialize_csr_format();
 }
 
 
@@ -62,23 +65,102 @@ Remap_weight_sparse_matrix::Remap_weight_sparse_matrix(Remap_operator_basis *rem
     cells_indexes_dst = new long [weight_arrays_size];
     weight_values = new double [weight_arrays_size];
     remaped_dst_cells_indexes = new long [remaped_dst_cells_indexes_array_size];
+    coo_is_released = false;
+    initialize_csr_format();
 }
 
 
 Remap_weight_sparse_matrix::~Remap_weight_sparse_matrix()
 {
-    delete [] cells_indexes_src;
-    delete [] cells_indexes_dst;
+    release_csr_format();
+    if (cells_indexes_src != NULL)
+        delete [] cells_indexes_src;
+    if (cells_indexes_dst != NULL)
+        delete [] cells_indexes_dst;
     if (remaped_dst_cells_indexes != NULL)
         delete [] remaped_dst_cells_indexes;
+    if (weight_values != NULL)
+        delete [] weight_values;
+}
+
+
+void Remap_weight_sparse_matrix::initialize_csr_format()
+{
+    csr_rows_dst_indexes = NULL;
+    csr_rows_offsets = NULL;
+    csr_cols_src_indexes = NULL;
+    csr_weight_values = NULL;
+    csr_rows_keeping_dst_values = NULL;
+    csr_num_rows = 0;
+    csr_is_up_to_date = false;
+}
+
+
+void Remap_weight_sparse_matrix::release_csr_format()
+{
+    if (csr_rows_dst_indexes != NULL)
+        delete [] csr_rows_dst_indexes;
+    if (csr_rows_offsets != NULL)
+        delete [] csr_rows_offsets;
+    if (csr_cols_src_indexes != NULL)
+        delete [] csr_cols_src_indexes;
+    if (csr_weight_values != NULL)
+        delete [] csr_weight_values;
+    if (csr_rows_keeping_dst_values != NULL)
+        delete [] csr_rows_keeping_dst_values;
+    initialize_csr_format();
+}
+
+
+/* Release the original (COO) weights of a matrix that is only used for remapping values, so that only the CSR weights 
+   (a 32-bit index and a value per weight) are kept. The callers that access the COO arrays of such a matrix (e.g., for 
+   writing the weights) rebuild them with restore_coo_format, sorted by dst cell, and release them again afterwards. */
+void Remap_weight_sparse_matrix::release_coo_format()
+{
+    if (coo_is_released)
+        return;
+
+    if (!csr_is_up_to_date)
+        finalize_weights();
+    delete [] cells_indexes_src;
+    delete [] cells_indexes_dst;
     delete [] weight_values;
+    cells_indexes_src = NULL;
+    cells_indexes_dst = NULL;
+    weight_values = NULL;
+    weight_arrays_size = 0;
+    coo_is_released = true;
+}
+
+
+/* Return whether the COO weights have been rebuilt, i.e., whether the caller should release them again */
+bool Remap_weight_sparse_matrix::restore_coo_format()
+{
+    if (!coo_is_released)
+        return false;
+
+    weight_arrays_size = num_weights > 0? num_weights : 1;
+    cells_indexes_src = new long [weight_arrays_size];
+    cells_indexes_dst = new long [weight_arrays_size];
+    weight_values = new double [weight_arrays_size];
+    for (long i = 0; i < csr_num_rows; i ++)
+        for (long j = csr_rows_offsets[i]; j < csr_rows_offsets[i+1]; j ++) {
+            cells_indexes_src[j] = csr_cols_src_indexes[j];
+            cells_indexes_dst[j] = csr_rows_dst_indexes[i];
+            weight_values[j] = csr_weight_values[j];
+        }
+    coo_is_released = false;
+
+    return true;
 }
 
 
 void Remap_weight_sparse_matrix::clear_weights_info()
 {
+    restore_coo_format();
     num_weights = 0; 
     num_remaped_dst_cells_indexes = 0;
+    release_csr_format();
 }
 
 
@@ -89,10 +171,13 @@ void Remap_weight_sparse_matrix::add_weights(long *indexes_src, long index_dst,
     long i, new_array_size;
 
 
+    EXECUTION_REPORT_INTERNAL_ERROR(REPORT_ERROR, -1, !coo_is_released, "C-Coupler error0 in add_weights of Remap_weight_sparse_matrix");
+    csr_is_up_to_date = false;
+
     if (is_real_weight) {
         for (i = 0; i < num_added_weights; i ++)
-            EXECUTION_REPORT(REPORT_ERROR, -1, indexes_src[i] >= 0 && indexes_src[i] < remap_operator->get_src_grid()->get_grid_size(), "C-Coupler error1 in add_weights of Remap_weight_sparse_matrix");
-        EXECUTION_REPORT(REPORT_ERROR, -1, remap_operator->get_dst_grid() != NULL && index_dst >= 0 && index_dst < remap_operator->get_dst_grid()->get_grid_size(), "C-Coupler error2 in add_weights of Remap_weight_sparse_matrix");
+            EXECUTION_REPORT_INTERNAL_ERROR(REPORT_ERROR, -1, indexes_src[i] >= 0 && indexes_src[i] < remap_operator->get_src_grid()->get_grid_size(), "C-Coupler error1 in add_weights of Remap_weight_sparse_matrix");
+        EXECUTION_REPORT_INTERNAL_ERROR(REPORT_ERROR, -1, remap_operator->get_dst_grid() != NULL && index_dst >= 0 && index_dst < remap_operator->get_dst_grid()->get_grid_size(), "C-Coupler error2 in add_weights of Remap_weight_sparse_matrix");
     }
     
     if (num_weights + num_added_weights > weight_arrays_size) {
@@ -134,27 +219,170 @@ void Remap_weight_sparse_matrix::add_weights(long *indexes_src, long index_dst,
 }
 
 
+/* When the COO weights have been released, the weight is read from the CSR weights in the order of restore_coo_format */
 void Remap_weight_sparse_matrix::get_weight(long *index_src, long *index_dst, double *weight_value, int index_weight)
 {
+    long low, high, mid;
+
+
     EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR, -1, index_weight >= 0 && index_weight < num_weights, "software error when get remapping weight of sparse matrix\n");
+    if (coo_is_released) {
+        for (low = 0, high = csr_num_rows-1; low < high; ) {
+            mid = (low+high+1) / 2;
+            if (csr_rows_offsets[mid] <= index_weight)
+                low = mid;
+            else high = mid - 1;
+        }
+        *index_src = csr_cols_src_indexes[index_weight];
+        *index_dst = csr_rows_dst_indexes[low];
+        *weight_value = csr_weight_values[index_weight];
+        return;
+    }
     *index_src = cells_indexes_src[index_weight];
     *index_dst = cells_indexes_dst[index_weight];
     *weight_value = weight_values[index_weight];
 }
 
 
-void Remap_weight_sparse_matrix::remap_values(double *data_values_src, double *data_values_dst, int dst_array_size)
+/* Convert the weights into a CSR format sorted by dst cells, which is used for executing the remapping. 
+   The weights of each dst cell keep their original order so that the results are bit-identical to 
+   accumulating the weights in the original order. */
+void Remap_weight_sparse_matrix::finalize_weights()
 {
-    for (long i = 0; i < num_remaped_dst_cells_indexes; i ++)
-        data_values_dst[remaped_dst_cells_indexes[i]] = 0.0;
+    long i, j, max_dst_index = -1, max_src_index = -1, num_slots, *slots_offsets, *slots_cursors;
+    char *slots_status;
+    bool have_rows_keeping_dst_values = false;
 
-    for (long i = 0; i < num_weights; i ++)
-        data_values_dst[cells_indexes_dst[i]] += data_values_src[cells_indexes_src[i]] * weight_values[i];
+
+    if (coo_is_released)
+        return;
+
+    release_csr_format();
+
+    for (i = 0; i < num_weights; i ++) {
+        if (max_dst_index < cells_indexes_dst[i])
+            max_dst_index = cells_indexes_dst[i];
+        if (max_src_index < cells_indexes_src[i])
+            max_src_index = cells_indexes_src[i];
+    }
+    for (i = 0; i < num_remaped_dst_cells_indexes; i ++)
+        if (max_dst_index < remaped_dst_cells_indexes[i])
+            max_dst_index = remaped_dst_cells_indexes[i];
+    EXECUTION_REPORT(REPORT_ERROR, -1, max_dst_index < INT_MAX && max_src_index < INT_MAX, "Software error in Remap_weight_sparse_matrix::finalize_weights: the index of grid cell is too large (%ld %ld)", max_src_index, max_dst_index);
+
+    num_slots = max_dst_index + 1;
+    slots_offsets = new long [num_slots+1];
+    slots_status = new char [num_slots+1];
+    memset(slots_offsets, 0, sizeof(long)*(num_slots+1));
+    memset(slots_status, 0, sizeof(char)*(num_slots+1));
+    for (i = 0; i < num_weights; i ++) {
+        slots_offsets[cells_indexes_dst[i]+1] ++;
+        slots_status[cells_indexes_dst[i]] |= 1;
+    }
+    for (i = 0; i < num_remaped_dst_cells_indexes; i ++)
+        slots_status[remaped_dst_cells_indexes[i]] |= 2;
+    for (i = 0; i < num_slots; i ++) {
+        slots_offsets[i+1] += slots_offsets[i];
+        if (slots_status[i] != 0)
+            csr_num_rows ++;
+        if (slots_status[i] == 1)
+            have_rows_keeping_dst_values = true;
+    }
+
+    csr_cols_src_indexes = new int [num_weights+1];
+    csr_weight_values = new double [num_weights+1];
+    slots_cursors = new long [num_slots+1];
+    memcpy(slots_cursors, slots_offsets, sizeof(long)*(num_slots+1));
+    for (i = 0; i < num_weights; i ++) {
+        j = slots_cursors[cells_indexes_dst[i]] ++;
+        csr_cols_src_indexes[j] = (int) cells_indexes_src[i];
+        csr_weight_values[j] = weight_values[i];
+    }
+    delete [] slots_cursors;
+
+    csr_rows_dst_indexes = new int [csr_num_rows+1];
+    csr_rows_offsets = new long [csr_num_rows+1];
+    if (have_rows_keeping_dst_values)
+        csr_rows_keeping_dst_values = new bool [csr_num_rows+1];
+    for (i = 0, j = 0; i < num_slots; i ++) {
+        if (slots_status[i] == 0)
+            continue;
+        csr_rows_dst_indexes[j] = (int) i;
+        csr_rows_offsets[j] = slots_offsets[i];
+        if (have_rows_keeping_dst_values)
+            csr_rows_keeping_dst_values[j] = slots_status[i] == 1;
+        j ++;
+    }
+    csr_rows_offsets[csr_num_rows] = num_weights;
+
+    delete [] slots_offsets;
+    delete [] slots_status;
+    csr_is_up_to_date = true;
+}
+
+
+void Remap_weight_sparse_matrix::remap_values(double *data_values_src, double *data_values_dst, int dst_array_size, int num_threads)
+{
+    double row_value;
+
+
+    if (!csr_is_up_to_date)
+        finalize_weights();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(row_value) num_threads(num_threads) if(num_threads > 1 && csr_num_rows >= MIN_NUM_ROWS_PER_REMAP_THREAD*2)
+#endif
+    for (long i = 0; i < csr_num_rows; i ++) {
+        row_value = (csr_rows_keeping_dst_values != NULL && csr_rows_keeping_dst_values[i])? data_values_dst[csr_rows_dst_indexes[i]] : 0.0;
+        for (long j = csr_rows_offsets[i]; j < csr_rows_offsets[i+1]; j ++)
+            row_value += data_values_src[csr_cols_src_indexes[j]] * csr_weight_values[j];
+        data_values_dst[csr_rows_dst_indexes[i]] = row_value;
+    }
+}
+
+
+/* Apply the weights to several columns (e.g., the levels of a 3D field) in one pass, so that each weight is loaded only once 
+   for a batch of columns. The results of each column are bit-identical to remap_values. Each row is computed by only one 
+   thread in the same order, so the threaded results are also bit-identical to the serial ones. */
+void Remap_weight_sparse_matrix::remap_values_of_multi_columns(double **data_values_src, double **data_values_dst, int num_columns, int num_threads)
+{
+    double rows_values[MAX_NUM_BATCHED_REMAP_COLUMNS], weight_value;
+    int col_beg, num_batched_columns, k, src_index, dst_index;
+
+
+    if (!csr_is_up_to_date)
+        finalize_weights();
+
+    for (col_beg = 0; col_beg < num_columns; col_beg += MAX_NUM_BATCHED_REMAP_COLUMNS) {
+        num_batched_columns = num_columns - col_beg < MAX_NUM_BATCHED_REMAP_COLUMNS? num_columns - col_beg : MAX_NUM_BATCHED_REMAP_COLUMNS;
+        double **batched_values_src = data_values_src + col_beg;
+        double **batched_values_dst = data_values_dst + col_beg;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(rows_values, weight_value, k, src_index, dst_index) num_threads(num_threads) if(num_threads > 1 && csr_num_rows >= MIN_NUM_ROWS_PER_REMAP_THREAD*2)
+#endif
+        for (long i = 0; i < csr_num_rows; i ++) {
+            dst_index = csr_rows_dst_indexes[i];
+            if (csr_rows_keeping_dst_values != NULL && csr_rows_keeping_dst_values[i])
+                for (k = 0; k < num_batched_columns; k ++)
+                    rows_values[k] = batched_values_dst[k][dst_index];
+            else for (k = 0; k < num_batched_columns; k ++)
+                rows_values[k] = 0.0;
+            for (long j = csr_rows_offsets[i]; j < csr_rows_offsets[i+1]; j ++) {
+                src_index = csr_cols_src_indexes[j];
+                weight_value = csr_weight_values[j];
+                for (k = 0; k < num_batched_columns; k ++)
+                    rows_values[k] += batched_values_src[k][src_index] * weight_value;
+            }
+            for (k = 0; k < num_batched_columns; k ++)
+                batched_values_dst[k][dst_index] = rows_values[k];
+        }
+    }
 }
 
 
 void Remap_weight_sparse_matrix::calc_src_decomp(long *decomp_map_src, const long *decomp_map_dst)
 {
+    restore_coo_format();
     for (long i = 0; i < num_weights; i ++)
         decomp_map_src[cells_indexes_src[i]] = (decomp_map_src[cells_indexes_src[i]] | decomp_map_dst[cells_indexes_dst[i]]);
 }
@@ -165,6 +393,7 @@ Remap_weight_sparse_matrix *Remap_weight_sparse_matrix::duplicate_remap_weight_o
     Remap_weight_sparse_matrix *duplicated_remap_weight_of_sparse_matrix;
 
 
+    restore_coo_format();
     duplicated_remap_weight_of_sparse_matrix = new Remap_weight_sparse_matrix(remap_operator);
     duplicated_remap_weight_of_sparse_matrix->weight_arrays_size = this->weight_arrays_size;
     duplicated_remap_weight_of_sparse_matrix->num_weights = this->num_weights;
@@ -196,6 +425,7 @@ Remap_weight_sparse_matrix *Remap_weight_sparse_matrix::generate_parallel_remap_
     EXECUTION_REPORT(REPORT_ERROR, -1, decomp_original_grids[0]->is_subset_of_grid(remap_operator->get_src_grid()) && decomp_original_grids[1]->is_subset_of_grid(remap_operator->get_dst_grid()), 
                  "C-Coupler error1 in generate_parallel_remap_weight_of_sparse_matrix\n");
 
+    restore_coo_format();
     parallel_remap_weight_of_sparse_matrix = new Remap_weight_sparse_matrix(remap_operator);
     num_parallel_weights = 0;
     num_remaped_dst_cells = 0;
@@ -235,6 +465,7 @@ Remap_weight_sparse_matrix *Remap_weight_sparse_matrix::generate_parallel_remap_
         for (i = 0; i < this->num_remaped_dst_cells_indexes; i ++) 
             if (global_cells_local_indexes_in_decomps[1][this->remaped_dst_cells_indexes[i]] != -1)
                 parallel_remap_weight_of_sparse_matrix->remaped_dst_cells_indexes[num_remaped_dst_cells++] = global_cells_local_indexes_in_decomps[1][this->remaped_dst_cells_indexes[i]];
+        parallel_remap_weight_of_sparse_matrix->release_coo_format();
     }
     else if (decomp_original_grids[0]->get_num_dimensions() == 3) {
         EXECUTION_REPORT(REPORT_ERROR, -1, false, "the parallelization of 3D remapping algorithm has not been supported now\n");
@@ -249,6 +480,8 @@ Remap_weight_sparse_matrix *Remap_weight_sparse_matrix::generate_parallel_remap_
 
 void Remap_weight_sparse_matrix::compare_to_another_sparse_matrix(Remap_weight_sparse_matrix *another_sparse_matrix)
 {
+    restore_coo_format();
+    another_sparse_matrix->restore_coo_format();
     EXECUTION_REPORT(REPORT_ERROR, -1, this->num_weights == another_sparse_matrix->num_weights, "C-Coupler error1 in compare_to_another_sparse_matrix");
     EXECUTION_REPORT(REPORT_ERROR, -1, this->num_remaped_dst_cells_indexes == another_sparse_matrix->num_remaped_dst_cells_indexes, "C-Coupler error2 in compare_to_another_sparse_matrix");
 
@@ -265,6 +498,7 @@ void Remap_weight_sparse_matrix::compare_to_another_sparse_matrix(Remap_weight_s
 
 void Remap_weight_sparse_matrix::print()
 {
+    restore_coo_format();
     for (int i = 0; i < num_weights; i ++)
         printf("remapping weight (%d): src_index=%d, dst_index=%d, weight_value=%lf\n", i, cells_indexes_src[i], cells_indexes_dst[i], weight_values[i]);
 }
@@ -279,7 +513,9 @@ Remap_weight_sparse_matrix *Remap_weight_sparse_matrix::gather(int comp_id)
 	long num_overall_wgts, true_num_overall_wgts, i, j, offset;
 	int *all_array_size = new int [comp_node->get_num_procs()];
 	Remap_weight_sparse_matrix *overall_sparse_matrix = NULL;
+	bool coo_was_released = coo_is_released;
 	
+	restore_coo_format();
 	gather_array_in_one_comp(comp_node->get_num_procs(), comp_node->get_current_proc_local_id(), (void*)cells_indexes_src, num_weights, sizeof(long), all_array_size, (void**)(&overall_cells_indexes_src), num_overall_wgts, comp_node->get_comm_group());
 	gather_array_in_one_comp(comp_node->get_num_procs(), comp_node->get_current_proc_local_id(), (void*)cells_indexes_dst, num_weights, sizeof(long), all_array_size, (void**)(&overall_cells_indexes_dst), num_overall_wgts, comp_node->get_comm_group());
 	gather_array_in_one_comp(comp_node->get_num_procs(), comp_node->get_current_proc_local_id(), (void*)weight_values, num_weights, sizeof(long), all_array_size, (void**)(&overall_wgt_values), num_overall_wgts, comp_node->get_comm_group());
@@ -318,6 +554,8 @@ Remap_weight_sparse_matrix *Remap_weight_sparse_matrix::gather(int comp_id)
 	}	
 
 	delete [] all_array_size;
+	if (coo_was_released)
+		release_coo_format();
 	return overall_sparse_matrix;
 }
 
@@ -14,6 +14,10 @@
 #include "remap_grid_class.h"
 
 
+#define MAX_NUM_BATCHED_REMAP_COLUMNS           16
+#define MIN_NUM_ROWS_PER_REMAP_THREAD           1024
+
+
 class Remap_operator_basis;
 
 
@@ -29,6 +33,17 @@ class Remap_weight_sparse_matrix
         long num_weights;
         long remaped_dst_cells_indexes_array_size;
         long num_remaped_dst_cells_indexes;
+        int *csr_rows_dst_indexes;
+        long *csr_rows_offsets;
+        int *csr_cols_src_indexes;
+        double *csr_weight_values;
+        bool *csr_rows_keeping_dst_values;
+        long csr_num_rows;
+        bool csr_is_up_to_date;
+        bool coo_is_released;
+
+        void initialize_csr_format();
+        void release_csr_format();
         
     public:
         Remap_weight_sparse_matrix(Remap_operator_basis*);
@@ -37,7 +52,11 @@ class Remap_weight_sparse_matrix
         void clear_weights_info();
         void add_weights(long*, long, double*, int, bool);
         void get_weight(long*, long*, double*, int);
-        void remap_values(double*, double*, int);
+        void remap_values(double*, double*, int, int);
+        void remap_values_of_multi_columns(double**, double**, int, int);
+        void finalize_weights();
+        void release_coo_format();
+        bool restore_coo_format();
         void calc_src_decomp(long*, const long*);
         Remap_weight_sparse_matrix *duplicate_remap_weight_of_sparse_matrix();
         Remap_weight_sparse_matrix *generate_parallel_remap_weight_of_sparse_matrix(Remap_grid_class **, int **);
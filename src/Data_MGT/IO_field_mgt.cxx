@@ -224,15 +224,19 @@ void IO_output_procedure::execute()
                     comp_comm_group_mgt_mgr->get_output_data_file_header(comp_id, file_header);
                     sprintf(full_file_name, "%s.%s.h%d.nc",file_header, time_string, procedure_id);
                     if (netcdf_file_object != NULL)
-                        delete netcdf_file_object;
+                        fields_gather_scatter_mgr->release_IO_file(netcdf_file_object);
                     netcdf_file_object = new IO_netcdf(full_file_name, full_file_name, "w", true);
                     // compset_communicators_info_mgr->write_case_info(netcdf_file_object);   // to be modify shortly
                 }
             }
+            fields_gather_scatter_mgr->begin_write_session(netcdf_file_object);
+            for (int i = 0; i < data_write_field_insts.size(); i ++)
+                fields_gather_scatter_mgr->define_write_field(netcdf_file_object, data_write_field_insts[i], NULL, write_grid_name, time_mgr->get_current_date(), time_mgr->get_current_second(), false);
             for (int i = 0; i < data_write_field_insts.size(); i ++) {
                 data_write_field_insts[i]->check_field_sum("before writing data into a file");
-                fields_gather_scatter_mgr->gather_write_field(netcdf_file_object, data_write_field_insts[i], write_grid_name, time_mgr->get_current_date(), time_mgr->get_current_second(), false);
+                fields_gather_scatter_mgr->gather_write_field(netcdf_file_object, data_write_field_insts[i], NULL, write_grid_name, time_mgr->get_current_date(), time_mgr->get_current_second(), false);
             }
+            fields_gather_scatter_mgr->end_write_session(netcdf_file_object);
         }
     }
 }
@@ -212,38 +212,47 @@ void Field_mem_info::calculate_field_conservative_sum(Field_mem_info *area_field
 
 void Field_mem_info::check_field_sum(const char *hint)
 {
-    int partial_sum, total_sum;
-    long size;
+    Field_mem_info *field_inst = this;
 
 
-    if (report_error_enabled && is_registered_model_buf) {
-        MPI_Barrier(comp_comm_group_mgt_mgr->get_comm_group_of_local_comp(host_comp_id, "Field_mem_info::check_field_sum"));
-        EXECUTION_REPORT_LOG(REPORT_LOG, host_comp_id, true, "Try to check the model data buffer of the field \"%s\" registered corresponding to the code annotation \"%s\". If it fails to pass the check (the model run is stopped), please make sure corresponding model data buffer is a global variable and has not been released", field_name, annotation_mgr->get_annotation(field_instance_id, "allocate field instance"));
-        char *temp_array = new char [get_size_of_field()*get_data_type_size(get_field_data()->get_grid_data_field()->data_type_in_application)];
-        memcpy(temp_array, get_data_buf(), get_size_of_field()*get_data_type_size(get_field_data()->get_grid_data_field()->data_type_in_application));
-        memcpy(get_data_buf(), temp_array, get_size_of_field()*get_data_type_size(get_field_data()->get_grid_data_field()->data_type_in_application));
-        MPI_Barrier(comp_comm_group_mgt_mgr->get_comm_group_of_local_comp(host_comp_id, "Field_mem_info::check_field_sum"));        
-        EXECUTION_REPORT_LOG(REPORT_LOG, host_comp_id, true, "Pass the check of the model data buffer of the field \"%s\" registered corresponding to the code annotation \"%s\". If it fails to pass the check (the model run is stopped), please make sure corresponding model data buffer is a global variable and has not been released", field_name, annotation_mgr->get_annotation(field_instance_id, "allocate field instance"));
-        delete [] temp_array;
-    }
+    memory_manager->check_sum_of_fields(&field_inst, 1, hint);
+}
 
-    if (report_internal_log_enabled) {
-        size = get_data_type_size(get_field_data()->get_grid_data_field()->data_type_in_application)*get_field_data()->get_grid_data_field()->required_data_size/4;
-        partial_sum = 0;
-        for (long j = 0; j < size; j ++)
-            partial_sum += (((int*) get_data_buf())[j]);
 
-        if (decomp_id != -1) {
-            MPI_Allreduce(&partial_sum, &total_sum, 1, MPI_INT, MPI_SUM, comp_comm_group_mgt_mgr->get_comm_group_of_local_comp(host_comp_id, "Field_mem_info::check_field_sum"));
-            EXECUTION_REPORT_LOG(REPORT_LOG, host_comp_id, true, "check sum of field \"%s\" %s is %x", get_field_name(), hint, total_sum);
-//            EXECUTION_REPORT_LOG(REPORT_LOG, host_comp_id, true, "check sum of field \"%s\" %s is %x vs %x", get_field_name(), hint, total_sum, partial_sum);
-        }
-        else {
-            total_sum = partial_sum;
-            MPI_Bcast(&total_sum, 1, MPI_INT, 0, comp_comm_group_mgt_mgr->get_comm_group_of_local_comp(host_comp_id, "Field_mem_info::check_field_sum"));
-            EXECUTION_REPORT(REPORT_ERROR, host_comp_id, partial_sum == total_sum, "As an instance of the field \"%s\" is not on a horizontal grid, all its values should be the same but currently are not the same across all processes of the corresponding component model. Please check the model code related to the annotation \"%s\"", field_name, annotation_mgr->get_annotation(field_instance_id, "allocate field instance"));
-        }
+void Field_mem_info::probe_model_data_buffer()
+{
+    volatile char *data_buf = (volatile char*) get_data_buf();
+    long size = get_size_of_field()*get_data_type_size(get_data_type());
+
+
+    if (size == 0)
+        return;
+
+    EXECUTION_REPORT_LOG(REPORT_LOG, host_comp_id, true, "Try to check the model data buffer of the field \"%s\" registered corresponding to the code annotation \"%s\". If it fails to pass the check (the model run is stopped), please make sure corresponding model data buffer is a global variable and has not been released", field_name, annotation_mgr->get_annotation(field_instance_id, "allocate field instance"));
+    for (long i = 0; i < size; i += FIELD_BUFFER_PROBE_STRIDE)
+        data_buf[i] = data_buf[i];
+    data_buf[size-1] = data_buf[size-1];
+    EXECUTION_REPORT_LOG(REPORT_LOG, host_comp_id, true, "Pass the check of the model data buffer of the field \"%s\" registered corresponding to the code annotation \"%s\". If it fails to pass the check (the model run is stopped), please make sure corresponding model data buffer is a global variable and has not been released", field_name, annotation_mgr->get_annotation(field_instance_id, "allocate field instance"));
+}
+
+
+unsigned int Field_mem_info::calculate_partial_field_sum()
+{
+    const unsigned int *values = (const unsigned int*) get_data_buf();
+    long size = get_data_type_size(get_data_type())*get_size_of_field()/4, j;
+    unsigned int sums[4] = {0, 0, 0, 0};
+
+
+    for (j = 0; j+3 < size; j += 4) {
+        sums[0] += values[j];
+        sums[1] += values[j+1];
+        sums[2] += values[j+2];
+        sums[3] += values[j+3];
     }
+    for (; j < size; j ++)
+        sums[0] += values[j];
+
+    return sums[0] + sums[1] + sums[2] + sums[3];
 }
 
 
@@ -424,6 +433,93 @@ void Memory_mgt::check_sum_of_all_fields()
 }
 
 
+/* The checksums of a batch of fields are reduced with one non-blocking collective per batch. The reduction is completed
+   (and the checksums are reported with the model time of the batch) when the next batch is checked or at finalize, so that
+   the processes never wait for each other here */
+void Memory_mgt::check_sum_of_fields(Field_mem_info **fields, int num_fields, const char *hint)
+{
+    int num_undecomposed_fields = 0;
+    Time_mgt *time_mgr;
+    MPI_Comm comm;
+
+
+    if (report_error_enabled)
+        for (int i = 0; i < num_fields; i ++)
+            if (fields[i]->get_is_registered_model_buf())
+                fields[i]->probe_model_data_buffer();
+
+    if (!report_internal_log_enabled || num_fields == 0)
+        return;
+
+    for (int i = 1; i < num_fields; i ++)
+        if (fields[i]->get_host_comp_id() != fields[0]->get_host_comp_id()) {
+            for (int j = 0; j < num_fields; j ++)
+                check_sum_of_fields(fields+j, 1, hint);
+            return;
+        }
+
+    complete_pending_fields_sum_check();
+
+    comm = comp_comm_group_mgt_mgr->get_comm_group_of_local_comp(fields[0]->get_host_comp_id(), "Memory_mgt::check_sum_of_fields");
+    strncpy(pending_sum_check_hint, hint, NAME_STR_SIZE*2-1);
+    pending_sum_check_hint[NAME_STR_SIZE*2-1] = '\0';
+    time_mgr = components_time_mgrs->get_time_mgr(fields[0]->get_host_comp_id());
+    if (time_mgr != NULL) {
+        pending_sum_check_step_id = time_mgr->get_current_num_time_step();
+        pending_sum_check_date = time_mgr->get_current_date();
+        pending_sum_check_second = time_mgr->get_current_second();
+    }
+    else {
+        pending_sum_check_step_id = -1;
+        pending_sum_check_date = -1;
+        pending_sum_check_second = -1;
+    }
+    pending_sum_check_fields.assign(fields, fields+num_fields);
+    pending_sum_check_local_values.resize(num_fields*3);
+    pending_sum_check_global_values.resize(num_fields*3);
+    for (int i = 0; i < num_fields; i ++) {
+        unsigned int partial_sum = fields[i]->calculate_partial_field_sum();
+        pending_sum_check_local_values[i] = fields[i]->get_decomp_id() != -1? partial_sum : 0;
+        pending_sum_check_local_values[num_fields+i*2] = partial_sum;
+        pending_sum_check_local_values[num_fields+i*2+1] = ~partial_sum;
+        if (fields[i]->get_decomp_id() == -1)
+            num_undecomposed_fields ++;
+    }
+
+    pending_sum_check_requests[0] = MPI_REQUEST_NULL;
+    pending_sum_check_requests[1] = MPI_REQUEST_NULL;
+#if MPI_VERSION >= 3
+    MPI_Iallreduce(&pending_sum_check_local_values[0], &pending_sum_check_global_values[0], num_fields, MPI_UNSIGNED, MPI_SUM, comm, &pending_sum_check_requests[0]);
+    if (num_undecomposed_fields > 0)
+        MPI_Iallreduce(&pending_sum_check_local_values[num_fields], &pending_sum_check_global_values[num_fields], num_fields*2, MPI_UNSIGNED, MPI_MAX, comm, &pending_sum_check_requests[1]);
+#else
+    MPI_Allreduce(&pending_sum_check_local_values[0], &pending_sum_check_global_values[0], num_fields, MPI_UNSIGNED, MPI_SUM, comm);
+    if (num_undecomposed_fields > 0)
+        MPI_Allreduce(&pending_sum_check_local_values[num_fields], &pending_sum_check_global_values[num_fields], num_fields*2, MPI_UNSIGNED, MPI_MAX, comm);
+#endif
+}
+
+
+void Memory_mgt::complete_pending_fields_sum_check()
+{
+    int num_fields = pending_sum_check_fields.size();
+
+
+    if (num_fields == 0)
+        return;
+
+    MPI_Waitall(2, pending_sum_check_requests, MPI_STATUSES_IGNORE);
+    for (int i = 0; i < num_fields; i ++) {
+        Field_mem_info *field_inst = pending_sum_check_fields[i];
+        if (field_inst->get_decomp_id() != -1) {
+            EXECUTION_REPORT_LOG(REPORT_LOG, field_inst->get_host_comp_id(), true, "check sum of field \"%s\" %s at time step %d (date %08d, second %05d) is %x", field_inst->get_field_name(), pending_sum_check_hint, pending_sum_check_step_id, pending_sum_check_date, pending_sum_check_second, pending_sum_check_global_values[i]);
+        }
+        else EXECUTION_REPORT(REPORT_ERROR, field_inst->get_host_comp_id(), pending_sum_check_local_values[num_fields+i*2] == pending_sum_check_global_values[num_fields+i*2] && pending_sum_check_local_values[num_fields+i*2+1] == pending_sum_check_global_values[num_fields+i*2+1], "As an instance of the field \"%s\" is not on a horizontal grid, all its values should be the same but currently are not the same across all processes of the corresponding component model at time step %d (date %08d, second %05d). Please check the model code related to the annotation \"%s\"", field_inst->get_field_name(), pending_sum_check_step_id, pending_sum_check_date, pending_sum_check_second, annotation_mgr->get_annotation(field_inst->get_field_instance_id(), "allocate field instance"));
+    }
+    pending_sum_check_fields.clear();
+}
+
+
 int Memory_mgt::get_field_size(void *data_buf, const char *annotation)
 {
     Field_mem_info *field = search_field_via_data_buf(data_buf, false);
@@ -10,6 +10,7 @@
 #ifndef MEM_MGT
 #define MEM_MGT
 
+#include <mpi.h>
 #include <vector>
 #include "common_utils.h"
 #include "remap_grid_data_class.h"
@@ -37,6 +38,9 @@
 #define REG_FIELD_TAG_IO                         ((int)4)
 
 
+#define FIELD_BUFFER_PROBE_STRIDE                4096
+
+
 class Field_mem_info
 {
     private:
@@ -74,6 +78,8 @@ class Field_mem_info
         void change_datatype_to_double();
         void calculate_field_conservative_sum(Field_mem_info*);
         void check_field_sum(const char *);
+        void probe_model_data_buffer();
+        unsigned int calculate_partial_field_sum();
         void define_field_values(bool);
         void use_field_values(const char*);
         bool field_has_been_defined();
@@ -104,6 +110,14 @@ class Memory_mgt
 {
     private:
         std::vector<Field_mem_info *> fields_mem;
+        std::vector<Field_mem_info *> pending_sum_check_fields;
+        std::vector<unsigned int> pending_sum_check_local_values;
+        std::vector<unsigned int> pending_sum_check_global_values;
+        MPI_Request pending_sum_check_requests[2];
+        char pending_sum_check_hint[NAME_STR_SIZE*2];
+        int pending_sum_check_step_id;
+        int pending_sum_check_date;
+        int pending_sum_check_second;
         
     public: 
         Memory_mgt() {}
@@ -112,6 +126,8 @@ class Memory_mgt
          int register_external_field_instance(const char *, void *, int, int, int, int, int, const char *, const char *, const char *);
         Field_mem_info *search_field_via_data_buf(const void*, bool);
         void check_sum_of_all_fields();
+        void check_sum_of_fields(Field_mem_info **, int, const char*);
+        void complete_pending_fields_sum_check();
         int get_num_fields() { return fields_mem.size(); }
         ~Memory_mgt();
         int get_field_size(void*, const char*);
@@ -181,9 +181,38 @@ void Original_grid_info::set_unique_bottom_field(int field_id, int type, const c
 } 
 
 
+static long get_size_of_grid_field_in_array(Remap_grid_data_class *grid_field)
+{
+    if (grid_field == NULL)
+        return 0;
+    return grid_field->get_grid_data_field()->required_data_size*get_data_type_size(grid_field->get_grid_data_field()->data_type_in_application) + 4*NAME_STR_SIZE;
+}
+
+
+/* The buffer is reserved with the sizes of the coordinate, mask and vertical fields that are really written,
+   which are those of the leaf grids and the masked sub grids rather than the size of the whole grid */
 void Original_grid_info::write_grid_into_array(char **temp_array_buffer, long &buffer_max_size, long &buffer_content_size)
 {
-    get_original_CoR_grid()->write_grid_into_array(temp_array_buffer, buffer_max_size, buffer_content_size);
+    Remap_grid_class *CoR_grid = get_original_CoR_grid();
+    Remap_grid_class *sub_grids[256];
+    int num_sub_grids, i;
+    long reserved_size = 64*NAME_STR_SIZE;
+
+
+    if (*temp_array_buffer == NULL) {
+        CoR_grid->get_leaf_grids(&num_sub_grids, sub_grids, CoR_grid);
+        for (i = 0; i < num_sub_grids; i ++) {
+            if (sub_grids[i] == NULL)
+                continue;
+            reserved_size += get_size_of_grid_field_in_array(sub_grids[i]->get_grid_center_field()) + get_size_of_grid_field_in_array(sub_grids[i]->get_grid_vertex_field()) + 
+                             get_size_of_grid_field_in_array(sub_grids[i]->get_sigma_grid_sigma_value_field()) + get_size_of_grid_field_in_array(sub_grids[i]->get_hybrid_grid_coefficient_field()) + 16*NAME_STR_SIZE;
+        }
+        CoR_grid->get_masked_sub_grids(&num_sub_grids, sub_grids);
+        for (i = 0; i < num_sub_grids; i ++)
+            reserved_size += get_size_of_grid_field_in_array(sub_grids[i]->get_grid_mask_field());
+        reserve_array_buffer(reserved_size, temp_array_buffer, buffer_max_size, buffer_content_size);
+    }
+    CoR_grid->write_grid_into_array(temp_array_buffer, buffer_max_size, buffer_content_size);
 	write_data_into_array_buffer(&V3D_lev_field_variation_type, sizeof(int), temp_array_buffer, buffer_max_size, buffer_content_size);
     write_data_into_array_buffer(&bottom_field_variation_type, sizeof(int), temp_array_buffer, buffer_max_size, buffer_content_size);
     write_data_into_array_buffer(&checksum_H2D_mask, sizeof(long), temp_array_buffer, buffer_max_size, buffer_content_size);
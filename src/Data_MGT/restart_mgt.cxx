@@ -276,31 +276,32 @@ void Restart_mgt::do_restart_write(const char *annotation, bool bypass_timer, bo
             char restart_data_file_name[NAME_STR_SIZE];
             sprintf(restart_data_file_name, "%s/%s.%s.r.%08d-%05d.nc", comp_node->get_working_dir(), time_mgr->get_case_name(), comp_node->get_comp_full_name(), date, second);
             if (backup_restart_write_data_file != NULL) {
+                fields_gather_scatter_mgr->wait_for_async_IO();
                 delete backup_restart_write_data_file;
                 backup_restart_write_data_file = NULL;
             }
             restart_write_data_file = new IO_netcdf(restart_data_file_name, restart_data_file_name, "w", false);
+            fields_gather_scatter_mgr->begin_write_session(restart_write_data_file);
             sprintf(restart_data_file_name, "%s/%s.%s.r.%08d-%05d", comp_node->get_working_dir(), time_mgr->get_case_name(), comp_node->get_comp_full_name(), date, second);
             FILE *restart_mgt_info_file = fopen(restart_data_file_name, "w+");
             fclose(restart_mgt_info_file);
         }
         inout_interface_mgr->write_into_restart_buffers(comp_node->get_comp_id());
         restart_mgt_info_written = false;
-        for (int i = 0; i < restarted_field_instances.size(); i ++) {
-            if (!bypass_imported_fields)
-                write_restart_field_data(restarted_field_instances[i].first, NULL, NULL, false);
-            else if (!restarted_field_instances[i].second)
-                write_restart_field_data(restarted_field_instances[i].first, NULL, NULL, false);
-        }
+        std::vector<Field_mem_info*> field_instances_to_write;
+        for (int i = 0; i < restarted_field_instances.size(); i ++)
+            if (!bypass_imported_fields || !restarted_field_instances[i].second)
+                field_instances_to_write.push_back(restarted_field_instances[i].first);
+        for (int i = 0; i < field_instances_to_write.size(); i ++)
+            define_restart_field_data(field_instances_to_write[i], NULL, NULL, false);
+        for (int i = 0; i < field_instances_to_write.size(); i ++)
+            write_restart_field_data(field_instances_to_write[i], NULL, NULL, false);
     }
 }
 
 
 void Restart_mgt::get_field_IO_name(char *field_IO_name, Field_mem_info *field_instance, const char *interface_name, const char*label, bool use_time_info)
 {
-    Field_mem_info *global_field = fields_gather_scatter_mgr->gather_field(field_instance);
-
-
     if (interface_name != NULL) {
         if (use_time_info)
             sprintf(field_IO_name, "%s.%s.%s.%13ld", field_instance->get_field_name(), interface_name, label, time_mgr->get_current_full_time());
@@ -319,22 +320,31 @@ void Restart_mgt::get_field_IO_name(char *field_IO_name, Field_mem_info *field_i
 }
 
 
+void Restart_mgt::define_restart_field_data(Field_mem_info *field_instance, const char *interface_name, const char*label, bool use_time_info)
+{
+    char field_IO_name[NAME_STR_SIZE*2];
+
+
+    get_field_IO_name(field_IO_name, field_instance, interface_name, label, use_time_info);
+    fields_gather_scatter_mgr->define_write_field(comp_node->get_current_proc_local_id() == 0? restart_write_data_file : NULL, field_instance, field_IO_name, true, -1, -1, true);
+}
+
+
 void Restart_mgt::write_restart_field_data(Field_mem_info *field_instance, const char *interface_name, const char*label, bool use_time_info)
 {
-    Field_mem_info *global_field = fields_gather_scatter_mgr->gather_field(field_instance);
     char field_IO_name[NAME_STR_SIZE*2], hint[NAME_STR_SIZE*2];
+    IO_netcdf *active_restart_write_data_file = NULL;
 
 
     get_field_IO_name(field_IO_name, field_instance, interface_name, label, use_time_info);
     if (comp_node->get_current_proc_local_id() == 0) {
-        strcpy(global_field->get_field_data()->get_grid_data_field()->field_name_in_IO_file, field_IO_name);
         EXECUTION_REPORT(REPORT_ERROR, -1, restart_write_data_file != NULL && backup_restart_write_data_file == NULL || restart_write_data_file == NULL && backup_restart_write_data_file != NULL, "Software error in Restart_mgt::write_restart_field_data");
-        IO_netcdf *active_restart_write_data_file = restart_write_data_file != NULL? restart_write_data_file : backup_restart_write_data_file;
-        EXECUTION_REPORT_LOG(REPORT_LOG, comp_node->get_comp_id(), true, "Write variable \"%s\" into restart data file \"%s\"", global_field->get_field_data()->get_grid_data_field()->field_name_in_IO_file, active_restart_write_data_file->get_file_name());
-        active_restart_write_data_file->write_grided_data(global_field->get_field_data(), true, -1, -1, true);
+        active_restart_write_data_file = restart_write_data_file != NULL? restart_write_data_file : backup_restart_write_data_file;
+        EXECUTION_REPORT_LOG(REPORT_LOG, comp_node->get_comp_id(), true, "Write variable \"%s\" into restart data file \"%s\"", field_IO_name, active_restart_write_data_file->get_file_name());
         sprintf(hint, "restart writing field \"%s\" to the file \"%s\"", field_IO_name, active_restart_write_data_file->get_file_name());
     }
     else sprintf(hint, "restart writing field \"%s\" to the file", field_IO_name);
+    fields_gather_scatter_mgr->gather_write_field(active_restart_write_data_file, field_instance, field_IO_name, true, -1, -1, true);
     field_instance->check_field_sum(hint);
 }
 
@@ -440,6 +450,9 @@ void Restart_mgt::write_restart_mgt_into_file()
     fwrite(array_buffer, buffer_content_size, 1, restart_file);
     fclose(restart_file);
     delete [] array_buffer;    
+    EXECUTION_REPORT(REPORT_ERROR, -1, restart_write_data_file != NULL, "Software error in Restart_mgt::write_restart_mgt_into_file");
+    fields_gather_scatter_mgr->end_write_session(restart_write_data_file);
+    fields_gather_scatter_mgr->wait_for_async_IO();
     sprintf(rpointer_file_name, "%s/rpointer.%s", comp_comm_group_mgt_mgr->get_restart_common_dir(), comp_node->get_full_name());
     if (does_file_exist(rpointer_file_name)) {
         rpointer_file = fopen(rpointer_file_name, "r");
@@ -454,8 +467,6 @@ void Restart_mgt::write_restart_mgt_into_file()
     fprintf(rpointer_file, "%s.%s.r.%08d-%05d\n", time_mgr->get_case_name(), comp_node->get_comp_full_name(), date, second);
     fclose(rpointer_file);
     EXECUTION_REPORT_LOG(REPORT_LOG, comp_node->get_comp_id(), true, "Write restart mgt information into the file \"%s\"", restart_file_name);
-    EXECUTION_REPORT(REPORT_ERROR, -1, restart_write_data_file != NULL, "Software error in Restart_mgt::write_restart_mgt_into_file");
-
     backup_restart_write_data_file = restart_write_data_file;
     restart_write_data_file = NULL;
 
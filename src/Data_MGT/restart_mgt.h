@@ -95,6 +95,7 @@ class Restart_mgt
         Restart_buffer_container *apply_restart_buffer(const char *, const char *, const char *);
         bool is_in_restart_write_window(long, bool);
         bool is_in_restart_read_window(long);
+        void define_restart_field_data(Field_mem_info *, const char*, const char*, bool);
         void write_restart_field_data(Field_mem_info *, const char*, const char*, bool);
         void read_restart_field_data(Field_mem_info *, const char *, const char *, bool, const char *, bool, const char*);
         const char *get_restart_read_data_file_name() { return restart_read_data_file_name; }
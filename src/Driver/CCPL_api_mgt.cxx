@@ -243,6 +243,9 @@ void get_API_hint(int comp_id, int API_id, char *API_label)
 		case API_ID_INTERFACE_GET_SENDER_TIME:
 			sprintf(API_label, "CCPL_get_import_fields_sender_time");
 			break;
+		case API_ID_INTERFACE_COMPLETE_EXPORT:
+			sprintf(API_label, "CCPL_complete_export_interface");
+			break;
         case API_ID_COMP_MGT_GET_LOCAL_COMP_FULL_NAME:
             sprintf(API_label, "CCPL_get_local_comp_full_name");
             break;
@@ -267,6 +270,9 @@ void get_API_hint(int comp_id, int API_id, char *API_label)
         case API_ID_REPORT_PROGRESS:
             sprintf(API_label, "CCPL_report_progress");
             break;    
+        case API_ID_REPORT_TIMING_SUMMARY:
+            sprintf(API_label, "CCPL_report_timing_summary");
+            break;
         case API_ID_REPORT_ERROR:
             sprintf(API_label, "CCPL_report_error");
             break;    
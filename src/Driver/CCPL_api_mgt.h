@@ -92,9 +92,11 @@ enum
     API_ID_INTERFACE_EXECUTE_WITH_NAME,
     API_ID_INTERFACE_CHECK_IMPORT_FIELD_CONNECTED,
     API_ID_INTERFACE_GET_SENDER_TIME,
+    API_ID_INTERFACE_COMPLETE_EXPORT,
     API_ID_REPORT_LOG,
     API_ID_REPORT_ERROR,
     API_ID_REPORT_PROGRESS,
+    API_ID_REPORT_TIMING_SUMMARY,
     API_ID_RESTART_MGT_WRITE_IO,
     API_ID_RESTART_MGT_START_READ_IO,
     API_ID_RESTART_MGT_IS_TIMER_ON,
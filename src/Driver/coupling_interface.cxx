@@ -59,8 +59,10 @@ extern "C" void finalize_ccpl_
     if (comp_comm_group_mgt_mgr->get_current_proc_global_id() == 0)
         EXECUTION_REPORT(REPORT_PROGRESS, -1, true, "Start to finalize C-Coupler at the model code with the annotation \"%s\"", annotation);
 
-    comp_comm_group_mgt_mgr->output_performance_timing();
     inout_interface_mgr->free_all_MPI_wins();
+    fields_gather_scatter_mgr->wait_for_async_IO();
+    comp_comm_group_mgt_mgr->output_performance_timing();
+    memory_manager->complete_pending_fields_sum_check();
 
     delete annotation_mgr;
     delete decomps_info_mgr;
@@ -1564,6 +1566,22 @@ extern "C" void get_ccpl_import_fields_sender_time_
 }
 
 
+#ifdef LINK_WITHOUT_UNDERLINE
+extern "C" void complete_ccpl_export_interface
+#else
+extern "C" void complete_ccpl_export_interface_
+#endif
+(int *interface_id, const char *annotation)
+{
+	EXECUTION_REPORT_LOG(REPORT_LOG, -1, true, "Start to complete the data sending of an export interface");
+	check_for_ccpl_managers_allocated(API_ID_INTERFACE_COMPLETE_EXPORT, annotation);
+    Inout_interface *export_interface = inout_interface_mgr->get_interface(*interface_id);
+    EXECUTION_REPORT(REPORT_ERROR, -1, export_interface != NULL, "ERROR happens when calling the API \"CCPL_complete_export_interface\": the parameter \"interface_id\" is not a legal ID of a coupling interface. Please verify the model code with the annotation \"%s\".", annotation);
+	export_interface->complete_export(annotation);
+	EXECUTION_REPORT_LOG(REPORT_LOG, -1, true, "Finish completing the data sending of an export interface");
+}
+
+
 #ifdef LINK_WITHOUT_UNDERLINE
 extern "C" void execute_inout_interface_with_id
 #else
@@ -1632,3 +1650,18 @@ extern "C" void ccpl_report_
     EXECUTION_REPORT(*report_type, *comp_id, local_condition, report_content);
 }
 
+
+#ifdef LINK_WITHOUT_UNDERLINE
+extern "C" void report_ccpl_timing_summary
+#else
+extern "C" void report_ccpl_timing_summary_
+#endif
+(int *comp_id, const char *annotation)
+{
+    check_for_component_registered(*comp_id, API_ID_REPORT_TIMING_SUMMARY, annotation, false);
+    EXECUTION_REPORT_LOG(REPORT_LOG, *comp_id, true, "Start to summarize the performance timing of the component model over all its processes");
+    synchronize_comp_processes_for_API(*comp_id, API_ID_REPORT_TIMING_SUMMARY, comp_comm_group_mgt_mgr->get_comm_group_of_local_comp(*comp_id, "report_ccpl_timing_summary_"), "summarizing the performance timing", annotation);
+    comp_comm_group_mgt_mgr->get_global_node_of_local_comp(*comp_id, true, "report_ccpl_timing_summary_")->summarize_performance_timing();
+    EXECUTION_REPORT_LOG(REPORT_LOG, *comp_id, true, "Finish summarizing the performance timing of the component model over all its processes");
+}
+
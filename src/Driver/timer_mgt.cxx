@@ -398,6 +398,7 @@ Time_mgt::Time_mgt(int comp_id, const char *XML_file_name, bool is_for_root_comp
     EXECUTION_REPORT(REPORT_ERROR, -1, comp_comm_group_mgt_mgr->is_legal_local_comp_id(comp_id,false), "Software error in Time_mgt::Time_mgt: wrong component id");
     this->comp_id = comp_id;
     this->restart_timer = NULL;
+    this->comp_performance_timing_mgr = NULL;
     this->advance_time_synchronized = false;
     this->time_has_been_advanced = false;
     {
@@ -674,6 +675,11 @@ void Time_mgt::advance_model_time(const char *annotation, bool from_external_mod
     previous_second = current_second;
     current_step_id ++;
     advance_time(current_year, current_month, current_day, current_second, current_num_elapsed_day, time_step_in_second);
+    if (from_external_model) {
+        if (comp_performance_timing_mgr == NULL)
+            comp_performance_timing_mgr = comp_comm_group_mgt_mgr->search_global_node(comp_id)->get_performance_timing_mgr();
+        comp_performance_timing_mgr->performance_timing_set_step(current_step_id);
+    }
 }
 
 
@@ -892,6 +898,7 @@ Time_mgt *Time_mgt::clone_time_mgr(int comp_id)
     new_time_mgr->rest_refdate = this->rest_refdate;
     new_time_mgr->rest_refsecond = this->rest_refsecond;
     new_time_mgr->restart_timer = NULL;
+    new_time_mgr->comp_performance_timing_mgr = NULL;
     new_time_mgr->time_has_been_advanced = false;
 
     return new_time_mgr;
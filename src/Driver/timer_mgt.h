@@ -79,6 +79,7 @@
 
 
 class Time_mgt;
+class Performance_timing_mgt;
 
 
 class Coupling_timer
@@ -170,6 +171,7 @@ class Time_mgt
         long num_total_steps;
         bool leap_year_on;
         Coupling_timer *restart_timer;
+        Performance_timing_mgt *comp_performance_timing_mgr;
         int comp_id;
         char case_name[NAME_STR_SIZE];
         char exp_model_name[NAME_STR_SIZE];
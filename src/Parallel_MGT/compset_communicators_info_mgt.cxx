@@ -17,37 +17,71 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <stddef.h>
+#ifdef USE_ASYNC_IO
+#include <pthread.h>
+#endif
 
 
 #define LOG_BUFFER_MAX_SIZE              ((int)1024*1024*5)
 #define LOG_BUFFER_MAX_CONTENT_SIZE      (LOG_BUFFER_MAX_SIZE/5*4)
 
 
+static void write_CCPL_log(const char *log_file_name, const char *log_content, int log_content_size)
+{
+    FILE *log_file = stdout;
+
+
+    if (log_content_size == 0)
+        return;
+    if (log_file_name != NULL)
+        log_file = fopen(log_file_name, "a+");
+    if (log_file == NULL)
+        return;
+    fwrite(log_content, 1, log_content_size, log_file);
+    fflush(log_file);
+    if (log_file_name != NULL)
+        fclose(log_file);
+}
+
+
+#ifdef USE_ASYNC_IO
+static pthread_mutex_t CCPL_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+/* With USE_ASYNC_IO, the background IO thread also reports, so the log buffers are protected by a lock */
 void output_CCPL_log(const char *log_string, const char *log_file_name, char **log_buffer, int &log_buffer_content_size, bool flush_log_file)
 {
+    int log_string_size = strlen(log_string);
+
+
+#ifdef USE_ASYNC_IO
+    pthread_mutex_lock(&CCPL_log_mutex);
+#endif
     if (*log_buffer == NULL) {
         *log_buffer = new char [LOG_BUFFER_MAX_SIZE];
-        *log_buffer[0] = '\0';
         log_buffer_content_size = 0;
     }
 
-    strcat(*log_buffer, log_string);
-    log_buffer_content_size += strlen(log_string);
-
-    if (log_buffer_content_size >= LOG_BUFFER_MAX_CONTENT_SIZE)
-        flush_log_file = true;
-
-    if (flush_log_file) {
-        FILE *log_file = stdout;
-        if (log_file_name != NULL)
-            log_file = fopen(log_file_name, "a+");
-        fprintf(log_file, *log_buffer);
-        fflush(log_file);
-        if (log_file_name != NULL)
-            fclose(log_file);
-        *log_buffer[0] = '\0';
+    if (log_buffer_content_size + log_string_size >= LOG_BUFFER_MAX_SIZE) {
+        write_CCPL_log(log_file_name, *log_buffer, log_buffer_content_size);
+        log_buffer_content_size = 0;
+    }
+    if (log_string_size >= LOG_BUFFER_MAX_SIZE)
+        write_CCPL_log(log_file_name, log_string, log_string_size);
+    else {
+        memcpy(*log_buffer+log_buffer_content_size, log_string, log_string_size);
+        log_buffer_content_size += log_string_size;
+    }
+
+    if (log_buffer_content_size >= LOG_BUFFER_MAX_CONTENT_SIZE || flush_log_file) {
+        write_CCPL_log(log_file_name, *log_buffer, log_buffer_content_size);
         log_buffer_content_size = 0;
     }
+#ifdef USE_ASYNC_IO
+    pthread_mutex_unlock(&CCPL_log_mutex);
+#endif
 }
 
 
@@ -115,6 +149,122 @@ void create_directory(const char *path, MPI_Comm comm, bool is_root_proc, bool n
 }
 
 
+#if MPI_VERSION >= 3
+Comp_info_registry::Comp_info_registry(MPI_Comm comm)
+{
+    EXECUTION_REPORT(REPORT_ERROR, -1, MPI_Comm_size(comm, &num_total_procs) == MPI_SUCCESS);
+    num_total_slots = ((long)num_total_procs) * COMP_INFO_REGISTRY_SLOTS_PER_PROC;
+    local_slots = new Comp_info_registry_slot [COMP_INFO_REGISTRY_SLOTS_PER_PROC];
+    memset(local_slots, 0, sizeof(Comp_info_registry_slot)*COMP_INFO_REGISTRY_SLOTS_PER_PROC);
+    EXECUTION_REPORT(REPORT_ERROR, -1, MPI_Win_create(local_slots, sizeof(Comp_info_registry_slot)*COMP_INFO_REGISTRY_SLOTS_PER_PROC, sizeof(char), MPI_INFO_NULL, comm, &registry_win) == MPI_SUCCESS);
+}
+
+
+Comp_info_registry::~Comp_info_registry()
+{
+    MPI_Win_free(&registry_win);
+    delete [] local_slots;
+}
+
+
+unsigned long Comp_info_registry::get_name_hash(const char *full_name)
+{
+    unsigned long hash = 5381;
+
+
+    for (int i = 0; full_name[i] != '\0'; i ++)
+        hash = hash * 33 + (unsigned char) full_name[i];
+
+    return hash;
+}
+
+
+void Comp_info_registry::get_slot_location(unsigned long name_hash, long probe_id, int &target_proc, MPI_Aint &slot_disp)
+{
+    long slot_id = (long) ((name_hash + probe_id) % num_total_slots);
+
+
+    target_proc = slot_id / COMP_INFO_REGISTRY_SLOTS_PER_PROC;
+    slot_disp = (MPI_Aint) ((slot_id % COMP_INFO_REGISTRY_SLOTS_PER_PROC) * sizeof(Comp_info_registry_slot));
+}
+
+
+bool Comp_info_registry::publish_comp_info(const char *full_name, const char *content, int content_size)
+{
+    int empty_state = COMP_INFO_SLOT_EMPTY, writing_state = COMP_INFO_SLOT_WRITING, ready_state = COMP_INFO_SLOT_READY, original_state, target_proc;
+    unsigned long name_hash = get_name_hash(full_name);
+    Comp_info_registry_slot slot;
+    MPI_Aint slot_disp;
+    long put_size;
+
+
+    if (strlen(full_name) >= NAME_STR_SIZE)
+        return false;
+
+    strcpy(slot.full_name, full_name);
+    slot.content_size = -1;
+    if (content_size <= COMP_INFO_REGISTRY_CONTENT_SIZE) {
+        slot.content_size = content_size;
+        memcpy(slot.content, content, content_size);
+    }
+    put_size = offsetof(Comp_info_registry_slot, content) + (slot.content_size > 0? slot.content_size : 0) - offsetof(Comp_info_registry_slot, content_size);
+
+    for (long i = 0; i < num_total_slots; i ++) {
+        get_slot_location(name_hash, i, target_proc, slot_disp);
+        MPI_Win_lock(MPI_LOCK_SHARED, target_proc, 0, registry_win);
+        MPI_Compare_and_swap(&writing_state, &empty_state, &original_state, MPI_INT, target_proc, slot_disp, registry_win);
+        MPI_Win_flush(target_proc, registry_win);
+        if (original_state == COMP_INFO_SLOT_EMPTY) {
+            MPI_Put(&slot.content_size, put_size, MPI_CHAR, target_proc, slot_disp+offsetof(Comp_info_registry_slot, content_size), put_size, MPI_CHAR, registry_win);
+            MPI_Win_flush(target_proc, registry_win);
+            MPI_Accumulate(&ready_state, 1, MPI_INT, target_proc, slot_disp, 1, MPI_INT, MPI_REPLACE, registry_win);
+        }
+        MPI_Win_unlock(target_proc, registry_win);
+        if (original_state == COMP_INFO_SLOT_EMPTY)
+            return true;
+    }
+
+    return false;
+}
+
+
+int Comp_info_registry::lookup_comp_info(const char *full_name, char **content)
+{
+    int slot_state, target_proc;
+    unsigned long name_hash = get_name_hash(full_name);
+    Comp_info_registry_slot slot;
+    MPI_Aint slot_disp;
+    long get_size = sizeof(Comp_info_registry_slot) - offsetof(Comp_info_registry_slot, content_size);
+
+
+    for (long i = 0; i < num_total_slots; ) {
+        get_slot_location(name_hash, i, target_proc, slot_disp);
+        MPI_Win_lock(MPI_LOCK_SHARED, target_proc, 0, registry_win);
+        MPI_Fetch_and_op(NULL, &slot_state, MPI_INT, target_proc, slot_disp, MPI_NO_OP, registry_win);
+        MPI_Win_flush(target_proc, registry_win);
+        if (slot_state == COMP_INFO_SLOT_READY)
+            MPI_Get(&slot.content_size, get_size, MPI_CHAR, target_proc, slot_disp+offsetof(Comp_info_registry_slot, content_size), get_size, MPI_CHAR, registry_win);
+        MPI_Win_unlock(target_proc, registry_win);
+        if (slot_state != COMP_INFO_SLOT_READY) {
+            usleep(COMP_INFO_REGISTRY_POLL_INTERVAL);
+            continue;
+        }
+        if (!words_are_the_same(slot.full_name, full_name)) {
+            i ++;
+            continue;
+        }
+        if (slot.content_size <= 0)
+            return -1;
+        *content = new char [slot.content_size];
+        memcpy(*content, slot.content, slot.content_size);
+        return slot.content_size;
+    }
+
+    return -1;
+}
+#endif
+
+
 Comp_comm_group_mgt_node::~Comp_comm_group_mgt_node()
 {
     if (performance_timing_mgr != NULL)
@@ -310,6 +460,7 @@ Comp_comm_group_mgt_node::Comp_comm_group_mgt_node(const char *comp_name, const
         write_node_into_XML(root_element);
         EXECUTION_REPORT(REPORT_ERROR, -1, XML_file->SaveFile(XML_file_name), "Software error in Comp_comm_group_mgt_node::Comp_comm_group_mgt_node: fail to write the XML file %s", XML_file_name);
         delete XML_file;
+        comp_comm_group_mgt_mgr->publish_comp_info(this);
     }
 
     EXECUTION_REPORT_LOG(REPORT_LOG, -1, true, "Finish registering the component model \%s\"", full_name);
@@ -341,33 +492,34 @@ Comp_comm_group_mgt_node::Comp_comm_group_mgt_node(TiXmlElement *XML_element, co
     EXECUTION_REPORT(REPORT_ERROR, -1, words_are_the_same(specified_full_name, XML_full_name), "Software error in Comp_comm_group_mgt_node::Comp_comm_group_mgt_node: the full name specified is different from the full name in XML file %s: %s vs %s", XML_file_name, specified_full_name, XML_full_name);
     strcpy(this->full_name, XML_full_name);
     strcpy(this->comp_type, XML_comp_type);
-    int segment_start, segment_end;
-    for (int i = 1; i < strlen(XML_processes)+1; i ++) {
-        if (XML_processes[i-1] == ' ') {
-            segment_start = XML_processes[i]-'0';
-            segment_end = -1;
-            EXECUTION_REPORT(REPORT_ERROR, -1, segment_start >= 0 && segment_start <= 9, "Software error in Comp_comm_group_mgt_node::Comp_comm_group_mgt_node: wrong format");
-        }
-        else if (XML_processes[i-1] == '~') {
-            segment_end = XML_processes[i]-'0';
-            EXECUTION_REPORT(REPORT_ERROR, -1, segment_end >= 0 && segment_end <= 9, "Software error in Comp_comm_group_mgt_node::Comp_comm_group_mgt_node: wrong format");
-        }
-        else if (XML_processes[i] == ' ' || XML_processes[i] == '\0') {
-            if (segment_end == -1)
-                local_processes_global_ids.push_back(segment_start);
-            else {
-                for (int j = segment_start; j <= segment_end; j ++)
-                    local_processes_global_ids.push_back(j);
-            }
-        }
-        else if (XML_processes[i] != '~') {
-            int digit = XML_processes[i] - '0';            
-            EXECUTION_REPORT(REPORT_ERROR, -1, digit >= 0 && digit <= 9, "Software error in Comp_comm_group_mgt_node::Comp_comm_group_mgt_node: wrong format");
-            if (segment_end == -1)
-                segment_start = segment_start * 10 + digit;
-            else segment_end = segment_end * 10 + digit;
-        }
-    }
+    load_processes_from_string(XML_processes);
+
+    current_proc_local_id = -1;
+    parent = NULL;
+    restart_mgr = NULL;
+}
+
+
+Comp_comm_group_mgt_node::Comp_comm_group_mgt_node(const char *array_buffer, long buffer_content_iter, const char *specified_full_name)
+{
+    long str_size;
+    char *processes_string;
+
+
+    comp_id = -1;
+    temp_array_buffer = NULL;
+    proc_latest_model_time = NULL;
+    comp_model_log_file_device = -1;
+    performance_timing_mgr = NULL;
+    log_buffer = NULL;
+    read_data_from_array_buffer(&enabled_in_parent_coupling_generation, sizeof(bool), array_buffer, buffer_content_iter, true);
+    processes_string = load_string(NULL, str_size, -1, array_buffer, buffer_content_iter, NULL);
+    load_string(comp_type, str_size, NAME_STR_SIZE, array_buffer, buffer_content_iter, NULL);
+    load_string(comp_name, str_size, NAME_STR_SIZE, array_buffer, buffer_content_iter, NULL);
+    EXECUTION_REPORT(REPORT_ERROR, -1, buffer_content_iter == 0, "Software error in Comp_comm_group_mgt_node::Comp_comm_group_mgt_node: wrong size of the component information of \"%s\"", specified_full_name);
+    strcpy(full_name, specified_full_name);
+    load_processes_from_string(processes_string);
+    delete [] processes_string;
 
     current_proc_local_id = -1;
     parent = NULL;
@@ -401,8 +553,6 @@ void Comp_comm_group_mgt_node::transform_node_into_array()
 
 void Comp_comm_group_mgt_node::write_node_into_XML(TiXmlElement *parent_element)
 {
-    int i, num_segments;
-    int *segments_start, *segments_end;
     TiXmlElement * current_element;
     char *string;
 
@@ -420,6 +570,19 @@ void Comp_comm_group_mgt_node::write_node_into_XML(TiXmlElement *parent_element)
         current_element->SetAttribute("enabled_in_parent_coupling_generation", "true");
     else current_element->SetAttribute("enabled_in_parent_coupling_generation", "false");
 
+    string = generate_processes_string();
+    current_element->SetAttribute("processes", string);
+    delete [] string;
+}
+
+
+char *Comp_comm_group_mgt_node::generate_processes_string()
+{
+    int i, num_segments;
+    int *segments_start, *segments_end;
+    char *string;
+
+
     segments_start = new int [local_processes_global_ids.size()];
     segments_end = new int [local_processes_global_ids.size()];
     segments_start[0] = local_processes_global_ids[0];
@@ -438,11 +601,56 @@ void Comp_comm_group_mgt_node::write_node_into_XML(TiXmlElement *parent_element)
             sprintf(string+strlen(string), " %d~%d", segments_start[i], segments_end[i]);
         else sprintf(string+strlen(string), " %d", segments_start[i]);
     }
-
-    current_element->SetAttribute("processes", string);
-    
     delete [] segments_start;
     delete [] segments_end;
+
+    return string;
+}
+
+
+void Comp_comm_group_mgt_node::load_processes_from_string(const char *processes_string)
+{
+    int segment_start, segment_end;
+
+
+    for (int i = 1; i < strlen(processes_string)+1; i ++) {
+        if (processes_string[i-1] == ' ') {
+            segment_start = processes_string[i]-'0';
+            segment_end = -1;
+            EXECUTION_REPORT(REPORT_ERROR, -1, segment_start >= 0 && segment_start <= 9, "Software error in Comp_comm_group_mgt_node::load_processes_from_string: wrong format");
+        }
+        else if (processes_string[i-1] == '~') {
+            segment_end = processes_string[i]-'0';
+            EXECUTION_REPORT(REPORT_ERROR, -1, segment_end >= 0 && segment_end <= 9, "Software error in Comp_comm_group_mgt_node::load_processes_from_string: wrong format");
+        }
+        else if (processes_string[i] == ' ' || processes_string[i] == '\0') {
+            if (segment_end == -1)
+                local_processes_global_ids.push_back(segment_start);
+            else {
+                for (int j = segment_start; j <= segment_end; j ++)
+                    local_processes_global_ids.push_back(j);
+            }
+        }
+        else if (processes_string[i] != '~') {
+            int digit = processes_string[i] - '0';            
+            EXECUTION_REPORT(REPORT_ERROR, -1, digit >= 0 && digit <= 9, "Software error in Comp_comm_group_mgt_node::load_processes_from_string: wrong format");
+            if (segment_end == -1)
+                segment_start = segment_start * 10 + digit;
+            else segment_end = segment_end * 10 + digit;
+        }
+    }
+}
+
+
+void Comp_comm_group_mgt_node::write_basic_info_into_array(char **array_buffer, long &buffer_max_size, long &buffer_content_size)
+{
+    char *string = generate_processes_string();
+
+
+    dump_string(comp_name, -1, array_buffer, buffer_max_size, buffer_content_size);
+    dump_string(comp_type, -1, array_buffer, buffer_max_size, buffer_content_size);
+    dump_string(string, -1, array_buffer, buffer_max_size, buffer_content_size);
+    write_data_into_array_buffer(&enabled_in_parent_coupling_generation, sizeof(bool), array_buffer, buffer_max_size, buffer_content_size);
     delete [] string;
 }
 
@@ -745,6 +953,11 @@ Comp_comm_group_mgt_mgr::Comp_comm_group_mgt_mgr(const char *executable_name)
         delete [] all_executable_name;    
     }
 
+    comp_info_registry = NULL;
+#if MPI_VERSION >= 3 && !defined(USE_XML_COMP_INFO_EXCHANGE)
+    comp_info_registry = new Comp_info_registry(MPI_COMM_WORLD);
+#endif
+
     MPI_Barrier(MPI_COMM_WORLD);
 }
 
@@ -761,6 +974,11 @@ Comp_comm_group_mgt_mgr::~Comp_comm_group_mgt_mgr()
 
     for (int i = 0; i < root_comps_full_names.size(); i ++)
         delete root_comps_full_names[i];
+
+#if MPI_VERSION >= 3
+    if (comp_info_registry != NULL)
+        delete comp_info_registry;
+#endif
 }
 
 
@@ -1037,12 +1255,47 @@ void Comp_comm_group_mgt_mgr::set_current_proc_current_time(int comp_id, int day
 }
 
 
+void Comp_comm_group_mgt_mgr::publish_comp_info(Comp_comm_group_mgt_node *comp_node)
+{
+    char *array_buffer = NULL;
+    long buffer_max_size, buffer_content_size;
+
+
+    if (comp_info_registry == NULL)
+        return;
+
+    comp_node->write_basic_info_into_array(&array_buffer, buffer_max_size, buffer_content_size);
+    if (!comp_info_registry->publish_comp_info(comp_node->get_comp_full_name(), array_buffer, buffer_content_size))
+        EXECUTION_REPORT_LOG(REPORT_LOG, -1, true, "The information of the component model \"%s\" is not published in memory and will be loaded from the XML file", comp_node->get_comp_full_name());
+    delete [] array_buffer;
+}
+
+
 Comp_comm_group_mgt_node *Comp_comm_group_mgt_mgr::load_comp_info_from_XML(int host_comp_id, const char *comp_full_name, MPI_Comm comm)
 {
     char XML_file_name[NAME_STR_SIZE];
     TiXmlDocument *XML_file;
-    int i;
+    char *array_buffer = NULL;
+    int i, local_process_id = 0, buffer_content_size = -1;
+
 
+    if (comm != MPI_COMM_NULL)
+        EXECUTION_REPORT(REPORT_ERROR, -1, MPI_Comm_rank(comm, &local_process_id) == MPI_SUCCESS);
+    if (local_process_id == 0 && comp_info_registry != NULL)
+        buffer_content_size = comp_info_registry->lookup_comp_info(comp_full_name, &array_buffer);
+    if (comm != MPI_COMM_NULL) {
+        EXECUTION_REPORT(REPORT_ERROR, -1, MPI_Bcast(&buffer_content_size, 1, MPI_INT, 0, comm) == MPI_SUCCESS);
+        if (buffer_content_size > 0) {
+            if (local_process_id != 0)
+                array_buffer = new char [buffer_content_size];
+            EXECUTION_REPORT(REPORT_ERROR, -1, MPI_Bcast(array_buffer, buffer_content_size, MPI_CHAR, 0, comm) == MPI_SUCCESS);
+        }
+    }
+    if (buffer_content_size > 0) {
+        Comp_comm_group_mgt_node *pesudo_comp_node = new Comp_comm_group_mgt_node(array_buffer, buffer_content_size, comp_full_name);
+        delete [] array_buffer;
+        return pesudo_comp_node;
+    }
 
     sprintf(XML_file_name, "%s/%s.basic_info.xml", comp_comm_group_mgt_mgr->get_components_processes_dir(), comp_full_name);
     XML_file = open_XML_file_to_read(host_comp_id, XML_file_name, comm, true);
@@ -1101,9 +1354,31 @@ void Comp_comm_group_mgt_mgr::output_log(const char *log_string, bool flush_log_
 
 void Comp_comm_group_mgt_mgr::output_performance_timing()
 {
+    char trace_file_name[NAME_STR_SIZE*2];
+
+
     for (int i = 0; i < global_node_array.size(); i ++)
-        if (global_node_array[i]->is_real_component_model() && global_node_array[i]->get_performance_timing_mgr() != NULL)
+        if (global_node_array[i]->is_real_component_model() && global_node_array[i]->get_performance_timing_mgr() != NULL) {
             global_node_array[i]->get_performance_timing_mgr()->performance_timing_output();
+            if (report_timing_trace_enabled && global_node_array[i]->get_current_proc_local_id() != -1) {
+                sprintf(trace_file_name, "%s.timing_trace.json", global_node_array[i]->get_comp_ccpl_log_file_name());
+                global_node_array[i]->get_performance_timing_mgr()->performance_timing_dump_trace(trace_file_name);
+            }
+            if (global_node_array[i]->get_current_proc_local_id() != -1)
+                global_node_array[i]->summarize_performance_timing();
+        }
+}
+
+
+void Comp_comm_group_mgt_node::summarize_performance_timing()
+{
+    char summary_file_name[NAME_STR_SIZE*3];
+
+
+    if (performance_timing_mgr == NULL)
+        return;
+    sprintf(summary_file_name, "%s/CCPL_dir/run/CCPL_logs/by_components/%s/%s/%s.timing_summary.csv", comp_comm_group_mgt_mgr->get_root_working_dir(), comp_type, full_name, comp_name);
+    performance_timing_mgr->performance_timing_summarize(comm_group, summary_file_name);
 }
 
 
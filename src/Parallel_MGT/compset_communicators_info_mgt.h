@@ -36,6 +36,41 @@
 #define DATAINST_NAME_PREFIX       "DATA_INST"
 #define ALGMODEL_NAME_PREFIX       "ALGORITHM_MODEL"
 
+#define COMP_INFO_REGISTRY_SLOTS_PER_PROC      8
+#define COMP_INFO_REGISTRY_CONTENT_SIZE        2048
+#define COMP_INFO_REGISTRY_POLL_INTERVAL       1000
+#define COMP_INFO_SLOT_EMPTY                   0
+#define COMP_INFO_SLOT_WRITING                 1
+#define COMP_INFO_SLOT_READY                   2
+
+
+struct Comp_info_registry_slot
+{
+    int state;
+    int content_size;
+    char full_name[NAME_STR_SIZE];
+    char content[COMP_INFO_REGISTRY_CONTENT_SIZE];
+};
+
+
+class Comp_info_registry
+{
+    private:
+        MPI_Win registry_win;
+        Comp_info_registry_slot *local_slots;
+        int num_total_procs;
+        long num_total_slots;
+
+        unsigned long get_name_hash(const char*);
+        void get_slot_location(unsigned long, long, int&, MPI_Aint&);
+
+    public:
+        Comp_info_registry(MPI_Comm);
+        ~Comp_info_registry();
+        bool publish_comp_info(const char*, const char*, int);
+        int lookup_comp_info(const char*, char**);
+};
+
 
 class Comp_comm_group_mgt_node
 {
@@ -70,9 +105,13 @@ class Comp_comm_group_mgt_node
         int log_buffer_content_size;
         Performance_timing_mgt *performance_timing_mgr;
 
+        char *generate_processes_string();
+        void load_processes_from_string(const char*);
+
     public:
         Comp_comm_group_mgt_node(const char*, const char*, int, Comp_comm_group_mgt_node*, MPI_Comm&, bool, const char*);
         Comp_comm_group_mgt_node(TiXmlElement *, const char *, const char *);
+        Comp_comm_group_mgt_node(const char *, long, const char *);
         ~Comp_comm_group_mgt_node();
         MPI_Comm get_comm_group() const { return comm_group; }
         int get_comp_id() const { return comp_id; }
@@ -93,6 +132,7 @@ class Comp_comm_group_mgt_node
         const char *get_annotation_end() { return annotation_end; }
         Comp_comm_group_mgt_node *get_parent() const { return parent; }
         void write_node_into_XML(TiXmlElement *);
+        void write_basic_info_into_array(char **, long &, long &);
         const char *get_working_dir() const { return working_dir; }
         void update_child(const Comp_comm_group_mgt_node*, Comp_comm_group_mgt_node*);
         void transfer_data_buffer(Comp_comm_group_mgt_node*);
@@ -117,6 +157,7 @@ class Comp_comm_group_mgt_node
         void update_min_max_remote_lag_seconds(int);
         void output_log(const char *, bool);
         Performance_timing_mgt *get_performance_timing_mgr() { return performance_timing_mgr; }        
+        void summarize_performance_timing();
 };
 
 
@@ -146,6 +187,7 @@ class Comp_comm_group_mgt_mgr
         int unique_comp_id_indx;
         char *log_buffer;
         int log_buffer_content_size;
+        Comp_info_registry *comp_info_registry;
 
     public:
         Comp_comm_group_mgt_mgr(const char*);
@@ -188,6 +230,7 @@ class Comp_comm_group_mgt_mgr
         void check_validation();
         void set_current_proc_current_time(int, int, int);
         Comp_comm_group_mgt_node *load_comp_info_from_XML(int, const char *, MPI_Comm);
+        void publish_comp_info(Comp_comm_group_mgt_node *);
         const char *get_CCPL_platform_log_dir() { return CCPL_platform_log_dir; }
         bool is_comp_type_coupled(int, const char *, const char *);
         void output_log(const char *, bool);
@@ -10,6 +10,7 @@
 #include <mpi.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "fields_gather_scatter_mgt.h"
 #include "global_data.h"
 
@@ -71,6 +72,18 @@ Gather_scatter_rearrange_info::Gather_scatter_rearrange_info(Field_mem_info *loc
     mpibuf = NULL;
     rearrange_indexes = NULL;
     global_field_mem = NULL;
+    distributed_IO_initialized = false;
+    is_IO_aggregator = false;
+    IO_comm = MPI_COMM_NULL;
+    IO_send_counts = NULL;
+    IO_send_displs = NULL;
+    IO_recv_counts = NULL;
+    IO_recv_displs = NULL;
+    IO_send_indexes = NULL;
+    IO_recv_offsets = NULL;
+    IO_send_buf = NULL;
+    IO_recv_buf = NULL;
+    IO_block_buf = NULL;
     host_comp_id = local_field->get_host_comp_id();
     original_decomp_id = local_field->get_decomp_id();
     grid_id = local_field->get_grid_id();
@@ -136,13 +149,22 @@ Gather_scatter_rearrange_info::Gather_scatter_rearrange_info(Field_mem_info *loc
             displs[i] *= num_points_in_each_cell*num_levels;
             counts[i] *= num_points_in_each_cell*num_levels;
         }
-        mpibuf = new char [num_total_cells*num_points_in_each_cell*num_levels*get_data_type_size(data_type)];
-        EXECUTION_REPORT_LOG(REPORT_LOG,-1, true, "allocate global field for gather/scatter");
-        global_field_mem = memory_manager->alloc_mem("IO_gather_field", new_decomp_id, grid_id, BUF_MARK_GATHER, data_type, "no unit", "allocate gather field", false);
     }
 }
 
 
+void Gather_scatter_rearrange_info::allocate_global_field(Field_mem_info *local_field_mem)
+{
+    if (!has_global_field || current_proc_local_id != 0 || global_field_mem != NULL)
+        return;
+
+    mpibuf = new char [num_total_cells*num_points_in_each_cell*num_levels*get_data_type_size(data_type)];
+    EXECUTION_REPORT_LOG(REPORT_LOG,-1, true, "allocate global field for gather/scatter");
+    global_field_mem = memory_manager->alloc_mem("IO_gather_field", new_decomp_id, grid_id, BUF_MARK_GATHER, data_type, "no unit", "allocate gather field", false);
+    copy_in_local_field_info(local_field_mem);
+}
+
+
 bool Gather_scatter_rearrange_info::match(int host_comp_id, int decomp_id, int grid_id, const char *data_type)
 {
     return this->host_comp_id == host_comp_id && this->original_decomp_id == decomp_id && this->grid_id == grid_id && words_are_the_same(this->data_type, data_type);
@@ -174,6 +196,7 @@ Field_mem_info *Gather_scatter_rearrange_info::gather_field(Field_mem_info *loca
     if (!has_global_field)
         return local_field_mem;
 
+    allocate_global_field(local_field_mem);
     if (current_proc_local_id == 0)
         global_field_mem->get_field_data()->get_grid_data_field()->initialize_to_fill_value();
 
@@ -212,6 +235,7 @@ Field_mem_info *Gather_scatter_rearrange_info::get_global_field(Field_mem_info *
     if (!has_global_field)
         return local_field_mem;
 
+    allocate_global_field(local_field_mem);
     return global_field_mem;
 }
 
@@ -232,6 +256,7 @@ void Gather_scatter_rearrange_info::scatter_field(Field_mem_info *local_field_me
         return;
     }
 
+    allocate_global_field(local_field_mem);
     if (get_data_type_size(data_type) == 1) {
         if (current_proc_local_id == 0)
             rearrange_scatter_data((char*) global_field_mem->get_data_buf(), (char*) mpibuf, decomps_info_mgr->get_decomp_info(new_decomp_id)->get_num_local_cells());
@@ -271,6 +296,275 @@ Gather_scatter_rearrange_info::~Gather_scatter_rearrange_info()
         delete [] mpibuf;
     if (rearrange_indexes != NULL)
         delete [] rearrange_indexes;
+    if (IO_send_counts != NULL) {
+        delete [] IO_send_counts;
+        delete [] IO_send_displs;
+        delete [] IO_recv_counts;
+        delete [] IO_recv_displs;
+        delete [] IO_send_indexes;
+        delete [] IO_recv_offsets;
+        delete [] IO_send_buf;
+        delete [] IO_recv_buf;
+    }
+    if (IO_block_buf != NULL)
+        delete [] IO_block_buf;
+    if (IO_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&IO_comm);
+}
+
+
+bool Gather_scatter_rearrange_info::can_use_distributed_IO(Field_mem_info *local_field_mem, bool is_restart_field)
+{
+#ifdef USE_PARALLEL_NETCDF
+    Remap_data_field *data_field = local_field_mem->get_field_data()->get_grid_data_field();
+
+    if (!has_global_field || execution_phase_number == 0)
+        return false;
+    if (!words_are_the_same(data_type, DATA_TYPE_SHORT) && !words_are_the_same(data_type, DATA_TYPE_INT) && !words_are_the_same(data_type, DATA_TYPE_FLOAT) && !words_are_the_same(data_type, DATA_TYPE_DOUBLE))
+        return false;
+    return is_restart_field || strlen(data_field->data_type_in_IO_file) == 0 || words_are_the_same(data_field->data_type_in_IO_file, data_type);
+#else
+    return false;
+#endif
+}
+
+
+/* Each aggregator (every NUM_PROCS_PER_IO_AGGREGATOR-th process of the component) owns one contiguous
+   block of the flattened global field, in the same layout as the gathered global field. The routing of
+   each local value to its aggregator is computed once and reused by all the following reads and writes */
+void Gather_scatter_rearrange_info::initialize_distributed_IO()
+{
+    int num_aggregators, num_local_cells, num_global_cells, i, j, k, m, dst_proc;
+    int *send_offsets, *send_positions;
+    const int *local_cell_global_indx;
+    long offset;
+
+
+    if (distributed_IO_initialized)
+        return;
+
+    distributed_IO_initialized = true;
+    is_IO_aggregator = current_proc_local_id % NUM_PROCS_PER_IO_AGGREGATOR == 0;
+    MPI_Comm_split(local_comm, is_IO_aggregator? 0 : MPI_UNDEFINED, current_proc_local_id, &IO_comm);
+    num_aggregators = (num_local_procs+NUM_PROCS_PER_IO_AGGREGATOR-1) / NUM_PROCS_PER_IO_AGGREGATOR;
+    num_global_cells = decomps_info_mgr->get_decomp_info(new_decomp_id)->get_num_local_cells();
+    num_local_cells = decomps_info_mgr->get_decomp_info(original_decomp_id)->get_num_local_cells();
+    local_cell_global_indx = decomps_info_mgr->get_decomp_info(original_decomp_id)->get_local_cell_global_indx();
+    IO_total_size = ((long)num_global_cells)*num_levels*num_points_in_each_cell;
+    IO_block_size = (IO_total_size+num_aggregators-1) / num_aggregators;
+    if (IO_block_size == 0)
+        IO_block_size = 1;
+
+    IO_send_counts = new int [num_local_procs];
+    IO_send_displs = new int [num_local_procs];
+    IO_recv_counts = new int [num_local_procs];
+    IO_recv_displs = new int [num_local_procs];
+    for (m = 0; m < num_local_procs; m ++)
+        IO_send_counts[m] = 0;
+    for (k = 0; k < num_levels; k ++)
+        for (i = 0; i < num_local_cells; i ++) {
+            if (local_cell_global_indx[i] == CCPL_NULL_INT)
+                continue;
+            for (j = 0; j < num_points_in_each_cell; j ++) {
+                offset = ((long)k*num_global_cells+local_cell_global_indx[i])*num_points_in_each_cell + j;
+                IO_send_counts[(offset/IO_block_size)*NUM_PROCS_PER_IO_AGGREGATOR] ++;
+            }
+        }
+    for (m = 0, IO_send_displs[0] = 0; m < num_local_procs-1; m ++)
+        IO_send_displs[m+1] = IO_send_displs[m] + IO_send_counts[m];
+    int num_send_values = IO_send_displs[num_local_procs-1] + IO_send_counts[num_local_procs-1];
+    IO_send_indexes = new int [num_send_values+1];
+    send_offsets = new int [num_send_values+1];
+    send_positions = new int [num_local_procs];
+    for (m = 0; m < num_local_procs; m ++)
+        send_positions[m] = IO_send_displs[m];
+    for (k = 0; k < num_levels; k ++)
+        for (i = 0; i < num_local_cells; i ++) {
+            if (local_cell_global_indx[i] == CCPL_NULL_INT)
+                continue;
+            for (j = 0; j < num_points_in_each_cell; j ++) {
+                offset = ((long)k*num_global_cells+local_cell_global_indx[i])*num_points_in_each_cell + j;
+                dst_proc = (offset/IO_block_size)*NUM_PROCS_PER_IO_AGGREGATOR;
+                IO_send_indexes[send_positions[dst_proc]] = (k*num_local_cells+i)*num_points_in_each_cell + j;
+                send_offsets[send_positions[dst_proc]++] = offset % IO_block_size;
+            }
+        }
+
+    MPI_Alltoall(IO_send_counts, 1, MPI_INT, IO_recv_counts, 1, MPI_INT, local_comm);
+    for (m = 0, IO_recv_displs[0] = 0; m < num_local_procs-1; m ++)
+        IO_recv_displs[m+1] = IO_recv_displs[m] + IO_recv_counts[m];
+    int num_recv_values = IO_recv_displs[num_local_procs-1] + IO_recv_counts[num_local_procs-1];
+    IO_recv_offsets = new int [num_recv_values+1];
+    MPI_Alltoallv(send_offsets, IO_send_counts, IO_send_displs, MPI_INT, IO_recv_offsets, IO_recv_counts, IO_recv_displs, MPI_INT, local_comm);
+
+    IO_send_buf = new char [(num_send_values+1)*get_data_type_size(data_type)];
+    IO_recv_buf = new char [(num_recv_values+1)*get_data_type_size(data_type)];
+    if (is_IO_aggregator)
+        IO_block_buf = new char [(IO_block_size+1)*get_data_type_size(data_type)];
+    EXECUTION_REPORT_LOG(REPORT_LOG, -1, true, "generate distributed IO info for (%s %s %s): %d aggregators with block size %ld", decomps_info_mgr->get_decomp_info(original_decomp_id)->get_decomp_name(), decomps_info_mgr->get_decomp_info(original_decomp_id)->get_grid_name(), data_type, num_aggregators, IO_block_size);
+
+    delete [] send_offsets;
+    delete [] send_positions;
+}
+
+
+/* The same value rules as IO_basis::copy_field_data_for_IO and Remap_grid_data_class::set_masked_cell_to_missing_value,
+   applied to the block of the current aggregator with the mask of the original grid. The block is laid out as 
+   [level][global cell][point in cell], and the mask covers either the horizontal cells or all cells of all levels */
+template <class T> void Gather_scatter_rearrange_info::apply_IO_rules_to_block(T *block, Remap_data_field *data_field, bool is_restart_field)
+{
+    long block_start = (current_proc_local_id/NUM_PROCS_PER_IO_AGGREGATOR)*IO_block_size, i;
+    long block_size = IO_total_size - block_start < IO_block_size? IO_total_size - block_start : IO_block_size;
+    long num_global_cells = IO_total_size / num_levels / num_points_in_each_cell, mask_index;
+    Remap_grid_data_class *mask_field = original_grid_mgr->get_original_CoR_grid(grid_id)->get_grid_mask_field();
+    bool *mask = NULL;
+    long mask_size;
+    double fill_value = data_field->have_fill_value? data_field->fill_value : 0;
+
+
+    if (mask_field != NULL) {
+        mask_field->interchange_grid_data(mask_field->get_coord_value_grid());
+        mask = (bool*) mask_field->get_grid_data_field()->data_buf;
+        mask_size = mask_field->get_grid_data_field()->required_data_size;
+        EXECUTION_REPORT(REPORT_ERROR, -1, mask_size == num_global_cells || mask_size == num_global_cells*num_levels, 
+                         "Software error in Gather_scatter_rearrange_info::apply_IO_rules_to_block: the size of the grid mask (%ld) matches neither the number of horizontal cells (%ld) nor the number of cells of all levels", mask_size, num_global_cells);
+    }
+
+    for (i = 0; i < block_size; i ++) {
+        if (!is_restart_field && (fabs((double)block[i]) >= 1.0e10 || (fabs((double)block[i]) <= 1.5*fabs(fill_value) && fabs((double)block[i]) >= 0.5*fabs(fill_value))))
+            block[i] = (T) fill_value;
+        if (mask == NULL)
+            continue;
+        mask_index = (block_start+i) / num_points_in_each_cell;
+        if (mask_size == num_global_cells)
+            mask_index = mask_index % num_global_cells;
+        if (!mask[mask_index]) {
+            if (words_are_the_same(data_type, DATA_TYPE_FLOAT) || words_are_the_same(data_type, DATA_TYPE_DOUBLE))
+                block[i] = (T) DEFAULT_FILL_VALUE;
+            else if (!is_restart_field)
+                block[i] = (T) fill_value;
+        }
+    }
+}
+
+
+template <class T> void scatter_values_into_IO_block(T *values, int *offsets, int num_values, T *block, long block_size, T fill_value)
+{
+    for (long i = 0; i < block_size; i ++)
+        block[i] = fill_value;
+    for (int i = 0; i < num_values; i ++)
+        block[offsets[i]] = values[i];
+}
+
+
+template <class T> void gather_values_from_IO_block(T *values, int *offsets, int num_values, T *block)
+{
+    for (int i = 0; i < num_values; i ++)
+        values[i] = block[offsets[i]];
+}
+
+
+template <class T> void pack_values_for_IO(T *local_values, int *indexes, int num_values, T *values)
+{
+    for (int i = 0; i < num_values; i ++)
+        values[i] = local_values[indexes[i]];
+}
+
+
+template <class T> void unpack_values_from_IO(T *local_values, int *indexes, int num_values, T *values)
+{
+    for (int i = 0; i < num_values; i ++)
+        local_values[indexes[i]] = values[i];
+}
+
+
+void Gather_scatter_rearrange_info::write_field_distributed(Field_mem_info *local_field_mem, const char *file_name, const char *field_IO_name, bool is_restart_field)
+{
+#ifdef USE_PARALLEL_NETCDF
+    Remap_data_field *data_field = local_field_mem->get_field_data()->get_grid_data_field();
+    MPI_Datatype mpi_type = get_data_type_size(data_type) == 2? MPI_SHORT : (get_data_type_size(data_type) == 4? MPI_INT : MPI_DOUBLE);
+    int num_send_values, num_recv_values;
+    long block_start, block_size;
+
+
+    initialize_distributed_IO();
+    num_send_values = IO_send_displs[num_local_procs-1] + IO_send_counts[num_local_procs-1];
+    num_recv_values = IO_recv_displs[num_local_procs-1] + IO_recv_counts[num_local_procs-1];
+    if (get_data_type_size(data_type) == 2)
+        pack_values_for_IO((short*) data_field->data_buf, IO_send_indexes, num_send_values, (short*) IO_send_buf);
+    else if (get_data_type_size(data_type) == 4)
+        pack_values_for_IO((int*) data_field->data_buf, IO_send_indexes, num_send_values, (int*) IO_send_buf);
+    else pack_values_for_IO((double*) data_field->data_buf, IO_send_indexes, num_send_values, (double*) IO_send_buf);
+    MPI_Alltoallv(IO_send_buf, IO_send_counts, IO_send_displs, mpi_type, IO_recv_buf, IO_recv_counts, IO_recv_displs, mpi_type, local_comm);
+    if (!is_IO_aggregator)
+        return;
+
+    block_start = (current_proc_local_id/NUM_PROCS_PER_IO_AGGREGATOR)*IO_block_size;
+    block_size = IO_total_size - block_start < IO_block_size? IO_total_size - block_start : IO_block_size;
+    if (block_size < 0)
+        block_size = 0;
+    data_field->read_fill_value();
+    double fill_value = data_field->have_fill_value? data_field->fill_value : 0;
+    if (words_are_the_same(data_type, DATA_TYPE_SHORT)) {
+        scatter_values_into_IO_block((short*) IO_recv_buf, IO_recv_offsets, num_recv_values, (short*) IO_block_buf, block_size, (short) fill_value);
+        apply_IO_rules_to_block((short*) IO_block_buf, data_field, is_restart_field);
+    }
+    else if (words_are_the_same(data_type, DATA_TYPE_INT)) {
+        scatter_values_into_IO_block((int*) IO_recv_buf, IO_recv_offsets, num_recv_values, (int*) IO_block_buf, block_size, (int) fill_value);
+        apply_IO_rules_to_block((int*) IO_block_buf, data_field, is_restart_field);
+    }
+    else if (words_are_the_same(data_type, DATA_TYPE_FLOAT)) {
+        scatter_values_into_IO_block((float*) IO_recv_buf, IO_recv_offsets, num_recv_values, (float*) IO_block_buf, block_size, (float) fill_value);
+        apply_IO_rules_to_block((float*) IO_block_buf, data_field, is_restart_field);
+    }
+    else {
+        scatter_values_into_IO_block((double*) IO_recv_buf, IO_recv_offsets, num_recv_values, (double*) IO_block_buf, block_size, fill_value);
+        apply_IO_rules_to_block((double*) IO_block_buf, data_field, is_restart_field);
+    }
+    EXECUTION_REPORT(REPORT_ERROR, -1, IO_netcdf::access_field_data_block(file_name, field_IO_name, data_type, -1, block_start, block_size, IO_block_buf, IO_comm, true), "Software error in Gather_scatter_rearrange_info::write_field_distributed: variable \"%s\" has not been defined in the file \"%s\"", field_IO_name, file_name);
+#endif
+}
+
+
+bool Gather_scatter_rearrange_info::read_field_distributed(Field_mem_info *local_field_mem, const char *file_name, const char *field_IO_name, int time_pos)
+{
+    int has_field_in_file = 1;
+#ifdef USE_PARALLEL_NETCDF
+    Remap_data_field *data_field = local_field_mem->get_field_data()->get_grid_data_field();
+    MPI_Datatype mpi_type = get_data_type_size(data_type) == 2? MPI_SHORT : (get_data_type_size(data_type) == 4? MPI_INT : MPI_DOUBLE);
+    int num_send_values, num_recv_values;
+    long block_start, block_size;
+
+
+    initialize_distributed_IO();
+    num_send_values = IO_send_displs[num_local_procs-1] + IO_send_counts[num_local_procs-1];
+    num_recv_values = IO_recv_displs[num_local_procs-1] + IO_recv_counts[num_local_procs-1];
+    if (is_IO_aggregator) {
+        block_start = (current_proc_local_id/NUM_PROCS_PER_IO_AGGREGATOR)*IO_block_size;
+        block_size = IO_total_size - block_start < IO_block_size? IO_total_size - block_start : IO_block_size;
+        if (block_size < 0)
+            block_size = 0;
+        has_field_in_file = IO_netcdf::access_field_data_block(file_name, field_IO_name, data_type, time_pos, block_start, block_size, IO_block_buf, IO_comm, false)? 1 : 0;
+    }
+    MPI_Bcast(&has_field_in_file, 1, MPI_INT, 0, local_comm);
+    if (has_field_in_file == 0)
+        return false;
+
+    if (is_IO_aggregator) {
+        if (get_data_type_size(data_type) == 2)
+            gather_values_from_IO_block((short*) IO_recv_buf, IO_recv_offsets, num_recv_values, (short*) IO_block_buf);
+        else if (get_data_type_size(data_type) == 4)
+            gather_values_from_IO_block((int*) IO_recv_buf, IO_recv_offsets, num_recv_values, (int*) IO_block_buf);
+        else gather_values_from_IO_block((double*) IO_recv_buf, IO_recv_offsets, num_recv_values, (double*) IO_block_buf);
+    }
+    MPI_Alltoallv(IO_recv_buf, IO_recv_counts, IO_recv_displs, mpi_type, IO_send_buf, IO_send_counts, IO_send_displs, mpi_type, local_comm);
+    if (get_data_type_size(data_type) == 2)
+        unpack_values_from_IO((short*) data_field->data_buf, IO_send_indexes, num_send_values, (short*) IO_send_buf);
+    else if (get_data_type_size(data_type) == 4)
+        unpack_values_from_IO((int*) data_field->data_buf, IO_send_indexes, num_send_values, (int*) IO_send_buf);
+    else unpack_values_from_IO((double*) data_field->data_buf, IO_send_indexes, num_send_values, (double*) IO_send_buf);
+#endif
+    return has_field_in_file == 1;
 }
 
 
@@ -301,11 +595,260 @@ Field_mem_info *Fields_gather_scatter_mgt::gather_field(Field_mem_info *local_fi
 }
 
 
-void Fields_gather_scatter_mgt::gather_write_field(IO_netcdf *nc_file, Field_mem_info *local_field, bool write_grid_name, int date, int datesec, bool is_restart_field)
+#ifdef USE_ASYNC_IO
+Async_IO_writer::Async_IO_writer()
 {
-    Field_mem_info *global_field = gather_field(local_field);
-    if (comp_comm_group_mgt_mgr->get_current_proc_id_in_comp(local_field->get_host_comp_id(), "in gather_write_field") == 0)
+    num_pending_bytes = 0;
+    is_executing_task = false;
+    to_finalize = false;
+    pthread_mutex_init(&tasks_mutex, NULL);
+    pthread_cond_init(&tasks_cond, NULL);
+    EXECUTION_REPORT(REPORT_ERROR, -1, pthread_create(&writer_thread, NULL, writer_thread_main, this) == 0, "C-Coupler error in Async_IO_writer: fail to create the background IO thread");
+}
+
+
+Async_IO_writer::~Async_IO_writer()
+{
+    pthread_mutex_lock(&tasks_mutex);
+    to_finalize = true;
+    pthread_cond_broadcast(&tasks_cond);
+    pthread_mutex_unlock(&tasks_mutex);
+    pthread_join(writer_thread, NULL);
+    pthread_cond_destroy(&tasks_cond);
+    pthread_mutex_destroy(&tasks_mutex);
+}
+
+
+void *Async_IO_writer::writer_thread_main(void *writer)
+{
+    ((Async_IO_writer*) writer)->execute_tasks();
+    return NULL;
+}
+
+
+/* The background thread executes the tasks of all IO files in submission order, so that the time records,
+   the sessions and the release of each file keep the same order as in the synchronous writing. It only writes
+   field data prepared by the model thread (see IO_netcdf::prepare_grided_data_for_async_IO) */
+void Async_IO_writer::execute_tasks()
+{
+    Async_IO_task task;
+
+
+    pthread_mutex_lock(&tasks_mutex);
+    while (true) {
+        while (tasks.empty() && !to_finalize)
+            pthread_cond_wait(&tasks_cond, &tasks_mutex);
+        if (tasks.empty())
+            break;
+        task = tasks.front();
+        tasks.pop_front();
+        is_executing_task = true;
+        pthread_mutex_unlock(&tasks_mutex);
+
+        switch (task.type) {
+            case ASYNC_IO_TASK_WRITE_FIELD:
+                task.nc_file->write_prepared_grided_data(task.field_data, task.write_grid_name, task.date, task.datesec);
+                delete task.field_data;
+                break;
+            case ASYNC_IO_TASK_BEGIN_SESSION:
+                task.nc_file->begin_session();
+                break;
+            case ASYNC_IO_TASK_END_SESSION:
+                task.nc_file->end_session();
+                break;
+            case ASYNC_IO_TASK_RELEASE_FILE:
+                delete task.nc_file;
+                break;
+            default:
+                EXECUTION_REPORT(REPORT_ERROR, -1, false, "Software error in Async_IO_writer::execute_tasks");
+        }
+
+        pthread_mutex_lock(&tasks_mutex);
+        is_executing_task = false;
+        num_pending_bytes -= task.num_bytes;
+        pthread_cond_broadcast(&tasks_cond);
+    }
+    pthread_mutex_unlock(&tasks_mutex);
+}
+
+
+/* At most ASYNC_IO_MAX_PENDING_BYTES of field snapshots are waiting for writing: the model processes only
+   block when the writing falls behind by more than this volume */
+void Async_IO_writer::submit_task(int type, IO_netcdf *nc_file, Remap_grid_data_class *field_data, bool write_grid_name, int date, int datesec)
+{
+    Async_IO_task task;
+
+
+    task.type = type;
+    task.nc_file = nc_file;
+    task.field_data = field_data;
+    task.num_bytes = field_data == NULL? 0 : field_data->get_grid_data_field()->required_data_size*get_data_type_size(field_data->get_grid_data_field()->data_type_in_application);
+    task.write_grid_name = write_grid_name;
+    task.date = date;
+    task.datesec = datesec;
+
+    pthread_mutex_lock(&tasks_mutex);
+    while (num_pending_bytes > 0 && num_pending_bytes + task.num_bytes > ASYNC_IO_MAX_PENDING_BYTES)
+        pthread_cond_wait(&tasks_cond, &tasks_mutex);
+    num_pending_bytes += task.num_bytes;
+    tasks.push_back(task);
+    pthread_cond_broadcast(&tasks_cond);
+    pthread_mutex_unlock(&tasks_mutex);
+}
+
+
+void Async_IO_writer::write_field(IO_netcdf *nc_file, Remap_grid_data_class *field_data, bool write_grid_name, int date, int datesec)
+{
+    submit_task(ASYNC_IO_TASK_WRITE_FIELD, nc_file, field_data, write_grid_name, date, datesec);
+}
+
+
+void Async_IO_writer::begin_session(IO_netcdf *nc_file)
+{
+    submit_task(ASYNC_IO_TASK_BEGIN_SESSION, nc_file, NULL, false, -1, -1);
+}
+
+
+void Async_IO_writer::end_session(IO_netcdf *nc_file)
+{
+    submit_task(ASYNC_IO_TASK_END_SESSION, nc_file, NULL, false, -1, -1);
+}
+
+
+void Async_IO_writer::release_file(IO_netcdf *nc_file)
+{
+    submit_task(ASYNC_IO_TASK_RELEASE_FILE, nc_file, NULL, false, -1, -1);
+}
+
+
+void Async_IO_writer::wait_for_completion()
+{
+    pthread_mutex_lock(&tasks_mutex);
+    while (!tasks.empty() || is_executing_task)
+        pthread_cond_wait(&tasks_cond, &tasks_mutex);
+    pthread_mutex_unlock(&tasks_mutex);
+}
+#endif
+
+
+Fields_gather_scatter_mgt::Fields_gather_scatter_mgt()
+{
+#ifdef USE_ASYNC_IO
+    async_IO_writer = new Async_IO_writer();
+#endif
+}
+
+
+void Fields_gather_scatter_mgt::begin_write_session(IO_netcdf *nc_file)
+{
+    if (nc_file == NULL)
+        return;
+#ifdef USE_ASYNC_IO
+    async_IO_writer->begin_session(nc_file);
+#else
+    nc_file->begin_session();
+#endif
+}
+
+
+void Fields_gather_scatter_mgt::end_write_session(IO_netcdf *nc_file)
+{
+    if (nc_file == NULL)
+        return;
+#ifdef USE_ASYNC_IO
+    async_IO_writer->end_session(nc_file);
+#else
+    nc_file->end_session();
+#endif
+}
+
+
+void Fields_gather_scatter_mgt::release_IO_file(IO_netcdf *nc_file)
+{
+    if (nc_file == NULL)
+        return;
+#ifdef USE_ASYNC_IO
+    async_IO_writer->release_file(nc_file);
+#else
+    delete nc_file;
+#endif
+}
+
+
+void Fields_gather_scatter_mgt::wait_for_async_IO()
+{
+#ifdef USE_ASYNC_IO
+    async_IO_writer->wait_for_completion();
+#endif
+}
+
+
+/* Defines the variable of a field in the file on the root process without writing its data, so that
+   the variables of all fields to be written can be defined in one define phase of an IO_netcdf session.
+   With the background IO thread, the variables are defined by the thread when writing the fields */
+void Fields_gather_scatter_mgt::define_write_field(IO_netcdf *nc_file, Field_mem_info *local_field, const char *field_IO_name, bool write_grid_name, int date, int datesec, bool is_restart_field)
+{
+    apply_gather_scatter_rearrange_info(local_field);
+#ifndef USE_ASYNC_IO
+    if (comp_comm_group_mgt_mgr->get_current_proc_id_in_comp(local_field->get_host_comp_id(), "in define_write_field") == 0)
+        define_field_in_file(nc_file, local_field, field_IO_name, write_grid_name, date, datesec, is_restart_field);
+#endif
+}
+
+
+void Fields_gather_scatter_mgt::define_field_in_file(IO_netcdf *nc_file, Field_mem_info *local_field, const char *field_IO_name, bool write_grid_name, int date, int datesec, bool is_restart_field)
+{
+    Gather_scatter_rearrange_info *rearrange_info = apply_gather_scatter_rearrange_info(local_field);
+    Remap_data_field *data_field = local_field->get_field_data()->get_grid_data_field();
+    Remap_grid_class *global_grid;
+
+
+    if (field_IO_name == NULL)
+        field_IO_name = strlen(data_field->field_name_in_IO_file) > 0? data_field->field_name_in_IO_file : data_field->field_name_in_application;
+    if (rearrange_info->can_use_distributed_IO(local_field, is_restart_field))
+        global_grid = decomp_grids_mgr->search_decomp_grid_info(decomps_info_mgr->generate_fully_decomp(local_field->get_decomp_id()), original_grid_mgr->get_original_CoR_grid(local_field->get_grid_id()), false)->get_decomp_grid();
+    else global_grid = rearrange_info->get_global_field(local_field)->get_field_data()->get_coord_value_grid();
+    nc_file->define_field_variable(data_field, global_grid, field_IO_name, is_restart_field || strlen(data_field->data_type_in_IO_file) == 0? data_field->data_type_in_application : data_field->data_type_in_IO_file, write_grid_name, date, datesec);
+}
+
+
+void Fields_gather_scatter_mgt::gather_write_field(IO_netcdf *nc_file, Field_mem_info *local_field, const char *field_IO_name, bool write_grid_name, int date, int datesec, bool is_restart_field)
+{
+    bool is_root_proc = comp_comm_group_mgt_mgr->get_current_proc_id_in_comp(local_field->get_host_comp_id(), "in gather_write_field") == 0;
+    Gather_scatter_rearrange_info *rearrange_info = apply_gather_scatter_rearrange_info(local_field);
+    Remap_data_field *data_field = local_field->get_field_data()->get_grid_data_field();
+    char file_and_field_names[NAME_STR_SIZE*4];
+
+
+    if (rearrange_info->can_use_distributed_IO(local_field, is_restart_field)) {
+        if (field_IO_name == NULL)
+            field_IO_name = strlen(data_field->field_name_in_IO_file) > 0? data_field->field_name_in_IO_file : data_field->field_name_in_application;
+        if (is_root_proc) {
+            wait_for_async_IO();
+            if (!nc_file->is_predefined_field(field_IO_name, false))
+                define_field_in_file(nc_file, local_field, field_IO_name, write_grid_name, date, datesec, is_restart_field);
+            nc_file->flush_session();
+            strcpy(file_and_field_names, nc_file->get_file_name());
+        }
+        MPI_Bcast(file_and_field_names, NAME_STR_SIZE*4, MPI_CHAR, 0, comp_comm_group_mgt_mgr->get_comm_group_of_local_comp(local_field->get_host_comp_id(), "in gather_write_field"));
+        rearrange_info->write_field_distributed(local_field, file_and_field_names, field_IO_name, is_restart_field);
+        return;
+    }
+
+    Field_mem_info *global_field = rearrange_info->gather_field(local_field);
+    if (is_root_proc) {
+        if (field_IO_name != NULL)
+            strcpy(global_field->get_field_data()->get_grid_data_field()->field_name_in_IO_file, field_IO_name);
+#ifdef USE_ASYNC_IO
+        Remap_grid_data_class *global_field_data = global_field->get_field_data();
+        if (global_field_data->get_coord_value_grid() != NULL && global_field_data->get_coord_value_grid()->get_whole_grid() == NULL && global_field_data->get_coord_value_grid()->get_grid_size() > 0) {
+            async_IO_writer->write_field(nc_file, nc_file->prepare_grided_data_for_async_IO(global_field_data, write_grid_name, is_restart_field), write_grid_name, date, datesec);
+            return;
+        }
+        async_IO_writer->wait_for_completion();
+#endif
         nc_file->write_grided_data(global_field->get_field_data(), write_grid_name, date, datesec, is_restart_field);
+    }
 }
 
 
@@ -315,6 +858,15 @@ bool Fields_gather_scatter_mgt::read_scatter_field(IO_netcdf *nc_file, Field_mem
     
 
     Gather_scatter_rearrange_info *rearrage_info = apply_gather_scatter_rearrange_info(local_field);
+    if (field_IO_name != NULL && rearrage_info->can_use_distributed_IO(local_field, true)) {
+        char file_name[NAME_STR_SIZE*4];
+        if (comp_comm_group_mgt_mgr->get_current_proc_id_in_comp(local_field->get_host_comp_id(), "in read_scatter_field") == 0)
+            strcpy(file_name, nc_file->get_file_name());
+        MPI_Bcast(file_name, NAME_STR_SIZE*4, MPI_CHAR, 0, comp_comm_group_mgt_mgr->get_comm_group_of_local_comp(local_field->get_host_comp_id(), "in read_scatter_field"));
+        has_data_in_file = rearrage_info->read_field_distributed(local_field, file_name, field_IO_name, time_pos);
+        EXECUTION_REPORT(REPORT_ERROR, -1, has_data_in_file || !check_existence, "Error happens when reading the field \"%s\": the data file \"%s\" does not contain the variable \"%s\"", local_field->get_field_name(), file_name, field_IO_name);
+        return has_data_in_file;
+    }
     if (comp_comm_group_mgt_mgr->get_current_proc_id_in_comp(local_field->get_host_comp_id(), "in read_scatter_field") == 0) {
         if (field_IO_name != NULL)
             strcpy(rearrage_info->get_global_field(local_field)->get_field_data()->get_grid_data_field()->field_name_in_IO_file, field_IO_name);
@@ -329,6 +881,9 @@ bool Fields_gather_scatter_mgt::read_scatter_field(IO_netcdf *nc_file, Field_mem
 
 Fields_gather_scatter_mgt::~Fields_gather_scatter_mgt()
 {
+#ifdef USE_ASYNC_IO
+    delete async_IO_writer;
+#endif
     for (int i = 0; i < gather_scatter_rearrange_infos.size(); i ++)
         delete gather_scatter_rearrange_infos[i];
 }
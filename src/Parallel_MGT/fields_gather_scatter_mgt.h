@@ -15,6 +15,64 @@
 #include "memory_mgt.h"
 #include "io_netcdf.h"
 #include <vector>
+#ifdef USE_ASYNC_IO
+#include <pthread.h>
+#include <deque>
+#endif
+
+
+#ifndef NUM_PROCS_PER_IO_AGGREGATOR
+#define NUM_PROCS_PER_IO_AGGREGATOR    8
+#endif
+
+#ifndef ASYNC_IO_MAX_PENDING_BYTES
+#define ASYNC_IO_MAX_PENDING_BYTES     ((long)1<<30)
+#endif
+
+#define ASYNC_IO_TASK_WRITE_FIELD      0
+#define ASYNC_IO_TASK_BEGIN_SESSION    1
+#define ASYNC_IO_TASK_END_SESSION      2
+#define ASYNC_IO_TASK_RELEASE_FILE     3
+
+
+#ifdef USE_ASYNC_IO
+struct Async_IO_task
+{
+    int type;
+    IO_netcdf *nc_file;
+    Remap_grid_data_class *field_data;
+    long num_bytes;
+    bool write_grid_name;
+    int date;
+    int datesec;
+};
+
+
+class Async_IO_writer
+{
+    private:
+        pthread_t writer_thread;
+        pthread_mutex_t tasks_mutex;
+        pthread_cond_t tasks_cond;
+        std::deque<Async_IO_task> tasks;
+        long num_pending_bytes;
+        bool is_executing_task;
+        bool to_finalize;
+
+        static void *writer_thread_main(void*);
+        void execute_tasks();
+        void submit_task(int, IO_netcdf*, Remap_grid_data_class*, bool, int, int);
+
+    public:
+        Async_IO_writer();
+        ~Async_IO_writer();
+        void write_field(IO_netcdf*, Remap_grid_data_class*, bool, int, int);
+        void begin_session(IO_netcdf*);
+        void end_session(IO_netcdf*);
+        void release_file(IO_netcdf*);
+        void wait_for_completion();
+};
+#endif
 
 
 class Gather_scatter_rearrange_info
@@ -40,6 +98,25 @@ class Gather_scatter_rearrange_info
         int current_proc_local_id;
         MPI_Comm local_comm;
 
+        bool distributed_IO_initialized;
+        bool is_IO_aggregator;
+        MPI_Comm IO_comm;
+        long IO_total_size;
+        long IO_block_size;
+        int *IO_send_counts;
+        int *IO_send_displs;
+        int *IO_recv_counts;
+        int *IO_recv_displs;
+        int *IO_send_indexes;
+        int *IO_recv_offsets;
+        char *IO_send_buf;
+        char *IO_recv_buf;
+        char *IO_block_buf;
+
+        void allocate_global_field(Field_mem_info*);
+        void initialize_distributed_IO();
+        template <class T> void apply_IO_rules_to_block(T*, Remap_data_field*, bool);
+
     public:
         Gather_scatter_rearrange_info(Field_mem_info*);
         ~Gather_scatter_rearrange_info();
@@ -50,6 +127,9 @@ class Gather_scatter_rearrange_info
         Field_mem_info *get_global_field(Field_mem_info*);
         template <class T> void rearrange_gather_data(T*, T*, int);
         template <class T> void rearrange_scatter_data(T*, T*, int);
+        bool can_use_distributed_IO(Field_mem_info*, bool);
+        void write_field_distributed(Field_mem_info*, const char*, const char*, bool);
+        bool read_field_distributed(Field_mem_info*, const char*, const char*, int);
 };
 
 
@@ -57,13 +137,22 @@ class Fields_gather_scatter_mgt
 {
     private: 
         std::vector<Gather_scatter_rearrange_info*> gather_scatter_rearrange_infos;
+#ifdef USE_ASYNC_IO
+        Async_IO_writer *async_IO_writer;
+#endif
         Gather_scatter_rearrange_info *apply_gather_scatter_rearrange_info(Field_mem_info*);
+        void define_field_in_file(IO_netcdf*, Field_mem_info*, const char*, bool, int, int, bool);
 
     public:
         Field_mem_info *gather_field(Field_mem_info*);
-        Fields_gather_scatter_mgt() {}
+        Fields_gather_scatter_mgt();
         ~Fields_gather_scatter_mgt();
-        void gather_write_field(IO_netcdf*, Field_mem_info*, bool, int, int, bool);
+        void begin_write_session(IO_netcdf*);
+        void end_write_session(IO_netcdf*);
+        void release_IO_file(IO_netcdf*);
+        void wait_for_async_IO();
+        void define_write_field(IO_netcdf*, Field_mem_info*, const char*, bool, int, int, bool);
+        void gather_write_field(IO_netcdf*, Field_mem_info*, const char*, bool, int, int, bool);
         bool read_scatter_field(IO_netcdf*, Field_mem_info*, const char *, int, bool);
 };
 
@@ -9,6 +9,11 @@
 
 #include <mpi.h>
 #include <string.h>
+#include <math.h>
+#include <float.h>
+#include <map>
+#include <set>
+#include <string>
 #include "performance_timing_mgt.h"
 #include "global_data.h"
 
@@ -22,6 +27,7 @@ Performance_timing_unit::Performance_timing_unit(int comp_id, int unit_type, int
     this->unit_behavior = unit_behavior;
     this->unit_int_keyword = unit_int_keyword;
     this->comp_id = comp_id;
+    this->has_been_used = false;
     EXECUTION_REPORT(REPORT_ERROR, -1, unit_char_keyword != NULL, "the keyword (last paremeter of the interface) of a performance timing unit for computation task can not be NULL");
     if (unit_type == TIMING_TYPE_COMPUTATION || unit_type == TIMING_TYPE_COMMUNICATION)
         strcpy(this->unit_char_keyword, unit_char_keyword);
@@ -35,7 +41,8 @@ void Performance_timing_unit::check_timing_unit(int unit_type, int unit_behavior
                      "C-Coupler error in checking unit_type in match_timing_unit");
     if (unit_type == TIMING_TYPE_COMMUNICATION)
         EXECUTION_REPORT(REPORT_ERROR, -1, unit_behavior == TIMING_COMMUNICATION_RECV_WAIT || unit_behavior == TIMING_COMMUNICATION_SEND_WAIT || unit_behavior == TIMING_COMMUNICATION_SENDRECV ||
-                         unit_behavior == TIMING_COMMUNICATION_RECV_QUERRY || unit_behavior == TIMING_COMMUNICATION_SEND_QUERRY || unit_behavior == TIMING_COMMUNICATION_SEND || unit_behavior == TIMING_COMMUNICATION_RECV,
+                         unit_behavior == TIMING_COMMUNICATION_RECV_QUERRY || unit_behavior == TIMING_COMMUNICATION_SEND_QUERRY || unit_behavior == TIMING_COMMUNICATION_SEND || unit_behavior == TIMING_COMMUNICATION_RECV ||
+                         unit_behavior == TIMING_COMMUNICATION_RECV_REMOTE_WAIT || unit_behavior == TIMING_COMMUNICATION_RECV_TRANSFER,
                          "C-Coupler error in checking unit_behavior in match_timing_unit");
     if (unit_type == TIMING_TYPE_IO)
         EXECUTION_REPORT(REPORT_ERROR, -1, unit_behavior == TIMING_IO_INPUT || unit_behavior == TIMING_IO_OUTPUT || unit_behavior == TIMING_IO_RESTART,
@@ -64,10 +71,11 @@ void Performance_timing_unit::timing_start()
 {
     EXECUTION_REPORT(REPORT_ERROR, -1, previous_time == -1.0, "C-Coupler or model error in starting performance timing: timing unit has not been stoped");
     wtime(&previous_time);
+    has_been_used = true;
 }
 
 
-void Performance_timing_unit::timing_stop()
+double Performance_timing_unit::timing_stop()
 {
     double current_time;
 
@@ -77,11 +85,67 @@ void Performance_timing_unit::timing_stop()
     if (current_time >= previous_time)
         total_time += current_time - previous_time;
     previous_time = -1.0;
+
+    return current_time;
+}
+
+
+void Performance_timing_unit::get_unit_label(char *label, const char **category)
+{
+    const char *behavior_label = "";
+
+
+    if (unit_type == TIMING_TYPE_IO) {
+        *category = "io";
+        if (unit_behavior == TIMING_IO_INPUT)
+            behavior_label = "read input data";
+        else if (unit_behavior == TIMING_IO_OUTPUT)
+            behavior_label = "write output data";
+        else if (unit_behavior == TIMING_IO_RESTART)
+            behavior_label = "write restart data";
+        strcpy(label, behavior_label);
+        return;
+    }
+    if (unit_type == TIMING_TYPE_COMPUTATION) {
+        *category = "computation";
+        strcpy(label, unit_char_keyword);
+        return;
+    }
+
+    *category = "communication";
+    if (unit_behavior == TIMING_COMMUNICATION_SEND_WAIT)
+        behavior_label = "send wait";
+    else if (unit_behavior == TIMING_COMMUNICATION_RECV_WAIT)
+        behavior_label = "recv wait";
+    else if (unit_behavior == TIMING_COMMUNICATION_SENDRECV)
+        behavior_label = "sendrecv";
+    else if (unit_behavior == TIMING_COMMUNICATION_SEND_QUERRY)
+        behavior_label = "send query";
+    else if (unit_behavior == TIMING_COMMUNICATION_RECV_QUERRY)
+        behavior_label = "recv query";
+    else if (unit_behavior == TIMING_COMMUNICATION_SEND)
+        behavior_label = "send";
+    else if (unit_behavior == TIMING_COMMUNICATION_RECV)
+        behavior_label = "recv";
+    else if (unit_behavior == TIMING_COMMUNICATION_RECV_REMOTE_WAIT)
+        behavior_label = "recv remote wait";
+    else if (unit_behavior == TIMING_COMMUNICATION_RECV_TRANSFER)
+        behavior_label = "recv transfer";
+    sprintf(label, "%s %s", behavior_label, unit_char_keyword);
+}
+
+
+void Performance_timing_unit::get_unit_key(char *key)
+{
+    sprintf(key, "%d,%d,%d,%s", unit_type, unit_behavior, unit_int_keyword, unit_char_keyword);
 }
 
 
 void Performance_timing_unit::timing_output()
 {
+    if (!has_been_used)
+        return;
+
     if (unit_type == TIMING_TYPE_IO) {
         if (unit_behavior == TIMING_IO_INPUT) 
             EXECUTION_REPORT(REPORT_CONSTANTLY, comp_id, true, "TIMING RESULT: the component model \"%s\" spends %lf seconds for reading input data file at the current process\n", comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_full_name(), total_time);
@@ -101,6 +165,10 @@ void Performance_timing_unit::timing_output()
             EXECUTION_REPORT(REPORT_CONSTANTLY, comp_id, true, "TIMING RESULT: the component model \"%s\" spends %lf seconds for sending data to the component model \"%s\" (without the time of querrying buffer status) at the current process", comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_full_name(), total_time, unit_char_keyword);
         else if (unit_behavior == TIMING_COMMUNICATION_SEND_QUERRY)
             EXECUTION_REPORT(REPORT_CONSTANTLY, comp_id, true, "TIMING RESULT: the component model \"%s\" spends %lf seconds for querrying the status of the remote data buffer of the component model \"%s\" for data send at the current process", comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_full_name(), total_time, unit_char_keyword);
+        else if (unit_behavior == TIMING_COMMUNICATION_RECV_REMOTE_WAIT)
+            EXECUTION_REPORT(REPORT_CONSTANTLY, comp_id, true, "TIMING RESULT: the component model \"%s\" spends %lf seconds for waiting for the component model \"%s\" to be ready to send data at the current process", comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_full_name(), total_time, unit_char_keyword);
+        else if (unit_behavior == TIMING_COMMUNICATION_RECV_TRANSFER)
+            EXECUTION_REPORT(REPORT_CONSTANTLY, comp_id, true, "TIMING RESULT: the component model \"%s\" spends %lf seconds for transferring data from the component model \"%s\" after the first message arrives at the current process", comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_full_name(), total_time, unit_char_keyword);
         else if (unit_behavior == TIMING_COMMUNICATION_RECV_QUERRY)
             EXECUTION_REPORT(REPORT_CONSTANTLY, comp_id, true, "TIMING RESULT: the component model \"%s\" spends %lf seconds for querrying the status of the local data buffer for data receive from the component model \"%s\" at the current process", comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_full_name(), total_time, unit_char_keyword);
 //        if (unit_behavior == TIMING_COMMUNICATION_SENDRECV)
@@ -124,21 +192,182 @@ int Performance_timing_mgt::search_timing_unit(int unit_type, int unit_behavior,
 }
 
 
+Performance_timing_mgt::Performance_timing_mgt(int comp_id)
+{
+    this->comp_id = comp_id;
+    current_step_id = 0;
+    current_depth = 0;
+    num_trace_events = 0;
+}
+
+
 void Performance_timing_mgt::performance_timing_start(int unit_type, int unit_behavior, int unit_int_keyword, const char *unit_char_keyword)
 {
-    performance_timing_units[search_timing_unit(unit_type,unit_behavior,unit_int_keyword,unit_char_keyword)]->timing_start();
+    performance_timing_start(search_timing_unit(unit_type,unit_behavior,unit_int_keyword,unit_char_keyword));
 }
 
 
 void Performance_timing_mgt::performance_timing_stop(int unit_type, int unit_behavior, int unit_int_keyword, const char *unit_char_keyword)
 {
-    performance_timing_units[search_timing_unit(unit_type,unit_behavior,unit_int_keyword,unit_char_keyword)]->timing_stop();
+    performance_timing_stop(search_timing_unit(unit_type,unit_behavior,unit_int_keyword,unit_char_keyword));
+}
+
+
+void Performance_timing_mgt::performance_timing_start(int unit_handle)
+{
+    performance_timing_units[unit_handle]->timing_start();
+    current_depth ++;
+}
+
+
+void Performance_timing_mgt::performance_timing_stop(int unit_handle)
+{
+    double start_time = performance_timing_units[unit_handle]->get_previous_time();
+    double stop_time = performance_timing_units[unit_handle]->timing_stop();
+
+
+    current_depth --;
+    if (report_timing_trace_enabled)
+        record_trace_event(unit_handle, start_time, stop_time);
+}
+
+
+void Performance_timing_mgt::record_trace_event(int unit_handle, double start_time, double end_time)
+{
+    if (trace_events.size() == 0)
+        trace_events.resize(PERFORMANCE_TIMING_TRACE_BUFFER_SIZE);
+
+    Performance_timing_trace_event &trace_event = trace_events[num_trace_events%PERFORMANCE_TIMING_TRACE_BUFFER_SIZE];
+    trace_event.unit_handle = unit_handle;
+    trace_event.step_id = current_step_id;
+    trace_event.depth = current_depth;
+    trace_event.start_time = start_time;
+    trace_event.end_time = end_time;
+    num_trace_events ++;
+}
+
+
+void Performance_timing_mgt::performance_timing_dump_trace(const char *file_name)
+{
+    long first_event = num_trace_events > PERFORMANCE_TIMING_TRACE_BUFFER_SIZE? num_trace_events - PERFORMANCE_TIMING_TRACE_BUFFER_SIZE : 0;
+    int proc_id = comp_comm_group_mgt_mgr->get_current_proc_global_id();
+    const char *category;
+    char label[NAME_STR_SIZE*2];
+    FILE *trace_file;
+
+
+    if (num_trace_events == 0)
+        return;
+
+    trace_file = fopen(file_name, "w");
+    EXECUTION_REPORT(REPORT_ERROR, comp_id, trace_file != NULL, "Fail to open the file \"%s\" for writing the performance timing trace", file_name);
+    fprintf(trace_file, "{\"traceEvents\":[\n");
+    for (long i = first_event; i < num_trace_events; i ++) {
+        const Performance_timing_trace_event &trace_event = trace_events[i%PERFORMANCE_TIMING_TRACE_BUFFER_SIZE];
+        performance_timing_units[trace_event.unit_handle]->get_unit_label(label, &category);
+        for (int j = 0; label[j] != '\0'; j ++)
+            if (label[j] == '"' || label[j] == '\\')
+                label[j] = '_';
+        fprintf(trace_file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":0,\"ts\":%.3lf,\"dur\":%.3lf,\"args\":{\"step\":%d,\"depth\":%d}}%s\n", 
+                label, category, proc_id, trace_event.start_time*1.0e6, (trace_event.end_time-trace_event.start_time)*1.0e6, trace_event.step_id, trace_event.depth, i+1 < num_trace_events? "," : "");
+    }
+    fprintf(trace_file, "]}\n");
+    fclose(trace_file);
+}
+
+
+void Performance_timing_mgt::performance_timing_summarize(MPI_Comm comm, const char *file_name)
+{
+    int num_local_procs, current_proc_local_id, num_units;
+    char unit_key[NAME_STR_SIZE*3], *all_keys = NULL;
+    long all_keys_size;
+    std::vector<char> local_keys;
+    std::vector<std::string> unit_keys;
+    std::map<std::string, int> local_unit_handles;
+
+
+    EXECUTION_REPORT(REPORT_ERROR, -1, MPI_Comm_size(comm, &num_local_procs) == MPI_SUCCESS);
+    EXECUTION_REPORT(REPORT_ERROR, -1, MPI_Comm_rank(comm, &current_proc_local_id) == MPI_SUCCESS);
+
+    for (int i = 0; i < performance_timing_units.size(); i ++) {
+        if (!performance_timing_units[i]->is_used())
+            continue;
+        performance_timing_units[i]->get_unit_key(unit_key);
+        local_unit_handles[std::string(unit_key)] = i;
+        local_keys.insert(local_keys.end(), unit_key, unit_key+strlen(unit_key)+1);
+    }
+
+    gather_array_in_one_comp(num_local_procs, current_proc_local_id, local_keys.size() > 0? &local_keys[0] : NULL, local_keys.size(), sizeof(char), NULL, (void**)(&all_keys), all_keys_size, comm);
+    if (current_proc_local_id == 0) {
+        std::set<std::string> union_keys;
+        for (long offset = 0; offset < all_keys_size; offset += strlen(all_keys+offset) + 1)
+            union_keys.insert(std::string(all_keys+offset));
+        if (all_keys != NULL)
+            delete [] all_keys;
+        all_keys_size = 0;
+        for (std::set<std::string>::iterator iter = union_keys.begin(); iter != union_keys.end(); iter ++)
+            all_keys_size += iter->size() + 1;
+        all_keys = new char [all_keys_size+1];
+        all_keys_size = 0;
+        for (std::set<std::string>::iterator iter = union_keys.begin(); iter != union_keys.end(); iter ++) {
+            strcpy(all_keys+all_keys_size, iter->c_str());
+            all_keys_size += iter->size() + 1;
+        }
+    }
+    bcast_array_in_one_comp(current_proc_local_id, &all_keys, all_keys_size, comm);
+    for (long offset = 0; offset < all_keys_size; offset += strlen(all_keys+offset) + 1)
+        unit_keys.push_back(std::string(all_keys+offset));
+    if (all_keys != NULL)
+        delete [] all_keys;
+
+    num_units = unit_keys.size();
+    if (num_units == 0)
+        return;
+
+    Performance_timing_maxloc *local_max_times = new Performance_timing_maxloc [num_units];
+    Performance_timing_maxloc *global_max_times = new Performance_timing_maxloc [num_units];
+    double *local_min_times = new double [num_units], *local_sums = new double [num_units*3];
+    double *global_min_times = new double [num_units], *global_sums = new double [num_units*3];
+    for (int i = 0; i < num_units; i ++) {
+        std::map<std::string, int>::iterator iter = local_unit_handles.find(unit_keys[i]);
+        double total_time = iter == local_unit_handles.end()? 0.0 : performance_timing_units[iter->second]->get_total_time();
+        local_min_times[i] = iter == local_unit_handles.end()? DBL_MAX : total_time;
+        local_max_times[i].value = iter == local_unit_handles.end()? -1.0 : total_time;
+        local_max_times[i].proc_id = current_proc_local_id;
+        local_sums[i*3] = total_time;
+        local_sums[i*3+1] = total_time * total_time;
+        local_sums[i*3+2] = iter == local_unit_handles.end()? 0.0 : 1.0;
+    }
+    EXECUTION_REPORT(REPORT_ERROR, -1, MPI_Reduce(local_min_times, global_min_times, num_units, MPI_DOUBLE, MPI_MIN, 0, comm) == MPI_SUCCESS);
+    EXECUTION_REPORT(REPORT_ERROR, -1, MPI_Reduce(local_max_times, global_max_times, num_units, MPI_DOUBLE_INT, MPI_MAXLOC, 0, comm) == MPI_SUCCESS);
+    EXECUTION_REPORT(REPORT_ERROR, -1, MPI_Reduce(local_sums, global_sums, num_units*3, MPI_DOUBLE, MPI_SUM, 0, comm) == MPI_SUCCESS);
+
+    if (current_proc_local_id == 0) {
+        FILE *summary_file = fopen(file_name, "w");
+        EXECUTION_REPORT(REPORT_ERROR, comp_id, summary_file != NULL, "Fail to open the file \"%s\" for writing the summary of performance timing", file_name);
+        fprintf(summary_file, "unit_type,unit_behavior,keyword,num_procs,min_time,max_time,mean_time,stddev_time,imbalance,max_proc_id\n");
+        for (int i = 0; i < num_units; i ++) {
+            double num_procs = global_sums[i*3+2];
+            double mean_time = global_sums[i*3] / num_procs;
+            double variance = global_sums[i*3+1] / num_procs - mean_time * mean_time;
+            fprintf(summary_file, "%s,%d,%lf,%lf,%lf,%lf,%lf,%d\n", unit_keys[i].c_str(), (int) num_procs, global_min_times[i], global_max_times[i].value, mean_time, 
+                    sqrt(variance > 0.0? variance : 0.0), mean_time > 0.0? global_max_times[i].value/mean_time : 1.0, global_max_times[i].proc_id);
+        }
+        fclose(summary_file);
+    }
+
+    delete [] local_max_times;
+    delete [] local_min_times;
+    delete [] local_sums;
+    delete [] global_min_times;
+    delete [] global_sums;
+    delete [] global_max_times;
 }
 
 
 void Performance_timing_mgt::performance_timing_add(int unit_type, int unit_behavior, int unit_int_keyword, const char *unit_char_keyword, double time_inc)
 {
-    performance_timing_units[search_timing_unit(unit_type,unit_behavior,unit_int_keyword,unit_char_keyword)]->timing_add(time_inc);
+    performance_timing_add(search_timing_unit(unit_type,unit_behavior,unit_int_keyword,unit_char_keyword), time_inc);
 }
 
 
@@ -11,7 +11,9 @@
 #define PERFORMANCE_TIMING_MGT_H
 
 
+#include <mpi.h>
 #include <vector>
+#include <stdio.h>
 
 
 #define TIMING_TYPE_COMMUNICATION         1
@@ -25,6 +27,8 @@
 #define TIMING_COMMUNICATION_RECV_QUERRY 15
 #define TIMING_COMMUNICATION_SEND        16
 #define TIMING_COMMUNICATION_RECV        17
+#define TIMING_COMMUNICATION_RECV_REMOTE_WAIT  18
+#define TIMING_COMMUNICATION_RECV_TRANSFER     19
 
 
 #define TIMING_IO_INPUT                  21
@@ -37,6 +41,8 @@
 #define TIMING_COMPUTATION_V1D_WEIGHT    34
 #define TIMING_COMPUTATION_V1D_COORD     35
 
+#define PERFORMANCE_TIMING_TRACE_BUFFER_SIZE   65536
+
 
 
 class Performance_timing_unit
@@ -49,6 +55,7 @@ class Performance_timing_unit
         double previous_time;
         double total_time;
         int comp_id;
+        bool has_been_used;
 
         void check_timing_unit(int, int, int, const char*);
 
@@ -56,29 +63,69 @@ class Performance_timing_unit
         Performance_timing_unit(int, int, int, int, const char*);
         ~Performance_timing_unit(){}
         void timing_start();
-        void timing_stop();
+        double timing_stop();
         void timing_output();
         bool match_timing_unit(int, int, int, const char*);
-        void timing_add(double time_inc) { total_time += time_inc; }
+        void timing_add(double time_inc) { total_time += time_inc; has_been_used = true; }
         void timing_reset() { total_time = 0.0; }
+        double get_previous_time() { return previous_time; }
+        double get_total_time() { return total_time; }
+        bool is_used() { return has_been_used; }
+        void get_unit_label(char*, const char**);
+        void get_unit_key(char*);
+};
+
+
+struct Performance_timing_trace_event
+{
+    int unit_handle;
+    int step_id;
+    int depth;
+    double start_time;
+    double end_time;
 };
 
 
+struct Performance_timing_maxloc
+{
+    double value;
+    int proc_id;
+};
+
+
+/* A timing unit can be registered once to get an integer handle, so that starting or stopping it costs only a clock read.
+   When the timing trace is enabled, each stopped scope is also recorded in a ring buffer of the latest 
+   PERFORMANCE_TIMING_TRACE_BUFFER_SIZE events, which can be dumped as a Chrome trace (JSON) timeline.
+   performance_timing_summarize is collective over the processes of the component: it reduces each timing unit to
+   min/max/mean/stddev and the process with the maximum, so that the load imbalance can be read from one file */
 class Performance_timing_mgt
 {
     private:
         std::vector<Performance_timing_unit*> performance_timing_units;
         int search_timing_unit(int, int, int, const char*);
         int comp_id;
+        int current_step_id;
+        int current_depth;
+        std::vector<Performance_timing_trace_event> trace_events;
+        long num_trace_events;
+
+        void record_trace_event(int, double, double);
 
     public: 
-        Performance_timing_mgt(int comp_id) { this->comp_id = comp_id; }
+        Performance_timing_mgt(int);
         ~Performance_timing_mgt();
+        int register_timing_unit(int unit_type, int unit_behavior, int unit_int_keyword, const char *unit_char_keyword) { return search_timing_unit(unit_type, unit_behavior, unit_int_keyword, unit_char_keyword); }
         void performance_timing_start(int, int, int, const char*);
         void performance_timing_stop(int, int, int, const char*);
         void performance_timing_add(int, int, int, const char*, double);
+        void performance_timing_start(int);
+        void performance_timing_stop(int);
+        void performance_timing_add(int unit_handle, double time_inc) { performance_timing_units[unit_handle]->timing_add(time_inc); }
+        void performance_timing_set_step(int step_id) { current_step_id = step_id; }
         void performance_timing_output();
         void performance_timing_reset();
+        void performance_timing_dump_trace(const char*);
+        void performance_timing_summarize(MPI_Comm, const char*);
 };
 
 #endif
@@ -16,8 +16,9 @@
 #include "CCPL_api_mgt.h"
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 
-Routing_info *Routing_info_mgt::search_or_add_router(const int src_comp_id, const int dst_comp_id, const char *src_decomp_name, const char *dst_decomp_name)
+Routing_info *Routing_info_mgt::search_or_add_router(const int src_comp_id, const int dst_comp_id, const char *src_decomp_name, const char *dst_decomp_name, int comm_tag)
 {
     Routing_info *router;
 
@@ -26,7 +27,7 @@ Routing_info *Routing_info_mgt::search_or_add_router(const int src_comp_id, cons
     if (router != NULL)
         return router;
 
-    router = new Routing_info(src_comp_id, dst_comp_id, src_decomp_name, dst_decomp_name);
+    router = new Routing_info(src_comp_id, dst_comp_id, src_decomp_name, dst_decomp_name, comm_tag);
     routers.push_back(router);
 
     return router;
@@ -37,6 +38,44 @@ Routing_info_mgt::~Routing_info_mgt()
 {
     for (int i = 0; i < routers.size(); i ++)
         delete routers[i];
+
+    for (int i = 0; i < routers_union_comms.size(); i ++) {
+        if (routers_union_comms[i]->is_union_comm_created)
+            MPI_Comm_free(&(routers_union_comms[i]->union_comm));
+        delete [] routers_union_comms[i]->src_proc_ranks_in_union_comm;
+        delete [] routers_union_comms[i]->dst_proc_ranks_in_union_comm;
+        delete routers_union_comms[i];
+    }
+}
+
+
+/* The union communicator of a pair of components is created at the first rendezvous router between them and is reused 
+   by the following routers, because creating a communicator is a collective operation that is expensive with a lot of 
+   processes. */
+Router_union_comm *Routing_info_mgt::search_or_add_router_union_comm(Comp_comm_group_mgt_node *src_comp_node, Comp_comm_group_mgt_node *dst_comp_node, int comm_tag)
+{
+    std::vector<int> src_procs_global_ids, dst_procs_global_ids;
+    Router_union_comm *router_union_comm;
+
+
+    for (int i = 0; i < routers_union_comms.size(); i ++)
+        if (words_are_the_same(routers_union_comms[i]->src_comp_full_name, src_comp_node->get_comp_full_name()) && words_are_the_same(routers_union_comms[i]->dst_comp_full_name, dst_comp_node->get_comp_full_name()))
+            return routers_union_comms[i];
+
+    router_union_comm = new Router_union_comm;
+    strcpy(router_union_comm->src_comp_full_name, src_comp_node->get_comp_full_name());
+    strcpy(router_union_comm->dst_comp_full_name, dst_comp_node->get_comp_full_name());
+    router_union_comm->src_proc_ranks_in_union_comm = new int [src_comp_node->get_num_procs()];
+    router_union_comm->dst_proc_ranks_in_union_comm = new int [dst_comp_node->get_num_procs()];
+    for (int i = 0; i < src_comp_node->get_num_procs(); i ++)
+        src_procs_global_ids.push_back(src_comp_node->get_local_proc_global_id(i));
+    for (int i = 0; i < dst_comp_node->get_num_procs(); i ++)
+        dst_procs_global_ids.push_back(dst_comp_node->get_local_proc_global_id(i));
+    router_union_comm->union_comm = create_union_comm_common(src_comp_node->get_comm_group(), dst_comp_node->get_comm_group(), src_comp_node->get_current_proc_local_id(), dst_comp_node->get_current_proc_local_id(), src_procs_global_ids, dst_procs_global_ids, comm_tag, router_union_comm->src_proc_ranks_in_union_comm, router_union_comm->dst_proc_ranks_in_union_comm);
+    router_union_comm->is_union_comm_created = router_union_comm->union_comm != src_comp_node->get_comm_group() && router_union_comm->union_comm != dst_comp_node->get_comm_group();
+    routers_union_comms.push_back(router_union_comm);
+
+    return router_union_comm;
 }
 
 
@@ -50,7 +89,7 @@ Routing_info *Routing_info_mgt::search_router(const int src_comp_id, const int d
 }
 
 
-Routing_info::Routing_info(const int src_comp_id, const int dst_comp_id, const char *src_decomp_name, const char *dst_decomp_name)
+Routing_info::Routing_info(const int src_comp_id, const int dst_comp_id, const char *src_decomp_name, const char *dst_decomp_name, int comm_tag)
 {
     src_decomp_info = decomps_info_mgr->search_decomp_info(src_decomp_name, src_comp_id);
     dst_decomp_info = decomps_info_mgr->search_decomp_info(dst_decomp_name, dst_comp_id);
@@ -87,7 +126,9 @@ Routing_info::Routing_info(const int src_comp_id, const int dst_comp_id, const c
     }
     else {
         num_dimensions = 2;
-        build_2D_router();
+        if (src_comp_node->get_num_procs() + dst_comp_node->get_num_procs() >= MIN_NUM_PROCS_FOR_RENDEZVOUS_ROUTER)
+            build_2D_router_with_rendezvous(comm_tag);
+        else build_2D_router();
         if (current_proc_id_src_comp != -1) 
             src_decomp_size = src_decomp_info->get_num_local_cells();
         if (current_proc_id_dst_comp != -1) 
@@ -138,6 +179,7 @@ void Routing_info::build_2D_router()
     int dst_comp_root_proc_global_id = dst_comp_node->get_root_proc_global_id();
     Routing_info_with_one_process *routing_info;
     long total_src_cells, total_dst_cells;
+    std::vector<std::pair<int,int> > sorted_local_cells;
 
 
     if (current_proc_id_src_comp != -1) {
@@ -174,9 +216,10 @@ void Routing_info::build_2D_router()
     
     if (current_proc_id_src_comp != -1) {
         int tmp_displs = 0;
+        sort_local_cells_global_indexes(num_local_src_cells, src_decomp_info->get_local_cell_global_indx(), sorted_local_cells);
         for (int i = 0; i < num_dst_procs; i ++) {
-            routing_info = compute_routing_info_between_decomps(num_local_src_cells, src_decomp_info->get_local_cell_global_indx(), num_cells_each_dst_proc[i], cells_indx_each_dst_proc+tmp_displs, 
-                                                                src_decomp_info->get_num_global_cells(), comp_comm_group_mgt_mgr->get_current_proc_global_id(), dst_comp_node->get_local_proc_global_id(i), true);
+            routing_info = compute_routing_info_between_decomps(num_local_src_cells, src_decomp_info->get_local_cell_global_indx(), sorted_local_cells, num_cells_each_dst_proc[i], cells_indx_each_dst_proc+tmp_displs, 
+                                                                comp_comm_group_mgt_mgr->get_current_proc_global_id(), dst_comp_node->get_local_proc_global_id(i), true);
             tmp_displs += num_cells_each_dst_proc[i];
             send_to_remote_procs_routing_info.push_back(routing_info);
         }
@@ -184,9 +227,10 @@ void Routing_info::build_2D_router()
 
     if (current_proc_id_dst_comp != -1) {
         int tmp_displs = 0;
+        sort_local_cells_global_indexes(num_local_dst_cells, dst_decomp_info->get_local_cell_global_indx(), sorted_local_cells);
         for (int i = 0; i < num_src_procs; i ++) {
-            routing_info = compute_routing_info_between_decomps(num_local_dst_cells, dst_decomp_info->get_local_cell_global_indx(), num_cells_each_src_proc[i], cells_indx_each_src_proc+tmp_displs, 
-                                                                dst_decomp_info->get_num_global_cells(), comp_comm_group_mgt_mgr->get_current_proc_global_id(), src_comp_node->get_local_proc_global_id(i), false);
+            routing_info = compute_routing_info_between_decomps(num_local_dst_cells, dst_decomp_info->get_local_cell_global_indx(), sorted_local_cells, num_cells_each_src_proc[i], cells_indx_each_src_proc+tmp_displs, 
+                                                                comp_comm_group_mgt_mgr->get_current_proc_global_id(), src_comp_node->get_local_proc_global_id(i), false);
             tmp_displs += num_cells_each_src_proc[i];
             recv_from_remote_procs_routing_info.push_back(routing_info);
         }
@@ -203,101 +247,276 @@ void Routing_info::build_2D_router()
 }
 
 
-Routing_info_with_one_process *Routing_info::compute_routing_info_between_decomps(int num_local_cells_local, const int *local_cells_global_indexes_local, 
-                                                  int num_local_cells_remote, const int *local_cells_global_indexes_remote, 
-                                                  int num_global_cells, int local_proc_id, int remote_proc_id, bool is_src)
+/* Pairs of (global index, local index) of the valid local cells, sorted by global index. When a global index appears 
+   more than once in the local decomposition, only its last local index is kept. The table is built once per router and 
+   is shared by the intersections with all remote processes, instead of filling lookup tables of the global grid size. */
+void Routing_info::sort_local_cells_global_indexes(int num_local_cells, const int *local_cells_global_indexes, std::vector<std::pair<int,int> > &sorted_local_cells)
 {
-    Routing_info_with_one_process *routing_info;
-    const int *reference_cell_indx;
-    int *logical_indx_lookup_table_local, *logical_indx_lookup_table_remote; 
-    int num_reference_cells;
-    int last_local_logical_indx;
-    int j;
+    int i, j;
 
 
-    routing_info = new Routing_info_with_one_process;
-    routing_info->num_elements_transferred = 0;
-    routing_info->num_local_indx_segments = 0;
-    routing_info->remote_proc_global_id = remote_proc_id;
+    sorted_local_cells.clear();
+    sorted_local_cells.reserve(num_local_cells);
+    for (i = 0; i < num_local_cells; i ++)
+        if (local_cells_global_indexes[i] >= 0 && local_cells_global_indexes[i] != CCPL_NULL_INT)
+            sorted_local_cells.push_back(std::make_pair(local_cells_global_indexes[i], i));
+    std::sort(sorted_local_cells.begin(), sorted_local_cells.end());
 
-    if (num_local_cells_local == 0)
-        return routing_info;
-    
-    /* Determine the reference cell index table according to the table size */
-    if (is_src) {
-        reference_cell_indx = local_cells_global_indexes_remote;
-        num_reference_cells = num_local_cells_remote;  
-    }
-    else {
-        reference_cell_indx = local_cells_global_indexes_local;
-        num_reference_cells = num_local_cells_local; 
+    for (i = 0, j = 0; i < sorted_local_cells.size(); i ++) {
+        if (j > 0 && sorted_local_cells[j-1].first == sorted_local_cells[i].first)
+            j --;
+        sorted_local_cells[j++] = sorted_local_cells[i];
     }
+    sorted_local_cells.resize(j);
+}
+
+
+static int search_local_indx_of_global_indx(const std::vector<std::pair<int,int> > &sorted_local_cells, int global_indx)
+{
+    std::vector<std::pair<int,int> >::const_iterator iter = std::lower_bound(sorted_local_cells.begin(), sorted_local_cells.end(), std::make_pair(global_indx, -1));
 
-    logical_indx_lookup_table_remote = new int [num_global_cells];
-    logical_indx_lookup_table_local = new int [num_global_cells];
-    for (j = 0; j < num_global_cells; j ++) {
-        logical_indx_lookup_table_local[j] = -1;
-        logical_indx_lookup_table_remote[j] = -1;
+
+    if (iter == sorted_local_cells.end() || iter->first != global_indx)
+        return -1;
+    return iter->second;
+}
+
+
+struct Router_rendezvous_record
+{
+    int global_indx;
+    int proc_id;
+    int local_indx;
+
+    bool operator < (const Router_rendezvous_record &other) const
+    {
+        if (global_indx != other.global_indx)
+            return global_indx < other.global_indx;
+        if (local_indx != other.local_indx)
+            return local_indx < other.local_indx;
+        return proc_id < other.proc_id;
     }
+};
+
+
+static bool compare_router_rendezvous_record_by_proc(const Router_rendezvous_record &record1, const Router_rendezvous_record &record2)
+{
+    if (record1.proc_id != record2.proc_id)
+        return record1.proc_id < record2.proc_id;
+    return record1.local_indx < record2.local_indx;
+}
+
+
+static void exchange_router_rendezvous_records(std::vector<std::vector<Router_rendezvous_record> > &records_to_procs, std::vector<Router_rendezvous_record> &records_from_procs, MPI_Comm comm)
+{
+    int num_procs = records_to_procs.size();
+    int *send_counts = new int [num_procs];
+    int *send_displs = new int [num_procs];
+    int *recv_counts = new int [num_procs];
+    int *recv_displs = new int [num_procs];
+    int num_ints_per_record = sizeof(Router_rendezvous_record) / sizeof(int);
+    std::vector<Router_rendezvous_record> send_records;
     
-    for (j = 0; j < num_local_cells_local; j ++)
-        if (local_cells_global_indexes_local[j] >= 0)
-            if (local_cells_global_indexes_local[j] != CCPL_NULL_INT)
-                logical_indx_lookup_table_local[local_cells_global_indexes_local[j]] = j;
-    for (j = 0; j < num_local_cells_remote; j ++)
-        if (local_cells_global_indexes_remote[j] >= 0)
-            if (local_cells_global_indexes_remote[j] != CCPL_NULL_INT)
-                logical_indx_lookup_table_remote[local_cells_global_indexes_remote[j]] = j;
-
-    /* Compute the number of common cells and the number of segments of common cells */
-    last_local_logical_indx = -100;
-    for (j = 0; j < num_reference_cells; j ++) 
-        if (reference_cell_indx[j] != CCPL_NULL_INT && logical_indx_lookup_table_local[reference_cell_indx[j]] != -1 && logical_indx_lookup_table_remote[reference_cell_indx[j]] != -1) {
-			if (reference_cell_indx == local_cells_global_indexes_local) {
-	            if (last_local_logical_indx + 1 != j) 
-	                routing_info->num_local_indx_segments ++;
-	            last_local_logical_indx = j;
-	            routing_info->num_elements_transferred ++;				
-			}
-			else {
-	            if (last_local_logical_indx + 1 != logical_indx_lookup_table_local[reference_cell_indx[j]]) 
-	                routing_info->num_local_indx_segments ++;
-	            last_local_logical_indx = logical_indx_lookup_table_local[reference_cell_indx[j]];
-	            routing_info->num_elements_transferred ++;
-			}
+
+    for (int i = 0; i < num_procs; i ++) {
+        send_counts[i] = records_to_procs[i].size() * num_ints_per_record;
+        send_displs[i] = send_records.size() * num_ints_per_record;
+        send_records.insert(send_records.end(), records_to_procs[i].begin(), records_to_procs[i].end());
+        records_to_procs[i].clear();
+    }
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
+    recv_displs[0] = 0;
+    for (int i = 1; i < num_procs; i ++)
+        recv_displs[i] = recv_displs[i-1] + recv_counts[i-1];
+    records_from_procs.resize((recv_displs[num_procs-1]+recv_counts[num_procs-1]) / num_ints_per_record + 1);
+    send_records.resize(send_records.size()+1);
+    MPI_Alltoallv((int*)(&send_records[0]), send_counts, send_displs, MPI_INT, (int*)(&records_from_procs[0]), recv_counts, recv_displs, MPI_INT, comm);
+    records_from_procs.resize(records_from_procs.size()-1);
+
+    delete [] send_counts;
+    delete [] send_displs;
+    delete [] recv_counts;
+    delete [] recv_displs;
+}
+
+
+/* Rendezvous construction of the router: the global cell indexes are distributed in blocks among the processes of the
+   union of the two components. Each process registers its cells to the owners of the blocks, the owners match the src 
+   and dst cells, and each process finally receives only the common cells with its own peers. No process holds the 
+   decompositions of all processes, which is necessary when the components have a lot of processes. */
+void Routing_info::build_2D_router_with_rendezvous(int comm_tag)
+{
+    int num_src_procs = src_comp_node->get_num_procs();
+    int num_dst_procs = dst_comp_node->get_num_procs();
+    int *src_proc_ranks_in_union_comm, *dst_proc_ranks_in_union_comm;
+    Router_union_comm *router_union_comm;
+    std::vector<std::pair<int,int> > sorted_local_src_cells;
+    std::vector<std::vector<Router_rendezvous_record> > records_to_procs;
+    std::vector<Router_rendezvous_record> records_from_procs;
+    std::vector<int> common_cells_local_indx;
+    Router_rendezvous_record record;
+    int num_global_cells[2], max_num_global_cells[2], num_union_procs, cells_block_size;
+    MPI_Comm union_comm;
+    int i, j, k, l;
+
+
+    router_union_comm = routing_info_mgr->search_or_add_router_union_comm(src_comp_node, dst_comp_node, comm_tag);
+    src_proc_ranks_in_union_comm = router_union_comm->src_proc_ranks_in_union_comm;
+    dst_proc_ranks_in_union_comm = router_union_comm->dst_proc_ranks_in_union_comm;
+    union_comm = router_union_comm->union_comm;
+    MPI_Comm_size(union_comm, &num_union_procs);
+
+    num_global_cells[0] = -1;
+    num_global_cells[1] = -1;
+    if (current_proc_id_src_comp != -1) {
+        EXECUTION_REPORT(REPORT_ERROR, -1, src_decomp_info != NULL, "Software error in Routing_info::build_2D_router_with_rendezvous: NULL src decomp info");
+        num_global_cells[0] = src_decomp_info->get_num_global_cells();
+    }
+    if (current_proc_id_dst_comp != -1) {
+        EXECUTION_REPORT(REPORT_ERROR, -1, dst_decomp_info != NULL, "Software error in Routing_info::build_2D_router_with_rendezvous: NULL dst decomp info");
+        num_global_cells[1] = dst_decomp_info->get_num_global_cells();
+    }
+    MPI_Allreduce(num_global_cells, max_num_global_cells, 2, MPI_INT, MPI_MAX, union_comm);
+    EXECUTION_REPORT(REPORT_ERROR, -1, max_num_global_cells[0] == max_num_global_cells[1], "Software error in Routing_info::build_2D_router_with_rendezvous: different global decomp grid size: %d vs %d", max_num_global_cells[0], max_num_global_cells[1]);
+    cells_block_size = (max_num_global_cells[0] + num_union_procs - 1) / num_union_procs;
+    if (cells_block_size == 0)
+        cells_block_size = 1;
+
+    /* Register the src cells (once per global index) and the dst cells (every occurrence) to the block owners */
+    records_to_procs.resize(num_union_procs);
+    if (current_proc_id_src_comp != -1) {
+        sort_local_cells_global_indexes(src_decomp_info->get_num_local_cells(), src_decomp_info->get_local_cell_global_indx(), sorted_local_src_cells);
+        for (i = 0; i < sorted_local_src_cells.size(); i ++) {
+            record.global_indx = sorted_local_src_cells[i].first;
+            record.proc_id = current_proc_id_src_comp;
+            record.local_indx = -1;
+            records_to_procs[record.global_indx/cells_block_size].push_back(record);
         }
+    }
+    if (current_proc_id_dst_comp != -1) {
+        const int *local_cells_global_indexes = dst_decomp_info->get_local_cell_global_indx();
+        for (i = 0; i < dst_decomp_info->get_num_local_cells(); i ++)
+            if (local_cells_global_indexes[i] >= 0 && local_cells_global_indexes[i] != CCPL_NULL_INT) {
+                record.global_indx = local_cells_global_indexes[i];
+                record.proc_id = current_proc_id_dst_comp;
+                record.local_indx = i;
+                records_to_procs[record.global_indx/cells_block_size].push_back(record);
+            }
+    }
+    exchange_router_rendezvous_records(records_to_procs, records_from_procs, union_comm);
+
+    /* Match the registered cells. The src records of a global index are sorted before its dst records. The matches are 
+       first sent to the src processes and then to the dst processes, always keyed by the dst local index. */
+    std::sort(records_from_procs.begin(), records_from_procs.end());
+    for (int role = 0; role < 2; role ++) {
+        records_to_procs.resize(num_union_procs);
+        for (i = 0; i < records_from_procs.size(); i = j) {
+            for (j = i; j < records_from_procs.size() && records_from_procs[j].global_indx == records_from_procs[i].global_indx && records_from_procs[j].local_indx == -1; j ++);
+            for (k = j; k < records_from_procs.size() && records_from_procs[k].global_indx == records_from_procs[i].global_indx; k ++)
+                for (l = i; l < j; l ++) {
+                    record.global_indx = records_from_procs[k].global_indx;
+                    record.local_indx = records_from_procs[k].local_indx;
+                    if (role == 0) {
+                        record.proc_id = records_from_procs[k].proc_id;
+                        records_to_procs[src_proc_ranks_in_union_comm[records_from_procs[l].proc_id]].push_back(record);
+                    }
+                    else {
+                        record.proc_id = records_from_procs[l].proc_id;
+                        records_to_procs[dst_proc_ranks_in_union_comm[records_from_procs[k].proc_id]].push_back(record);
+                    }
+                }
+            j = k;
+        }
+        std::vector<Router_rendezvous_record> matched_records;
+        exchange_router_rendezvous_records(records_to_procs, matched_records, union_comm);
+        std::sort(matched_records.begin(), matched_records.end(), compare_router_rendezvous_record_by_proc);
+        if (role == 0 && current_proc_id_src_comp != -1) {
+            for (i = 0, j = 0; i < num_dst_procs; i ++) {
+                common_cells_local_indx.clear();
+                for (; j < matched_records.size() && matched_records[j].proc_id == i; j ++)
+                    common_cells_local_indx.push_back(search_local_indx_of_global_indx(sorted_local_src_cells, matched_records[j].global_indx));
+                send_to_remote_procs_routing_info.push_back(generate_routing_info_from_common_cells(dst_comp_node->get_local_proc_global_id(i), common_cells_local_indx));
+            }
+        }
+        if (role == 1 && current_proc_id_dst_comp != -1) {
+            for (i = 0, j = 0; i < num_src_procs; i ++) {
+                common_cells_local_indx.clear();
+                for (; j < matched_records.size() && matched_records[j].proc_id == i; j ++)
+                    common_cells_local_indx.push_back(matched_records[j].local_indx);
+                recv_from_remote_procs_routing_info.push_back(generate_routing_info_from_common_cells(src_comp_node->get_local_proc_global_id(i), common_cells_local_indx));
+            }
+        }
+    }
+}
+
+
+/* The common cells are ordered as the cells of the dst decomposition. The sender therefore walks the remote cells and 
+   looks them up in the sorted local cells, while the receiver walks its local cells and looks them up in the sorted 
+   remote cells. The cost is O((local+remote) log(local+remote)) per remote process. */
+Routing_info_with_one_process *Routing_info::compute_routing_info_between_decomps(int num_local_cells_local, const int *local_cells_global_indexes_local, const std::vector<std::pair<int,int> > &sorted_local_cells,
+                                                  int num_local_cells_remote, const int *local_cells_global_indexes_remote, 
+                                                  int local_proc_id, int remote_proc_id, bool is_src)
+{
+    std::vector<int> common_cells_local_indx;
+    std::vector<int> sorted_remote_cells;
+    int j, local_indx;
+
 
-    /* Compute the info of segments when there are common cells */
-    last_local_logical_indx = -100;
-    if (routing_info->num_elements_transferred > 0) {
-        routing_info->local_indx_segment_starts = new int [routing_info->num_local_indx_segments];
-        routing_info->local_indx_segment_lengths = new int [routing_info->num_local_indx_segments];
-        routing_info->num_local_indx_segments = 0;
-        for (j = 0; j < num_reference_cells; j ++) 
-            if (reference_cell_indx[j] != CCPL_NULL_INT && logical_indx_lookup_table_local[reference_cell_indx[j]] != -1 && logical_indx_lookup_table_remote[reference_cell_indx[j]] != -1) {
-				if (reference_cell_indx == local_cells_global_indexes_local) {
-	                if (last_local_logical_indx + 1 != j) {
-	                    routing_info->local_indx_segment_starts[routing_info->num_local_indx_segments] = j;
-	                    routing_info->local_indx_segment_lengths[routing_info->num_local_indx_segments] = 1;
-	                    routing_info->num_local_indx_segments ++;
-	                }
-	                else routing_info->local_indx_segment_lengths[routing_info->num_local_indx_segments - 1] ++;
-	                last_local_logical_indx = j;
-				}
-				else {
-	                if (last_local_logical_indx + 1 != logical_indx_lookup_table_local[reference_cell_indx[j]]) {
-	                    routing_info->local_indx_segment_starts[routing_info->num_local_indx_segments] = logical_indx_lookup_table_local[reference_cell_indx[j]];
-	                    routing_info->local_indx_segment_lengths[routing_info->num_local_indx_segments] = 1;
-	                    routing_info->num_local_indx_segments ++;
-	                }
-	                else routing_info->local_indx_segment_lengths[routing_info->num_local_indx_segments - 1] ++;
-	                last_local_logical_indx = logical_indx_lookup_table_local[reference_cell_indx[j]];
-				}
+    if (num_local_cells_local == 0 || num_local_cells_remote == 0 || sorted_local_cells.size() == 0)
+        return generate_routing_info_from_common_cells(remote_proc_id, common_cells_local_indx);
+
+    if (is_src) {
+        for (j = 0; j < num_local_cells_remote; j ++)
+            if (local_cells_global_indexes_remote[j] >= 0 && local_cells_global_indexes_remote[j] != CCPL_NULL_INT) {
+                local_indx = search_local_indx_of_global_indx(sorted_local_cells, local_cells_global_indexes_remote[j]);
+                if (local_indx != -1)
+                    common_cells_local_indx.push_back(local_indx);
             }
     }
+    else {
+        sorted_remote_cells.reserve(num_local_cells_remote);
+        for (j = 0; j < num_local_cells_remote; j ++)
+            if (local_cells_global_indexes_remote[j] >= 0 && local_cells_global_indexes_remote[j] != CCPL_NULL_INT)
+                sorted_remote_cells.push_back(local_cells_global_indexes_remote[j]);
+        std::sort(sorted_remote_cells.begin(), sorted_remote_cells.end());
+        for (j = 0; j < num_local_cells_local; j ++)
+            if (local_cells_global_indexes_local[j] >= 0 && local_cells_global_indexes_local[j] != CCPL_NULL_INT)
+                if (std::binary_search(sorted_remote_cells.begin(), sorted_remote_cells.end(), local_cells_global_indexes_local[j]))
+                    common_cells_local_indx.push_back(j);
+    }
+
+    return generate_routing_info_from_common_cells(remote_proc_id, common_cells_local_indx);
+}
+
+
+/* Merge the local indexes of the common cells (in the order of transfer) into segments */
+Routing_info_with_one_process *Routing_info::generate_routing_info_from_common_cells(int remote_proc_id, const std::vector<int> &common_cells_local_indx)
+{
+    Routing_info_with_one_process *routing_info;
+    int j;
+
+
+    routing_info = new Routing_info_with_one_process;
+    routing_info->num_elements_transferred = common_cells_local_indx.size();
+    routing_info->num_local_indx_segments = 0;
+    routing_info->remote_proc_global_id = remote_proc_id;
+    if (routing_info->num_elements_transferred == 0)
+        return routing_info;
 
-    delete [] logical_indx_lookup_table_remote;
-    delete [] logical_indx_lookup_table_local;
+    for (j = 0; j < common_cells_local_indx.size(); j ++)
+        if (j == 0 || common_cells_local_indx[j-1] + 1 != common_cells_local_indx[j])
+            routing_info->num_local_indx_segments ++;
+    routing_info->local_indx_segment_starts = new int [routing_info->num_local_indx_segments];
+    routing_info->local_indx_segment_lengths = new int [routing_info->num_local_indx_segments];
+    routing_info->num_local_indx_segments = 0;
+    for (j = 0; j < common_cells_local_indx.size(); j ++) {
+        if (j == 0 || common_cells_local_indx[j-1] + 1 != common_cells_local_indx[j]) {
+            routing_info->local_indx_segment_starts[routing_info->num_local_indx_segments] = common_cells_local_indx[j];
+            routing_info->local_indx_segment_lengths[routing_info->num_local_indx_segments] = 1;
+            routing_info->num_local_indx_segments ++;
+        }
+        else routing_info->local_indx_segment_lengths[routing_info->num_local_indx_segments - 1] ++;
+    }
 
     return routing_info;
 }
@@ -19,6 +19,9 @@
 #include <vector>
 
 
+#define MIN_NUM_PROCS_FOR_RENDEZVOUS_ROUTER      256
+
+
 struct Routing_info_with_one_process
 {
     int remote_proc_global_id;
@@ -30,6 +33,17 @@ struct Routing_info_with_one_process
 };
 
 
+struct Router_union_comm
+{
+    char src_comp_full_name[NAME_STR_SIZE];
+    char dst_comp_full_name[NAME_STR_SIZE];
+    MPI_Comm union_comm;
+    bool is_union_comm_created;
+    int *src_proc_ranks_in_union_comm;
+    int *dst_proc_ranks_in_union_comm;
+};
+
+
 class Routing_info
 {
     private:
@@ -61,7 +75,7 @@ class Routing_info
         std::vector<Routing_info_with_one_process *> send_to_remote_procs_routing_info;
 
     public:
-        Routing_info(const int, const int, const char*, const char*);
+        Routing_info(const int, const int, const char*, const char*, int);
         ~Routing_info();
         Routing_info_with_one_process *get_routing_info(bool, int);
         int get_num_elements_transferred_with_remote_proc(bool is_send, int i) { return get_routing_info(is_send,i)->num_elements_transferred; }
@@ -79,7 +93,10 @@ class Routing_info
         
     private:
         void build_2D_router();
-        Routing_info_with_one_process *compute_routing_info_between_decomps(int, const int*, int, const int*, int, int, int, bool);
+        void build_2D_router_with_rendezvous(int);
+        Routing_info_with_one_process *generate_routing_info_from_common_cells(int, const std::vector<int>&);
+        void sort_local_cells_global_indexes(int, const int*, std::vector<std::pair<int,int> >&);
+        Routing_info_with_one_process *compute_routing_info_between_decomps(int, const int*, const std::vector<std::pair<int,int> >&, int, const int*, int, int, bool);
 };
 
 
@@ -87,12 +104,14 @@ class Routing_info_mgt
 {
     private:
         std::vector<Routing_info *> routers;
+        std::vector<Router_union_comm *> routers_union_comms;
     
     public:
         Routing_info_mgt() {}
         ~Routing_info_mgt();
         Routing_info *search_router(const int, const int, const char*, const char*);
-        Routing_info *search_or_add_router(const int, const int, const char*, const char*);
+        Routing_info *search_or_add_router(const int, const int, const char*, const char*, int);
+        Router_union_comm *search_or_add_router_union_comm(Comp_comm_group_mgt_node*, Comp_comm_group_mgt_node*, int);
 };
 
 #endif
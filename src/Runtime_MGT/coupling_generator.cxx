@@ -243,7 +243,7 @@ void Coupling_connection::generate_data_transfer()
             dst_comp_id = dst_comp_node->get_comp_id();
         }
         transfer_array_from_one_comp_to_another(current_proc_id_dst_comp, dst_comp_root_proc_global_id, current_proc_id_src_comp, src_comp_root_proc_global_id, src_comp_node->get_comm_group(), &temp_dst_decomp_name, content_size);
-        fields_router[i] = routing_info_mgr->search_or_add_router(src_comp_node->get_comp_id(), dst_comp_id, src_fields_info[i]->decomp_name, temp_dst_decomp_name);
+        fields_router[i] = routing_info_mgr->search_or_add_router(src_comp_node->get_comp_id(), dst_comp_id, src_fields_info[i]->decomp_name, temp_dst_decomp_name, connection_id);
         if (current_proc_id_src_comp != -1)
             src_fields_mem[i] = export_procedure->get_data_transfer_field_instance(i);
         if (current_proc_id_dst_comp != -1)
@@ -26,6 +26,9 @@
 #define USING_AVERAGE_VALUE                  1
 
 
+extern MPI_Comm create_union_comm_common(MPI_Comm, MPI_Comm, int, int, std::vector<int>&, std::vector<int>&, int, int*, int*);
+
+
 class Import_interface_configuration;
 class Coupling_generator;
 class IO_output_procedure;
@@ -23,18 +23,19 @@ Connection_field_time_info::Connection_field_time_info(Inout_interface *inout_in
     this->inout_interface = inout_interface;
     this->timer = timer;
     this->inst_or_aver = inst_or_aver;
+    this->time_mgr = components_time_mgrs->get_time_mgr(inout_interface->get_comp_id());
     if (IS_TIME_UNIT_SECOND(timer->get_frequency_unit()))
         lag_seconds = timer->get_remote_lag_count();
     else lag_seconds = timer->get_remote_lag_count() * SECONDS_PER_DAY;
 
-    if (!(components_time_mgrs->get_time_mgr(inout_interface->get_comp_id())->get_runtype_mark() == RUNTYPE_MARK_CONTINUE || components_time_mgrs->get_time_mgr(inout_interface->get_comp_id())->get_runtype_mark() == RUNTYPE_MARK_BRANCH)) {
+    if (!(time_mgr->get_runtype_mark() == RUNTYPE_MARK_CONTINUE || time_mgr->get_runtype_mark() == RUNTYPE_MARK_BRANCH)) {
         this->current_year = current_year;
         this->current_month = current_month;
         this->current_day = current_day;
         this->current_second = current_second;
-        current_num_elapsed_days = components_time_mgrs->get_time_mgr(inout_interface->get_comp_id())->get_current_num_elapsed_day();
+        current_num_elapsed_days = time_mgr->get_current_num_elapsed_day();
         this->time_step_in_second = time_step_in_second;
-        if (components_time_mgrs->get_time_mgr(inout_interface->get_comp_id())->is_timer_on(timer->get_frequency_unit(), timer->get_frequency_count(), timer->get_local_lag_count())) {
+        if (time_mgr->is_timer_on(timer->get_frequency_unit(), timer->get_frequency_count(), timer->get_local_lag_count())) {
             last_timer_num_elapsed_days = current_num_elapsed_days;
 			last_timer_date = current_year*10000 + current_month*100 + current_day;
             last_timer_second = current_second;
@@ -47,7 +48,7 @@ Connection_field_time_info::Connection_field_time_info(Inout_interface *inout_in
         next_timer_num_elapsed_days = -1;
 		next_timer_date = -1;
         next_timer_second = -1;
-        timer->get_time_of_next_timer_on(components_time_mgrs->get_time_mgr(inout_interface->get_comp_id()), current_year, current_month, current_day,
+        timer->get_time_of_next_timer_on(time_mgr, current_year, current_month, current_day,
                                          current_second, current_num_elapsed_days, time_step_in_second, next_timer_num_elapsed_days, next_timer_date, next_timer_second, true);
     }
 }
@@ -55,7 +56,7 @@ Connection_field_time_info::Connection_field_time_info(Inout_interface *inout_in
 
 void Connection_field_time_info::get_time_of_next_timer_on(bool advance)
 {
-    timer->get_time_of_next_timer_on(components_time_mgrs->get_time_mgr(inout_interface->get_comp_id()), current_year, current_month, current_day,
+    timer->get_time_of_next_timer_on(time_mgr, current_year, current_month, current_day,
                                      current_second, current_num_elapsed_days, time_step_in_second, next_timer_num_elapsed_days, next_timer_date, next_timer_second, advance);
 }
 
@@ -110,7 +111,14 @@ Connection_coupling_procedure::Connection_coupling_procedure(Inout_interface *in
     remote_bypass_counter = -1;
 	last_receive_sender_time = CCPL_NULL_LONG;
     is_coupling_time_out_of_execution = false;
+    send_pending = false;
     restart_mgr = comp_comm_group_mgt_mgr->search_global_node(inout_interface->get_comp_id())->get_restart_mgr();
+    time_mgr = components_time_mgrs->get_time_mgr(inout_interface->get_comp_id());
+    performance_timing_mgr = comp_comm_group_mgt_mgr->get_global_node_of_local_comp(inout_interface->get_comp_id(),false,"")->get_performance_timing_mgr();
+    interface_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMPUTATION, -1, -1, inout_interface->get_interface_name());
+    remap_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMPUTATION, -1, -1, "data interpolation");
+    datatype_transform_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMPUTATION, -1, -1, "data type transformation");
+    average_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMPUTATION, -1, -1, "data average");
 
     for (int i = 0; i < coupling_connection->fields_name.size(); i ++)
         for (int j=i+1; j < coupling_connection->fields_name.size(); j ++)
@@ -250,7 +258,6 @@ Connection_coupling_procedure::~Connection_coupling_procedure()
 
 void Connection_coupling_procedure::execute(bool bypass_timer, int *field_update_status, const char *annotation)
 {
-    Time_mgt *time_mgr = components_time_mgrs->get_time_mgr(inout_interface->get_comp_id());
     int lag_seconds;
 
 
@@ -340,22 +347,22 @@ void Connection_coupling_procedure::execute(bool bypass_timer, int *field_update
             else {
                 runtime_data_transfer_algorithm->pass_transfer_parameters(current_remote_fields_time, inout_interface->get_bypass_counter());
                 runtime_data_transfer_algorithm->run(bypass_timer);
-                comp_comm_group_mgt_mgr->get_global_node_of_local_comp(inout_interface->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, inout_interface->get_interface_name());
+                performance_timing_mgr->performance_timing_start(interface_timing_unit);
                 for (int i = fields_mem_registered.size() - 1; i >= 0; i --) {
-                        comp_comm_group_mgt_mgr->get_global_node_of_local_comp(inout_interface->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "data interpolation");
+                        performance_timing_mgr->performance_timing_start(remap_timing_unit);
                         if (runtime_remap_algorithms[i] != NULL)
                             runtime_remap_algorithms[i]->run(true);
-                        comp_comm_group_mgt_mgr->get_global_node_of_local_comp(inout_interface->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "data interpolation");
-                        comp_comm_group_mgt_mgr->get_global_node_of_local_comp(inout_interface->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "data type transformation");
+                        performance_timing_mgr->performance_timing_stop(remap_timing_unit);
+                        performance_timing_mgr->performance_timing_start(datatype_transform_timing_unit);
                         if (runtime_datatype_transform_algorithms[i] != NULL)
                             runtime_datatype_transform_algorithms[i]->run(true);                                
-                        comp_comm_group_mgt_mgr->get_global_node_of_local_comp(inout_interface->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "data type transformation");
-                        comp_comm_group_mgt_mgr->get_global_node_of_local_comp(inout_interface->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "data average");
+                        performance_timing_mgr->performance_timing_stop(datatype_transform_timing_unit);
+                        performance_timing_mgr->performance_timing_start(average_timing_unit);
                         if (runtime_inter_averaging_algorithm[i] != NULL)
                             runtime_inter_averaging_algorithm[i]->run(true);
-                        comp_comm_group_mgt_mgr->get_global_node_of_local_comp(inout_interface->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "data average");
+                        performance_timing_mgr->performance_timing_stop(average_timing_unit);
                 }
-                comp_comm_group_mgt_mgr->get_global_node_of_local_comp(inout_interface->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, inout_interface->get_interface_name());
+                performance_timing_mgr->performance_timing_stop(interface_timing_unit);
                 if (!bypass_timer && !inout_interface->get_is_child_interface() && (restart_mgr->is_in_restart_write_window(current_remote_fields_elapsed_time, true))) {
                     EXECUTION_REPORT_LOG(REPORT_LOG, inout_interface->get_comp_id(), true, "Should write the remote data at the remote time %ld and local %ld into the restart data file", current_remote_fields_elapsed_time, time_mgr->get_current_num_elapsed_day()*((long)100000)+time_mgr->get_current_second());
                     for (int i = 0; i < fields_mem_registered.size(); i ++)
@@ -458,6 +465,16 @@ void Connection_coupling_procedure::send_fields(bool bypass_timer)
 {
     EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR, -1, inout_interface->get_interface_type() == COUPLING_INTERFACE_MARK_EXPORT && !finish_status && transfer_data, "Software error in Connection_coupling_procedure::send_fields");
     finish_status = runtime_data_transfer_algorithm->run(bypass_timer);
+    send_pending = true;
+}
+
+
+void Connection_coupling_procedure::complete_sending_data()
+{
+    if (!send_pending)
+        return;
+    runtime_data_transfer_algorithm->complete_send();
+    send_pending = false;
 }
 
 
@@ -1029,10 +1046,10 @@ void Inout_interface::execute(bool bypass_timer, int API_id, int *field_update_s
         }
     }
 
-    long current_execution_time = ((long)time_mgr->get_current_num_elapsed_day())*100000 + components_time_mgrs->get_time_mgr(comp_id)->get_current_second();
+    long current_execution_time = ((long)time_mgr->get_current_num_elapsed_day())*100000 + time_mgr->get_current_second();
     if (current_execution_time == last_execution_time && !bypass_timer && !at_first_normal_step) {
         int current_year, current_month, current_day, current_second;
-        components_time_mgrs->get_time_mgr(comp_id)->get_current_time(current_year, current_month, current_day, current_second, 0, "CCPL internal");
+        time_mgr->get_current_time(current_year, current_month, current_day, current_second, 0, "CCPL internal");
         EXECUTION_REPORT(REPORT_WARNING, comp_id, false, "The import/export interface \"%s\", which is called at the model code with the annotation \"%s\", will not be executed again at the time step %04d-%02d-%02d-%05d, because it has been executed at the same time step before.",
                          interface_name, annotation, current_year, current_month, current_day, current_second);
         return;
@@ -1041,8 +1058,8 @@ void Inout_interface::execute(bool bypass_timer, int API_id, int *field_update_s
     last_execution_time = current_execution_time;
 
     if (interface_type == COUPLING_INTERFACE_MARK_NORMAL_REMAP || interface_type == COUPLING_INTERFACE_MARK_FRAC_REMAP) {
-        for (int i = 0; i < fields_mem_registered.size(); i ++)
-            fields_mem_registered[i]->check_field_sum("before executing a remap interface");
+        if (fields_mem_registered.size() > 0)
+            memory_manager->check_sum_of_fields(&fields_mem_registered[0], fields_mem_registered.size(), "before executing a remap interface");
         if (interface_type == COUPLING_INTERFACE_MARK_FRAC_REMAP)
             preprocessing_for_frac_based_remapping();
         children_interfaces[0]->execute(bypass_timer, API_id, field_update_status, size_field_update_status+1, annotation);
@@ -1053,8 +1070,8 @@ void Inout_interface::execute(bool bypass_timer, int API_id, int *field_update_s
     }
 
     if (interface_type == COUPLING_INTERFACE_MARK_EXPORT) {
-        for (int i = 0; i < fields_mem_registered.size(); i ++)
-            fields_mem_registered[i]->check_field_sum("before executing an export interface");
+        if (fields_mem_registered.size() > 0)
+            memory_manager->check_sum_of_fields(&fields_mem_registered[0], fields_mem_registered.size(), "before executing an export interface");
         EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "after checking all source fields");
     }
     
@@ -1081,8 +1098,8 @@ void Inout_interface::execute(bool bypass_timer, int API_id, int *field_update_s
     }
 
     if (interface_type == COUPLING_INTERFACE_MARK_IMPORT) {
-        for (int i = 0; i < fields_mem_registered.size(); i ++)
-            fields_mem_registered[i]->check_field_sum("after executing an export interface");
+        if (fields_mem_registered.size() > 0)
+            memory_manager->check_sum_of_fields(&fields_mem_registered[0], fields_mem_registered.size(), "after executing an export interface");
     }
 }
 
@@ -1256,6 +1273,18 @@ int Inout_interface::check_is_import_field_connected(int field_instance_id, cons
 }
 
 
+/* CCPL_complete_export_interface should be called after an execution of the export interface and before its next execution, 
+   so that the data transfer overlaps the model computation in between. The data sent by the last execution is completed 
+   by the next execution anyway, and a repeated call without an execution in between has no effect. */
+void Inout_interface::complete_export(const char *annotation)
+{
+    EXECUTION_REPORT(REPORT_ERROR, comp_id, interface_type == COUPLING_INTERFACE_MARK_EXPORT, "ERROR happens when calling the API \"CCPL_complete_export_interface\": the corresponding coupling interface \"%s\" is not an export interface. Please verify the model code with the annotation \"%s\".", interface_name, annotation);
+
+    for (int i = 0; i < coupling_procedures.size(); i ++)
+        coupling_procedures[i]->complete_sending_data();
+}
+
+
 void Inout_interface::get_sender_time(int size_sender_date, int size_sender_elapsed_days, int size_sender_second, int *sender_date, int *sender_elapsed_days, int *sender_second, const char *annotation)
 {
     EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR, comp_id, interface_type == COUPLING_INTERFACE_MARK_IMPORT, "ERROR happens when calling the API \"CCPL_get_import_fields_sender_time\": the corresponding coupling interface \"%s\" is not an import interface. Please verify the model code with the annotation \"%s\".", interface_name, annotation);
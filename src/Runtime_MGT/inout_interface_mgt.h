@@ -64,6 +64,7 @@ class Connection_field_time_info
         int lag_seconds;
         Coupling_timer *timer;
         Inout_interface *inout_interface;
+        Time_mgt *time_mgr;
 
         Connection_field_time_info(Inout_interface*, Coupling_timer*, int, int, int, int, int, int);
         void get_time_of_next_timer_on(bool);
@@ -102,9 +103,16 @@ class Connection_coupling_procedure
         bool transfer_data;
         bool coupling_connections_dumped;
         Restart_mgt *restart_mgr;
+        Time_mgt *time_mgr;
         int remote_bypass_counter;
         bool is_coupling_time_out_of_execution;
+        bool send_pending;
 		long last_receive_sender_time;
+        Performance_timing_mgt *performance_timing_mgr;
+        int interface_timing_unit;
+        int remap_timing_unit;
+        int datatype_transform_timing_unit;
+        int average_timing_unit;
         
     public:
         Connection_coupling_procedure(Inout_interface*, Coupling_connection*);
@@ -112,6 +120,7 @@ class Connection_coupling_procedure
         void add_data_transfer_algorithm(Runtime_trans_algorithm * runtime_algorithm) { runtime_data_transfer_algorithm = runtime_algorithm; }
         void execute(bool, int*, const char*);
         void send_fields(bool);
+        void complete_sending_data();
         Field_mem_info *get_data_transfer_field_instance(int); 
         int get_num_runtime_remap_algorithms() { return runtime_remap_algorithms.size(); }
         Runtime_remap_algorithm *get_runtime_remap_algorithm(int i) { return runtime_remap_algorithms[i]; }
@@ -191,6 +200,7 @@ class Inout_interface
         int get_h2d_grid_area_in_remapping_weights(const char *, int, void *, int, const char *, const char *);
         void set_fields_necessity(int*, int, const char *);
         int check_is_import_field_connected(int, const char *);
+        void complete_export(const char *);
         void dump_active_coupling_connections();
         void dump_active_coupling_connections_into_XML(TiXmlElement *);
         void import_restart_data(Restart_buffer_container *);
@@ -10,6 +10,10 @@
 #include "global_data.h"
 #include "remapping_configuration_mgt.h"
 #include "CCPL_api_mgt.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 
 H2D_remapping_wgt_file_info::H2D_remapping_wgt_file_info(const char *wgt_file_name)
@@ -153,7 +157,6 @@ bool H2D_remapping_wgt_file_info::match_H2D_remapping_wgt(Original_grid_info *sr
     }
     read_weight_grid_data(dst_original_grid->get_comp_id(), "area_a", DATA_TYPE_DOUBLE, (void**)(&src_area), src_grid_size, false);
     read_weight_grid_data(dst_original_grid->get_comp_id(), "area_b", DATA_TYPE_DOUBLE, (void**)(&dst_area), dst_grid_size, false);
-    read_remapping_weights(dst_original_grid->get_comp_id());
 
     matched_grid_pair.push_back(std::make_pair(src_original_grid, dst_original_grid));
     return true;
@@ -261,6 +264,11 @@ void H2D_remapping_wgt_file_info::read_remapping_weights(int comp_id)
     }
     else EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "Load remapping weight file %s", wgt_file_name);
 
+    if (H2D_grid_decomp_mask != NULL && num_procs_in_file_read_comm == comp_node->get_num_procs() && num_procs_in_file_read_comm > 1 && read_remapping_weights_distributed(comp_id, file_read_comm)) {
+        MPI_Comm_free(&file_read_comm);
+        return;
+    }
+
     IO_netcdf *netcdf_file_object = new IO_netcdf("remapping weights file for H2D interpolation", wgt_file_name, "r", false);
     EXECUTION_REPORT(REPORT_ERROR, comp_comm_group_mgt_mgr->get_global_node_root()->get_comp_id(), src_grid_size > 0, "Error happens when reading the remapping weights file \"%s\": fail to read the size of the source grid (dimension \"n_a\" in the file). Please verify.", wgt_file_name);
     EXECUTION_REPORT(REPORT_ERROR, comp_comm_group_mgt_mgr->get_global_node_root()->get_comp_id(), dst_grid_size > 0, "Error happens when reading the remapping weights file \"%s\": fail to read the size of the target grid (dimension \"n_a\" in the file). Please verify.", wgt_file_name);
@@ -288,6 +296,298 @@ void H2D_remapping_wgt_file_info::read_remapping_weights(int comp_id)
 }
 
 
+/* When the remapping weights are only required for the local target cells (H2D_grid_decomp_mask), each process reads a
+   block of the weights in the file and the weights are sent to the process owning their target cells via one all-to-all,
+   so that no process holds all weights. It returns false (the weights are then read by the root and broadcast) when a 
+   target cell is owned by more than one process */
+bool H2D_remapping_wgt_file_info::read_remapping_weights_distributed(int comp_id, MPI_Comm file_read_comm)
+{
+    int local_proc_id, num_procs, *dst_cell_owner, *temp_dst_cell_owner, *block_src_indexes, *block_dst_indexes;
+    int *send_counts, *recv_counts, *send_displs, *recv_displs;
+    long num_wgts_in_file, block_start, block_size, i;
+    double *block_values;
+    bool unique_owner = true;
+    MPI_Datatype wgt_entry_type;
+    struct Wgt_entry {
+        long src_index;
+        long dst_index;
+        double value;
+    } *send_entries, *recv_entries;
+
+
+    MPI_Comm_rank(file_read_comm, &local_proc_id);
+    MPI_Comm_size(file_read_comm, &num_procs);
+
+    dst_cell_owner = new int [dst_grid_size];
+    temp_dst_cell_owner = new int [dst_grid_size];
+    for (i = 0; i < dst_grid_size; i ++)
+        temp_dst_cell_owner[i] = H2D_grid_decomp_mask[i]? local_proc_id : -1;
+    MPI_Allreduce(temp_dst_cell_owner, dst_cell_owner, dst_grid_size, MPI_INT, MPI_MAX, file_read_comm);
+    for (i = 0; i < dst_grid_size; i ++)
+        temp_dst_cell_owner[i] = H2D_grid_decomp_mask[i]? local_proc_id : num_procs;
+    MPI_Allreduce(MPI_IN_PLACE, temp_dst_cell_owner, dst_grid_size, MPI_INT, MPI_MIN, file_read_comm);
+    for (i = 0; i < dst_grid_size; i ++)
+        if (dst_cell_owner[i] != -1 && temp_dst_cell_owner[i] != dst_cell_owner[i])
+            unique_owner = false;
+    delete [] temp_dst_cell_owner;
+    if (!unique_owner) {
+        delete [] dst_cell_owner;
+        return false;
+    }
+
+    IO_netcdf *netcdf_file_object = new IO_netcdf("remapping weights file for H2D interpolation", wgt_file_name, "r", false);
+    num_wgts_in_file = netcdf_file_object->get_dimension_size("n_s", file_read_comm, local_proc_id == 0);
+    EXECUTION_REPORT(REPORT_ERROR, comp_comm_group_mgt_mgr->get_global_node_root()->get_comp_id(), num_wgts_in_file >= 0, "Error happens when reading the remapping weights file \"%s\": fail to read the number of remapping weights (dimension \"n_s\" in the file). Please verify.", wgt_file_name);
+    block_start = num_wgts_in_file * local_proc_id / num_procs;
+    block_size = num_wgts_in_file * (local_proc_id+1) / num_procs - block_start;
+    block_src_indexes = new int [block_size];
+    block_dst_indexes = new int [block_size];
+    block_values = new double [block_size];
+    EXECUTION_REPORT(REPORT_ERROR, comp_comm_group_mgt_mgr->get_global_node_root()->get_comp_id(), netcdf_file_object->read_file_field_block("col", block_start, block_size, block_src_indexes, DATA_TYPE_INT), "Error happens when reading the remapping weights file \"%s\": fail to read the variable \"col\". Please verify.", wgt_file_name);
+    EXECUTION_REPORT(REPORT_ERROR, comp_comm_group_mgt_mgr->get_global_node_root()->get_comp_id(), netcdf_file_object->read_file_field_block("row", block_start, block_size, block_dst_indexes, DATA_TYPE_INT), "Error happens when reading the remapping weights file \"%s\": fail to read the variable \"row\". Please verify.", wgt_file_name);
+    EXECUTION_REPORT(REPORT_ERROR, comp_comm_group_mgt_mgr->get_global_node_root()->get_comp_id(), netcdf_file_object->read_file_field_block("S", block_start, block_size, block_values, DATA_TYPE_DOUBLE), "Error happens when reading the remapping weights file \"%s\": fail to read the variable \"S\". Please verify.", wgt_file_name);
+    delete netcdf_file_object;
+
+    send_counts = new int [num_procs];
+    recv_counts = new int [num_procs];
+    send_displs = new int [num_procs];
+    recv_displs = new int [num_procs];
+    for (i = 0; i < num_procs; i ++)
+        send_counts[i] = 0;
+    for (i = 0; i < block_size; i ++) {
+        EXECUTION_REPORT(REPORT_ERROR, comp_comm_group_mgt_mgr->get_global_node_root()->get_comp_id(), block_src_indexes[i] >= 1 && block_src_indexes[i] <= src_grid_size, "Error happens when reading the remapping weights file \"%s\": some values in the variable \"col\" are out of the bound of source grid size. Please verify.", wgt_file_name);
+        EXECUTION_REPORT(REPORT_ERROR, comp_comm_group_mgt_mgr->get_global_node_root()->get_comp_id(), block_dst_indexes[i] >= 1 && block_dst_indexes[i] <= dst_grid_size, "Error happens when reading the remapping weights file \"%s\": some values in the variable \"row\" are out of the bound of target grid size. Please verify.", wgt_file_name);
+        if (dst_cell_owner[block_dst_indexes[i]-1] != -1)
+            send_counts[dst_cell_owner[block_dst_indexes[i]-1]] ++;
+    }
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, file_read_comm);
+    send_displs[0] = 0;
+    recv_displs[0] = 0;
+    for (i = 1; i < num_procs; i ++) {
+        send_displs[i] = send_displs[i-1] + send_counts[i-1];
+        recv_displs[i] = recv_displs[i-1] + recv_counts[i-1];
+    }
+    send_entries = new Wgt_entry [send_displs[num_procs-1]+send_counts[num_procs-1]+1];
+    num_wgts = recv_displs[num_procs-1] + recv_counts[num_procs-1];
+    recv_entries = new Wgt_entry [num_wgts+1];
+    for (i = 0; i < block_size; i ++) {
+        int owner = dst_cell_owner[block_dst_indexes[i]-1];
+        if (owner == -1)
+            continue;
+        send_entries[send_displs[owner]].src_index = block_src_indexes[i] - 1;
+        send_entries[send_displs[owner]].dst_index = block_dst_indexes[i] - 1;
+        send_entries[send_displs[owner]].value = block_values[i];
+        send_displs[owner] ++;
+    }
+    for (i = 0; i < num_procs; i ++)
+        send_displs[i] -= send_counts[i];
+    delete [] block_src_indexes;
+    delete [] block_dst_indexes;
+    delete [] block_values;
+    delete [] dst_cell_owner;
+
+    MPI_Type_contiguous(sizeof(Wgt_entry), MPI_BYTE, &wgt_entry_type);
+    MPI_Type_commit(&wgt_entry_type);
+    MPI_Alltoallv(send_entries, send_counts, send_displs, wgt_entry_type, recv_entries, recv_counts, recv_displs, wgt_entry_type, file_read_comm);
+    MPI_Type_free(&wgt_entry_type);
+
+    wgts_src_indexes = new long [num_wgts];
+    wgts_dst_indexes = new long [num_wgts];
+    wgts_values = new double [num_wgts];
+    for (i = 0; i < num_wgts; i ++) {
+        wgts_src_indexes[i] = recv_entries[i].src_index;
+        wgts_dst_indexes[i] = recv_entries[i].dst_index;
+        wgts_values[i] = recv_entries[i].value;
+    }
+    EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "Load %ld of the %ld remapping weights in the file %s for the local target cells", num_wgts, num_wgts_in_file, wgt_file_name);
+
+    delete [] send_entries;
+    delete [] recv_entries;
+    delete [] send_counts;
+    delete [] recv_counts;
+    delete [] send_displs;
+    delete [] recv_displs;
+
+    return true;
+}
+
+
+/* Loads the remapping weights of the local target cells (H2D_grid_decomp_mask) from a remapping weight cache written by a 
+   previous run. It is collective among the processes of the component and returns false when the cache is missing, stale 
+   or does not cover the target cells of any process */
+bool H2D_remapping_wgt_file_info::read_remapping_wgt_cache(int comp_id, long key, int src_grid_size, int dst_grid_size)
+{
+    int local_cache_status, overall_cache_status;
+    Comp_comm_group_mgt_node *comp_node = comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id, false, "in H2D_remapping_wgt_file_info::read_remapping_wgt_cache");
+
+
+    clean();
+    local_cache_status = load_remapping_wgt_cache_of_local_cells(key, src_grid_size, dst_grid_size)? 1 : 0;
+    MPI_Allreduce(&local_cache_status, &overall_cache_status, 1, MPI_INT, MPI_MIN, comp_node->get_comm_group());
+    if (overall_cache_status == 0) {
+        clean();
+        num_wgts = 0;
+        EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "The remapping weight cache %s is not available", wgt_file_name);
+        return false;
+    }
+
+    this->src_grid_size = src_grid_size;
+    this->dst_grid_size = dst_grid_size;
+    EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "Load %ld remapping weights of the local target cells from the remapping weight cache %s", num_wgts, wgt_file_name);
+
+    return true;
+}
+
+
+bool H2D_remapping_wgt_file_info::load_remapping_wgt_cache_of_local_cells(long key, int src_grid_size, int dst_grid_size)
+{
+    H2D_remapping_wgt_cache_header *header;
+    const long *row_offsets;
+    const double *values;
+    const int *src_indexes;
+    const unsigned char *covered_cells;
+    struct stat file_stat;
+    size_t file_size;
+    void *file_map;
+    long i, j, k;
+    int fd;
+    bool cache_usable = true;
+
+
+    fd = open(wgt_file_name, O_RDONLY);
+    if (fd == -1)
+        return false;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t) sizeof(H2D_remapping_wgt_cache_header)) {
+        close(fd);
+        return false;
+    }
+    file_size = file_stat.st_size;
+    file_map = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (file_map == MAP_FAILED)
+        return false;
+
+    header = (H2D_remapping_wgt_cache_header*) file_map;
+    if (strncmp(header->magic, "CCPLWGTC", 8) != 0 || header->format_version != H2D_REMAPPING_WGT_CACHE_VERSION || header->header_size != sizeof(H2D_remapping_wgt_cache_header) || 
+        header->key != key || header->src_grid_size != src_grid_size || header->dst_grid_size != dst_grid_size || header->num_wgts < 0 || 
+        file_size != sizeof(H2D_remapping_wgt_cache_header) + (dst_grid_size+1)*sizeof(long) + header->num_wgts*(sizeof(double)+sizeof(int)) + dst_grid_size) {
+        munmap(file_map, file_size);
+        return false;
+    }
+    row_offsets = (const long*) ((const char*) file_map + sizeof(H2D_remapping_wgt_cache_header));
+    values = (const double*) (row_offsets + dst_grid_size + 1);
+    src_indexes = (const int*) (values + header->num_wgts);
+    covered_cells = (const unsigned char*) (src_indexes + header->num_wgts);
+
+    num_wgts = 0;
+    for (i = 0; i < dst_grid_size && cache_usable; i ++) {
+        if (H2D_grid_decomp_mask != NULL && !H2D_grid_decomp_mask[i])
+            continue;
+        if (covered_cells[i] == 0 || row_offsets[i] < 0 || row_offsets[i] > row_offsets[i+1] || row_offsets[i+1] > header->num_wgts)
+            cache_usable = false;
+        else num_wgts += row_offsets[i+1] - row_offsets[i];
+    }
+    if (cache_usable) {
+        wgts_src_indexes = new long [num_wgts];
+        wgts_dst_indexes = new long [num_wgts];
+        wgts_values = new double [num_wgts];
+        for (i = 0, k = 0; i < dst_grid_size; i ++) {
+            if (H2D_grid_decomp_mask != NULL && !H2D_grid_decomp_mask[i])
+                continue;
+            for (j = row_offsets[i]; j < row_offsets[i+1]; j ++, k ++) {
+                if (src_indexes[j] < 0 || src_indexes[j] >= src_grid_size)
+                    cache_usable = false;
+                wgts_src_indexes[k] = src_indexes[j];
+                wgts_dst_indexes[k] = i;
+                wgts_values[k] = values[j];
+            }
+        }
+    }
+    munmap(file_map, file_size);
+
+    return cache_usable;
+}
+
+
+/* The cache groups the weights by target cell, so that a process only touches the rows of its local target cells. It is 
+   written under a temporary name and then renamed, so that another run never maps a partially written cache */
+void H2D_remapping_wgt_file_info::write_remapping_wgt_cache(const char *cache_file_name, long key, int src_grid_size, int dst_grid_size, Remap_weight_sparse_matrix *weight_sparse_matrix, const bool *covered_dst_cells)
+{
+    H2D_remapping_wgt_cache_header header;
+    char temp_file_name[NAME_STR_SIZE*2];
+    long num_wgts = weight_sparse_matrix->get_num_weights(), *row_offsets, i, pos;
+    bool coo_was_released = weight_sparse_matrix->restore_coo_format();
+    long *wgts_src_indexes = weight_sparse_matrix->get_indexes_src_grid(), *wgts_dst_indexes = weight_sparse_matrix->get_indexes_dst_grid();
+    double *values;
+    int *src_indexes;
+    unsigned char *covered_cells;
+    bool write_succeed;
+    FILE *fp;
+
+
+    row_offsets = new long [dst_grid_size+1];
+    values = new double [num_wgts+1];
+    src_indexes = new int [num_wgts+1];
+    covered_cells = new unsigned char [dst_grid_size+1];
+    for (i = 0; i <= dst_grid_size; i ++)
+        row_offsets[i] = 0;
+    for (i = 0; i < num_wgts; i ++) {
+        EXECUTION_REPORT(REPORT_ERROR, -1, wgts_dst_indexes[i] >= 0 && wgts_dst_indexes[i] < dst_grid_size && wgts_src_indexes[i] >= 0 && wgts_src_indexes[i] < src_grid_size, "Software error in H2D_remapping_wgt_file_info::write_remapping_wgt_cache");
+        row_offsets[wgts_dst_indexes[i]+1] ++;
+    }
+    for (i = 0; i < dst_grid_size; i ++)
+        row_offsets[i+1] += row_offsets[i];
+    for (i = 0; i < num_wgts; i ++) {
+        pos = row_offsets[wgts_dst_indexes[i]] ++;
+        values[pos] = weight_sparse_matrix->get_weight_values()[i];
+        src_indexes[pos] = wgts_src_indexes[i];
+    }
+    if (coo_was_released)
+        weight_sparse_matrix->release_coo_format();
+    for (i = dst_grid_size; i > 0; i --)
+        row_offsets[i] = row_offsets[i-1];
+    row_offsets[0] = 0;
+    for (i = 0; i < dst_grid_size; i ++)
+        covered_cells[i] = (covered_dst_cells == NULL || covered_dst_cells[i])? 1 : 0;
+
+    memset(&header, 0, sizeof(H2D_remapping_wgt_cache_header));
+    memcpy(header.magic, "CCPLWGTC", 8);
+    header.format_version = H2D_REMAPPING_WGT_CACHE_VERSION;
+    header.header_size = sizeof(H2D_remapping_wgt_cache_header);
+    header.key = key;
+    header.src_grid_size = src_grid_size;
+    header.dst_grid_size = dst_grid_size;
+    header.num_wgts = num_wgts;
+
+    sprintf(temp_file_name, "%s.%d.%ld.tmp", cache_file_name, comp_comm_group_mgt_mgr->get_current_proc_global_id(), (long) getpid());
+    fp = fopen(temp_file_name, "wb");
+    if (fp != NULL) {
+        write_succeed = fwrite(&header, sizeof(H2D_remapping_wgt_cache_header), 1, fp) == 1;
+        write_succeed = write_succeed && fwrite(row_offsets, sizeof(long), dst_grid_size+1, fp) == dst_grid_size+1;
+        write_succeed = write_succeed && fwrite(values, sizeof(double), num_wgts, fp) == num_wgts;
+        write_succeed = write_succeed && fwrite(src_indexes, sizeof(int), num_wgts, fp) == num_wgts;
+        write_succeed = write_succeed && fwrite(covered_cells, 1, dst_grid_size, fp) == dst_grid_size;
+        write_succeed = fclose(fp) == 0 && write_succeed;
+        if (!write_succeed || rename(temp_file_name, cache_file_name) != 0) {
+            remove(temp_file_name);
+            write_succeed = false;
+        }
+    }
+    else write_succeed = false;
+    if (write_succeed) {
+        EXECUTION_REPORT_LOG(REPORT_LOG, -1, true, "Write %ld remapping weights into the remapping weight cache %s", num_wgts, cache_file_name);
+    }
+    else {
+        EXECUTION_REPORT_LOG(REPORT_LOG, -1, true, "Fail to write the remapping weight cache %s", cache_file_name);
+    }
+
+    delete [] row_offsets;
+    delete [] values;
+    delete [] src_indexes;
+    delete [] covered_cells;
+}
+
+
 void H2D_remapping_wgt_file_info::clean()
 {
     if (wgts_src_indexes != NULL) {
@@ -1016,6 +1316,7 @@ void Remapping_setting::shrink(Original_grid_info *src_grid, Original_grid_info
 Remapping_configuration::Remapping_configuration()
 {
     comp_id = -1;
+    num_remapping_threads = 0;
     remapping_settings.push_back(new Remapping_setting(REMAP_OPERATOR_NAME_BILINEAR, "state"));
     remapping_settings.push_back(new Remapping_setting(REMAP_OPERATOR_NAME_CONSERV_2D, "flux"));
 }
@@ -1024,11 +1325,21 @@ Remapping_configuration::Remapping_configuration()
 Remapping_configuration::Remapping_configuration(int comp_id, const char *XML_file_name, TiXmlDocument *XML_file)
 {
     this->comp_id = comp_id;
+    this->num_remapping_threads = 0;
     for (TiXmlNode *XML_element_node = get_XML_first_child_of_unique_root(comp_id,XML_file_name,XML_file); XML_element_node != NULL; XML_element_node = XML_element_node->NextSibling()) {
         if (XML_element_node->Type() != TiXmlNode::TINYXML_ELEMENT)
             continue;
         TiXmlElement *XML_element = XML_element_node->ToElement();
-        EXECUTION_REPORT(REPORT_ERROR, comp_id, words_are_the_same(XML_element->Value(), "remapping_setting"), "\"%s\" is not a legal attribute (the legal is \"remapping_setting\") for defining a remapping setting. Please verify the XML file arround the line number %d.", XML_element->Value(), XML_element->Row());
+        EXECUTION_REPORT(REPORT_ERROR, comp_id, words_are_the_same(XML_element->Value(), "remapping_setting") || words_are_the_same(XML_element->Value(), "remapping_threads"), "\"%s\" is not a legal attribute (the legal is \"remapping_setting\" or \"remapping_threads\") for defining a remapping setting. Please verify the XML file arround the line number %d.", XML_element->Value(), XML_element->Row());
+        if (words_are_the_same(XML_element->Value(), "remapping_threads")) {
+            if (!is_XML_setting_on(comp_id, XML_element, XML_file_name, "the status of the number of threads for remapping", "remapping configuration"))
+                continue;
+            int line_number;
+            EXECUTION_REPORT(REPORT_ERROR, comp_id, num_remapping_threads == 0, "The number of threads for remapping has been specified more than once in the XML file \"%s\". Please verify the XML file arround the line number %d.", XML_file_name, XML_element->Row());
+            const char *num_threads_string = get_XML_attribute(comp_id, -1, XML_element, "number", XML_file_name, line_number, "the number of threads for remapping", "remapping configuration", true);
+            EXECUTION_REPORT(REPORT_ERROR, comp_id, sscanf(num_threads_string, "%d", &num_remapping_threads) == 1 && num_remapping_threads > 0, "The number of threads for remapping (currently is \"%s\") must be a positive integer. Please verify the XML file \"%s\" arround the line number %d.", num_threads_string, XML_file_name, line_number);
+            continue;
+        }
         if (!is_XML_setting_on(comp_id, XML_element, XML_file_name, "the status of a remapping setting", "remapping configuration"))
             continue;
         remapping_settings.push_back(new Remapping_setting(comp_id, XML_element, XML_file_name));
@@ -1129,3 +1440,15 @@ void Remapping_configuration_mgt::get_field_remapping_setting(Remapping_setting
 //    field_remapping_setting.print();
 }
 
+
+int Remapping_configuration_mgt::get_num_remapping_threads(int comp_id)
+{
+    Comp_comm_group_mgt_node *current_comp_node = comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id, false, "in Remapping_configuration_mgt::get_num_remapping_threads");
+    for (; current_comp_node != NULL; current_comp_node = current_comp_node->get_parent()) {
+        Remapping_configuration *current_remapping_configuration = search_remapping_configuration(current_comp_node->get_comp_id());
+        if (current_remapping_configuration != NULL && current_remapping_configuration->get_num_remapping_threads() > 0)
+            return current_remapping_configuration->get_num_remapping_threads();
+    }
+    return 1;
+}
+
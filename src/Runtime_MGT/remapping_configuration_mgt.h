@@ -14,6 +14,7 @@
 #define REMAP_ALGORITHM_TYPE_H2D     1
 #define REMAP_ALGORITHM_TYPE_V1D     2
 #define REMAP_ALGORITHM_TYPE_T1D     3
+#define H2D_REMAPPING_WGT_CACHE_VERSION     1
 
 
 #include <mpi.h>
@@ -24,6 +25,21 @@
 #include "original_grid_mgt.h"
 
 
+class Remap_weight_sparse_matrix;
+
+
+struct H2D_remapping_wgt_cache_header
+{
+    char magic[8];
+    int format_version;
+    int header_size;
+    long key;
+    long src_grid_size;
+    long dst_grid_size;
+    long num_wgts;
+};
+
+
 class H2D_remapping_wgt_file_info
 {
     private:
@@ -43,6 +59,8 @@ class H2D_remapping_wgt_file_info
         long *wgts_dst_indexes;
         double *wgts_values;
         std::vector<std::pair<Original_grid_info*, Original_grid_info*> > matched_grid_pair;
+        bool read_remapping_weights_distributed(int, MPI_Comm);
+        bool load_remapping_wgt_cache_of_local_cells(long, int, int);
 
     public:
         H2D_remapping_wgt_file_info(const char*);
@@ -63,6 +81,8 @@ class H2D_remapping_wgt_file_info
         void read_weight_grid_data(int, const char *, const char *, void **, int, bool);
         double *get_src_area() { return src_area; }
         double *get_dst_area() { return dst_area; }
+        bool read_remapping_wgt_cache(int, long, int, int);
+        static void write_remapping_wgt_cache(const char*, long, int, int, Remap_weight_sparse_matrix*, const bool*);
 };
 
 
@@ -170,6 +190,7 @@ class Remapping_configuration
 {
     private:
         int comp_id;
+        int num_remapping_threads;    // 0 means that it is not specified
         std::vector<Remapping_setting*> remapping_settings;
 
     public:
@@ -177,6 +198,7 @@ class Remapping_configuration
         Remapping_configuration(int, const char*, TiXmlDocument *XML_file);
         ~Remapping_configuration();
         int get_comp_id() { return comp_id; }
+        int get_num_remapping_threads() { return num_remapping_threads; }
         bool get_field_remapping_setting(Remapping_setting&, const char*);
 };
 
@@ -192,6 +214,7 @@ class Remapping_configuration_mgt
         void add_remapping_configuration(int);
         Remapping_configuration *search_remapping_configuration(int);
         void get_field_remapping_setting(Remapping_setting &, int, const char*);
+        int get_num_remapping_threads(int);
 };
 
 
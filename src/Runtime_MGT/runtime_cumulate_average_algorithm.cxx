@@ -16,30 +16,36 @@
 
 
 
-template<typename T> void template_cumulate_or_average(T* dst, const T* src, const int length, 
+/* The accumulation and the scaling of the averaging step are fused into one pass over the field, with the same
+   arithmetic (sum first, then scale) as separate passes */
+template<typename T> void template_cumulate_or_average(void *dst_buf, const void *src_buf, const int length, 
         const int computing_count, const bool do_average)
 {
+    T *dst = (T*) dst_buf;
+    const T *src = (const T*) src_buf;
+
+
     if (computing_count == 1) {
-        for (int i = 0; i < length; i++)
-            dst[i] = src[i];
+        memcpy(dst, src, sizeof(T)*length);
+        return;
     } 
-    else {
+    if (!do_average) {
         for (int i = 0; i < length; i++)
             dst[i] += src[i];
+        return;
     }
-    if (do_average && computing_count != 1) {
-        /// a trick
-        T frac = 1 / ((T)computing_count);
-        if (frac == 0) {
-            /// not a float number
-            for (int i = 0; i < length; i++)
-                dst[i] = dst[i] / computing_count;
-
-        } else {
-            /// float number
-            for (int i = 0; i < length; i++)
-                dst[i] = dst[i] * frac;
-        }
+
+    /// a trick
+    T frac = 1 / ((T)computing_count);
+    if (frac == 0) {
+        /// not a float number
+        T count = (T) computing_count;
+        for (int i = 0; i < length; i++)
+            dst[i] = (dst[i] + src[i]) / count;
+    } else {
+        /// float number
+        for (int i = 0; i < length; i++)
+            dst[i] = (dst[i] + src[i]) * frac;
     }
 }
 
@@ -53,6 +59,13 @@ Runtime_cumulate_average_algorithm::Runtime_cumulate_average_algorithm(Connectio
     cumulate_average_field->timer = NULL;
     cumulate_average_field->num_elements_in_field = field_src->get_size_of_field();
     cumulate_average_field->field_data_type = field_src->get_data_type();
+    if (words_are_the_same(cumulate_average_field->field_data_type, DATA_TYPE_FLOAT))
+        cumulate_average_field->kernel = template_cumulate_or_average<float>;
+    else if (words_are_the_same(cumulate_average_field->field_data_type, DATA_TYPE_DOUBLE))
+        cumulate_average_field->kernel = template_cumulate_or_average<double>;
+    else if (words_are_the_same(cumulate_average_field->field_data_type, DATA_TYPE_INT))
+        cumulate_average_field->kernel = template_cumulate_or_average<int>;
+    else EXECUTION_REPORT(REPORT_ERROR, -1, false, "error data type in cumulate_average algorithm\n"); 
     cumulate_average_field->current_computing_count = 0;
     cumulate_average_fields.push_back(cumulate_average_field);
 
@@ -62,33 +75,25 @@ Runtime_cumulate_average_algorithm::Runtime_cumulate_average_algorithm(Connectio
 
 void Runtime_cumulate_average_algorithm::cumulate_or_average(bool do_average)
 {
+    bool check_field_sums = report_error_enabled || report_internal_log_enabled;
+    std::vector<Field_mem_info*> checked_fields;
+
+
     EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "before cumulate or average");
-    for (int i = 0; i < cumulate_average_fields.size(); i ++) {
-        cumulate_average_fields[i]->mem_info_src->check_field_sum("(src value) before cumulate or average");
-        cumulate_average_fields[i]->mem_info_dst->check_field_sum("(dst value) before cumulate or average");
+    if (check_field_sums && !cumulate_average_fields.empty()) {
+        for (int i = 0; i < cumulate_average_fields.size(); i ++)
+            checked_fields.push_back(cumulate_average_fields[i]->mem_info_src);
+        memory_manager->check_sum_of_fields(&checked_fields[0], checked_fields.size(), "(src value) before cumulate or average");
+        checked_fields.clear();
+        for (int i = 0; i < cumulate_average_fields.size(); i ++)
+            checked_fields.push_back(cumulate_average_fields[i]->mem_info_dst);
+        memory_manager->check_sum_of_fields(&checked_fields[0], checked_fields.size(), "(dst value) before cumulate or average");
     }
     
     for (int i = 0; i < cumulate_average_fields.size(); i ++) {
         cumulate_average_fields[i]->current_computing_count ++;
-        if (words_are_the_same(cumulate_average_fields[i]->field_data_type, DATA_TYPE_FLOAT))
-            template_cumulate_or_average<float>((float *) (cumulate_average_fields[i]->mem_info_dst->get_data_buf()), 
-                                         (float *) (cumulate_average_fields[i]->mem_info_src->get_data_buf()), 
-                                         cumulate_average_fields[i]->num_elements_in_field,
-                                         cumulate_average_fields[i]->current_computing_count,
-                                         do_average);
-        else if (words_are_the_same(cumulate_average_fields[i]->field_data_type, DATA_TYPE_DOUBLE))
-            template_cumulate_or_average<double>((double *) (cumulate_average_fields[i]->mem_info_dst->get_data_buf()), 
-                                         (double *) (cumulate_average_fields[i]->mem_info_src->get_data_buf()), 
-                                         cumulate_average_fields[i]->num_elements_in_field,
-                                         cumulate_average_fields[i]->current_computing_count,
-                                         do_average);
-        else if (words_are_the_same(cumulate_average_fields[i]->field_data_type, DATA_TYPE_INT))
-            template_cumulate_or_average<int>((int *) (cumulate_average_fields[i]->mem_info_dst->get_data_buf()), 
-                                         (int *) (cumulate_average_fields[i]->mem_info_src->get_data_buf()), 
-                                         cumulate_average_fields[i]->num_elements_in_field,
-                                         cumulate_average_fields[i]->current_computing_count,
-                                         do_average);
-        else EXECUTION_REPORT(REPORT_ERROR, -1, false, "error data type in cumulate_average algorithm\n"); 
+        cumulate_average_fields[i]->kernel(cumulate_average_fields[i]->mem_info_dst->get_data_buf(), cumulate_average_fields[i]->mem_info_src->get_data_buf(), 
+                                           cumulate_average_fields[i]->num_elements_in_field, cumulate_average_fields[i]->current_computing_count, do_average);
         if (do_average) {
             EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "do average at computing count is %d", cumulate_average_fields[i]->current_computing_count);
             cumulate_average_fields[i]->current_computing_count = 0;            
@@ -98,8 +103,11 @@ void Runtime_cumulate_average_algorithm::cumulate_or_average(bool do_average)
     }
 
     EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "after cumulate or average");
-    for (int i = 0; i < cumulate_average_fields.size(); i ++) {
-        cumulate_average_fields[i]->mem_info_dst->check_field_sum("(dst value) after cumulate or average");
+    if (check_field_sums && !cumulate_average_fields.empty()) {
+        checked_fields.clear();
+        for (int i = 0; i < cumulate_average_fields.size(); i ++)
+            checked_fields.push_back(cumulate_average_fields[i]->mem_info_dst);
+        memory_manager->check_sum_of_fields(&checked_fields[0], checked_fields.size(), "(dst value) after cumulate or average");
     }
 }
 
@@ -20,10 +20,14 @@
 class Connection_coupling_procedure;
 
 
+typedef void (*Cumulate_average_kernel)(void*, const void*, const int, const int, const bool);
+
+
 struct cumulate_average_field_info
 {
     int num_elements_in_field;
     const char *field_data_type;
+    Cumulate_average_kernel kernel;
     Field_mem_info *mem_info_src;
     Field_mem_info *mem_info_dst;
     Coupling_timer *timer;
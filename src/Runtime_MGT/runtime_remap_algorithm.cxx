@@ -21,6 +21,9 @@ Runtime_remap_algorithm::Runtime_remap_algorithm(Runtime_remapping_weights *runt
     specified_src_field_instance = src_field_instance;
     specified_dst_field_instance = dst_field_instance;
     this->runtime_remapping_weights = runtime_remapping_weights;
+    num_remapping_threads = remapping_configuration_mgr->get_num_remapping_threads(comp_id);
+    performance_timing_mgr = comp_comm_group_mgt_mgr->get_global_node_of_local_comp(runtime_remapping_weights->get_dst_original_grid()->get_comp_id(),false,"")->get_performance_timing_mgr();
+    remap_calculation_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMPUTATION, -1, -1, "remapping cal");
     
     if (words_are_the_same(src_field_instance->get_field_data()->get_grid_data_field()->data_type_in_application, DATA_TYPE_FLOAT)) {
         true_src_field_instance = memory_manager->alloc_mem(specified_src_field_instance, BUF_MARK_REMAP_DATATYPE_TRANS_SRC, connection_id, DATA_TYPE_DOUBLE, false);
@@ -63,9 +66,9 @@ void Runtime_remap_algorithm::do_remap(bool is_algorithm_in_kernel_stage)
             ((double*)true_src_field_instance->get_data_buf())[i] = ((float*)specified_src_field_instance->get_data_buf())[i];
 	if (!words_are_the_same(specified_src_field_instance->get_field_name(),V3D_GRID_3D_LEVEL_FIELD_NAME))
 	    runtime_remapping_weights->renew_dynamic_V1D_remapping_weights();
-    comp_comm_group_mgt_mgr->get_global_node_of_local_comp(runtime_remapping_weights->get_dst_original_grid()->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "remapping cal");
-    runtime_remapping_weights->get_parallel_remapping_weights()->do_remap(runtime_remapping_weights->get_dst_original_grid()->get_comp_id(), true_src_field_instance->get_field_data(), true_dst_field_instance->get_field_data());
-    comp_comm_group_mgt_mgr->get_global_node_of_local_comp(runtime_remapping_weights->get_dst_original_grid()->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "remapping cal");
+    performance_timing_mgr->performance_timing_start(remap_calculation_timing_unit);
+    runtime_remapping_weights->get_parallel_remapping_weights()->do_remap(performance_timing_mgr, true_src_field_instance->get_field_data(), true_dst_field_instance->get_field_data(), num_remapping_threads);
+    performance_timing_mgr->performance_timing_stop(remap_calculation_timing_unit);
     if (transform_data_type)
         for (int i = 0; i < specified_dst_field_instance->get_size_of_field(); i ++)
             ((float*)specified_dst_field_instance->get_data_buf())[i] = ((double*)true_dst_field_instance->get_data_buf())[i];
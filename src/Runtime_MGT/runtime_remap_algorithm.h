@@ -31,6 +31,9 @@ class Runtime_remap_algorithm
         Field_mem_info *true_dst_field_instance;
         Runtime_remapping_weights *runtime_remapping_weights;
         bool transform_data_type;
+        int num_remapping_threads;
+        Performance_timing_mgt *performance_timing_mgr;
+        int remap_calculation_timing_unit;
         
         void do_remap(bool);
 
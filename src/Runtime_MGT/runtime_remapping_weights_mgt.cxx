@@ -46,9 +46,11 @@ Runtime_remapping_weights::Runtime_remapping_weights(const char *src_comp_full_n
     Remap_operator_basis *remap_operators[3];
     Remap_grid_class *remap_grids[2];
     Remapping_setting *cloned_remapping_setting = remapping_setting->clone();
-    char parameter_name[NAME_STR_SIZE], parameter_value[NAME_STR_SIZE], remap_weight_name[NAME_STR_SIZE];
-    int num_remap_operators = 0;
-    H2D_remapping_wgt_file_info *H2D_remapping_weight_file = NULL;
+    char parameter_name[NAME_STR_SIZE], parameter_value[NAME_STR_SIZE], remap_weight_name[NAME_STR_SIZE], wgt_cache_file_name[NAME_STR_SIZE*2];
+    int num_remap_operators = 0, wgt_cal_comp_id = comp_comm_group_mgt_mgr->search_global_node(dst_comp_full_name)->get_comp_id();
+    H2D_remapping_wgt_file_info *H2D_remapping_weight_file = NULL, *H2D_remapping_wgt_cache = NULL;
+    bool *wgt_cache_covered_cells = NULL, wgt_cache_hit = false;
+    long wgt_cache_key = 0;
 
 
     this->src_comp_full_name = strdup(src_comp_full_name);
@@ -123,26 +125,50 @@ Runtime_remapping_weights::Runtime_remapping_weights(const char *src_comp_full_n
     sprintf(remap_weight_name, "weights_%lx_%s(%s)_to_%s(%s)", remapping_setting->calculate_checksum(), src_original_grid->get_grid_name(), src_comp_full_name, dst_original_grid->get_grid_name(), dst_comp_full_name);
     if (H2D_remapping_weight_file != NULL) {
         EXECUTION_REPORT(REPORT_PROGRESS, dst_decomp_info->get_host_comp_id(), true, "The remapping weight file \"%s\" will be used for data remapping from the horizontal grid \"%s\" (of the component model \"%s\") to the horizontal grid \"%s\" (of the component model \"%s\").", H2D_remapping_weight_file->get_wgt_file_name(), src_original_grid->get_grid_name(), src_comp_full_name, dst_original_grid->get_grid_name(), dst_comp_full_name);
+        if (dst_original_grid->get_H2D_sub_CoR_grid() != NULL && dst_decomp_info != NULL)
+            generate_H2D_grid_decomp_mask();
         sequential_remapping_weights = new Remap_weight_of_strategy_class(remap_weight_name, remapping_strategy, src_original_grid->get_original_CoR_grid(), dst_original_grid->get_original_CoR_grid(), H2D_remapping_weight_file->get_wgt_file_name(), true, comp_comm_group_mgt_mgr->search_global_node(dst_comp_full_name)->get_comp_id());
+        if (H2D_grid_decomp_mask != NULL) {
+            delete [] H2D_grid_decomp_mask;
+            H2D_grid_decomp_mask = NULL;
+        }
         if (src_original_grid->is_H2D_grid()) 
             set_H2D_grids_area(H2D_remapping_weight_file->get_src_area(), H2D_remapping_weight_file->get_dst_area(), src_original_grid->get_original_CoR_grid()->get_grid_size(), dst_original_grid->get_original_CoR_grid()->get_grid_size());
         H2D_remapping_weight_file->clean();
     }    
     else {    
-        EXECUTION_REPORT(REPORT_PROGRESS, dst_decomp_info->get_host_comp_id(), true, "No remapping weight file has been specified for data remapping from the horizontal sub grid of \"%s\" (of the component model \"%s\") to the horizontal sub grid of \"%s\" (of the component model \"%s\"). So the remapping weights will be generated by C-Coupler", src_original_grid->get_grid_name(), src_comp_full_name, dst_original_grid->get_grid_name(), dst_comp_full_name);
-        EXECUTION_REPORT(REPORT_ERROR, -1, H2D_grid_decomp_mask == NULL, "Software error in Runtime_remapping_weights::Runtime_remapping_weights");
-        H2D_grid_decomp_mask = new bool [dst_decomp_info->get_num_global_cells()];
-        for (int i = 0; i < dst_decomp_info->get_num_global_cells(); i ++)
-            H2D_grid_decomp_mask[i] = false;
-        for (int i = 0; i < dst_decomp_info->get_num_local_cells(); i ++)
-        	if (dst_decomp_info->get_local_cell_global_indx()[i] != CCPL_NULL_INT)
-                H2D_grid_decomp_mask[dst_decomp_info->get_local_cell_global_indx()[i]] = true;
-        sequential_remapping_weights = new Remap_weight_of_strategy_class(remap_weight_name, remapping_strategy, src_original_grid->get_original_CoR_grid(), dst_original_grid->get_original_CoR_grid(), NULL, true, comp_comm_group_mgt_mgr->search_global_node(dst_comp_full_name)->get_comp_id());
+        generate_H2D_grid_decomp_mask();
+        if (src_original_grid->get_H2D_sub_CoR_grid() != NULL && src_original_grid->get_H2D_sub_CoR_grid()->get_is_sphere_grid() && (src_original_grid->get_original_CoR_grid() == src_original_grid->get_H2D_sub_CoR_grid() || 
+            (src_original_grid->get_original_CoR_grid()->get_grid_mask_field() == NULL && dst_original_grid->get_original_CoR_grid()->get_grid_mask_field() == NULL))) {
+            wgt_cache_key = calculate_H2D_remapping_wgt_cache_key();
+            sprintf(wgt_cache_file_name, "%s/H2D_WGT_CACHE_%016lx.bin", comp_comm_group_mgt_mgr->get_internal_remapping_weights_dir(), wgt_cache_key);
+            H2D_remapping_wgt_cache = all_H2D_remapping_wgt_files_info->search_wgt_file_info(wgt_cache_file_name);
+            if (H2D_remapping_wgt_cache == NULL) {
+                H2D_remapping_wgt_cache = new H2D_remapping_wgt_file_info(wgt_cache_file_name);
+                all_H2D_remapping_wgt_files_info->add_wgt_file_info(H2D_remapping_wgt_cache);
+            }
+        }
+        if (H2D_remapping_wgt_cache != NULL)
+            wgt_cache_hit = H2D_remapping_wgt_cache->read_remapping_wgt_cache(wgt_cal_comp_id, wgt_cache_key, src_original_grid->get_H2D_sub_CoR_grid()->get_grid_size(), dst_original_grid->get_H2D_sub_CoR_grid()->get_grid_size());
+        if (wgt_cache_hit) {
+            EXECUTION_REPORT(REPORT_PROGRESS, dst_decomp_info->get_host_comp_id(), true, "No remapping weight file has been specified for data remapping from the horizontal sub grid of \"%s\" (of the component model \"%s\") to the horizontal sub grid of \"%s\" (of the component model \"%s\"). The remapping weights generated before will be loaded from the remapping weight cache \"%s\"", src_original_grid->get_grid_name(), src_comp_full_name, dst_original_grid->get_grid_name(), dst_comp_full_name, wgt_cache_file_name);
+            sequential_remapping_weights = new Remap_weight_of_strategy_class(remap_weight_name, remapping_strategy, src_original_grid->get_original_CoR_grid(), dst_original_grid->get_original_CoR_grid(), wgt_cache_file_name, true, wgt_cal_comp_id);
+            H2D_remapping_wgt_cache->clean();
+        }
+        else {
+            EXECUTION_REPORT(REPORT_PROGRESS, dst_decomp_info->get_host_comp_id(), true, "No remapping weight file has been specified for data remapping from the horizontal sub grid of \"%s\" (of the component model \"%s\") to the horizontal sub grid of \"%s\" (of the component model \"%s\"). So the remapping weights will be generated by C-Coupler", src_original_grid->get_grid_name(), src_comp_full_name, dst_original_grid->get_grid_name(), dst_comp_full_name);
+            sequential_remapping_weights = new Remap_weight_of_strategy_class(remap_weight_name, remapping_strategy, src_original_grid->get_original_CoR_grid(), dst_original_grid->get_original_CoR_grid(), NULL, true, wgt_cal_comp_id);
+            if (H2D_remapping_wgt_cache != NULL)
+                wgt_cache_covered_cells = generate_H2D_remapping_wgt_cache_covered_cells();
+        }
         delete [] H2D_grid_decomp_mask;
         H2D_grid_decomp_mask = NULL;
         if (src_original_grid->is_H2D_grid() && src_original_grid->get_original_CoR_grid()->get_area_or_volumn() != NULL)
             set_H2D_grids_area(src_original_grid->get_original_CoR_grid()->get_area_or_volumn(), src_original_grid->get_original_CoR_grid()->get_area_or_volumn(), src_original_grid->get_original_CoR_grid()->get_grid_size(), dst_original_grid->get_original_CoR_grid()->get_grid_size());
-		sequential_remapping_weights->write_overall_H2D_remapping_weights(comp_comm_group_mgt_mgr->search_global_node(dst_comp_full_name)->get_comp_id());
+        if (!wgt_cache_hit)
+            sequential_remapping_weights->write_overall_H2D_remapping_weights(wgt_cal_comp_id, H2D_remapping_wgt_cache != NULL? wgt_cache_file_name : NULL, wgt_cache_key, wgt_cache_covered_cells);
+        if (wgt_cache_covered_cells != NULL)
+            delete [] wgt_cache_covered_cells;
     }    
     EXECUTION_REPORT_LOG(REPORT_LOG, dst_decomp_info->get_host_comp_id(), true, "after generating sequential_remapping_weights from original grid %s to %s", src_original_grid->get_grid_name(), dst_original_grid->get_grid_name());    
     execution_phase_number = 2;
@@ -159,6 +185,92 @@ Runtime_remapping_weights::Runtime_remapping_weights(const char *src_comp_full_n
 }
 
 
+/* Marks the target cells of the local decomposition, so that the H2D remapping weights are only generated (or loaded from
+   the remapping weight file) for them */
+void Runtime_remapping_weights::generate_H2D_grid_decomp_mask()
+{
+    EXECUTION_REPORT(REPORT_ERROR, -1, H2D_grid_decomp_mask == NULL, "Software error in Runtime_remapping_weights::generate_H2D_grid_decomp_mask");
+    H2D_grid_decomp_mask = new bool [dst_decomp_info->get_num_global_cells()];
+    for (int i = 0; i < dst_decomp_info->get_num_global_cells(); i ++)
+        H2D_grid_decomp_mask[i] = false;
+    for (int i = 0; i < dst_decomp_info->get_num_local_cells(); i ++)
+        if (dst_decomp_info->get_local_cell_global_indx()[i] != CCPL_NULL_INT)
+            H2D_grid_decomp_mask[dst_decomp_info->get_local_cell_global_indx()[i]] = true;
+}
+
+
+/* The key of the remapping weight cache covers everything the H2D remapping weights depend on: the remapping setting (with 
+   the parameters of the algorithms), the coordinate values and masks of both H2D grids, and the format of the cache */
+long Runtime_remapping_weights::calculate_H2D_remapping_wgt_cache_key()
+{
+    char *temp_array = NULL;
+    long buffer_max_size, buffer_content_size, checksum;
+    int cache_version = H2D_REMAPPING_WGT_CACHE_VERSION;
+
+
+    write_data_into_array_buffer(&cache_version, sizeof(int), &temp_array, buffer_max_size, buffer_content_size);
+    checksum = remapping_setting->calculate_checksum();
+    write_data_into_array_buffer(&checksum, sizeof(long), &temp_array, buffer_max_size, buffer_content_size);
+    write_H2D_grid_checksums_into_array(src_original_grid, &temp_array, buffer_max_size, buffer_content_size);
+    write_H2D_grid_checksums_into_array(dst_original_grid, &temp_array, buffer_max_size, buffer_content_size);
+    checksum = calculate_checksum_of_array(temp_array, buffer_content_size, 1, NULL, NULL);
+    delete [] temp_array;
+
+    return checksum;
+}
+
+
+void Runtime_remapping_weights::write_H2D_grid_checksums_into_array(Original_grid_info *original_grid, char **array, long &buffer_max_size, long &buffer_content_size)
+{
+    Remap_grid_class *H2D_grid = original_grid->get_H2D_sub_CoR_grid(), *leaf_grids[256];
+    Remap_grid_data_class *grid_fields[3];
+    long grid_size = H2D_grid->get_grid_size(), checksum = original_grid->get_checksum_H2D_mask();
+    int num_leaf_grids;
+
+
+    write_data_into_array_buffer(&grid_size, sizeof(long), array, buffer_max_size, buffer_content_size);
+    write_data_into_array_buffer(&checksum, sizeof(long), array, buffer_max_size, buffer_content_size);
+    H2D_grid->get_leaf_grids(&num_leaf_grids, leaf_grids, H2D_grid);
+    for (int i = 0; i < num_leaf_grids+1; i ++) {
+        if (i < num_leaf_grids) {
+            grid_fields[0] = leaf_grids[i]->get_grid_center_field();
+            grid_fields[1] = leaf_grids[i]->get_grid_vertex_field();
+        }
+        else {
+            grid_fields[0] = H2D_grid->get_grid_mask_field();
+            grid_fields[1] = NULL;
+        }
+        for (int j = 0; j < 2; j ++) {
+            if (grid_fields[j] == NULL)
+                checksum = 0;
+            else checksum = calculate_checksum_of_array((const char*) grid_fields[j]->get_grid_data_field()->data_buf, grid_fields[j]->get_grid_data_field()->required_data_size, get_data_type_size(grid_fields[j]->get_grid_data_field()->data_type_in_application), NULL, NULL);
+            write_data_into_array_buffer(&checksum, sizeof(long), array, buffer_max_size, buffer_content_size);
+        }
+    }
+}
+
+
+/* Marks (on the root of the target component) the target cells whose remapping weights have been generated by any process,
+   so that a later run with another parallel decomposition does not use the cache for the other cells */
+bool *Runtime_remapping_weights::generate_H2D_remapping_wgt_cache_covered_cells()
+{
+    int num_global_cells = dst_decomp_info->get_num_global_cells(), *local_cells_mark = new int [num_global_cells], *covered_cells_mark = new int [num_global_cells];
+    bool *covered_cells = new bool [num_global_cells];
+    Comp_comm_group_mgt_node *comp_node = comp_comm_group_mgt_mgr->search_global_node(dst_comp_full_name);
+
+
+    for (int i = 0; i < num_global_cells; i ++)
+        local_cells_mark[i] = H2D_grid_decomp_mask[i]? 1 : 0;
+    MPI_Reduce(local_cells_mark, covered_cells_mark, num_global_cells, MPI_INT, MPI_MAX, 0, comp_node->get_comm_group());
+    for (int i = 0; i < num_global_cells; i ++)
+        covered_cells[i] = comp_node->get_current_proc_local_id() == 0 && covered_cells_mark[i] == 1;
+    delete [] local_cells_mark;
+    delete [] covered_cells_mark;
+
+    return covered_cells;
+}
+
+
 Runtime_remapping_weights::~Runtime_remapping_weights()
 {
     if (src_comp_full_name != NULL)
@@ -328,7 +440,8 @@ void Runtime_remapping_weights::renew_dynamic_V1D_remapping_weights()
             EXECUTION_REPORT(REPORT_ERROR, dst_original_grid->get_comp_id(), !dst_bottom_value_updated || !dst_bottom_value_specified, "the 3-D level field of the 3-D grid \"%s\" (registered in the component \"%s\") is updated while the 3-D level field has been specified as a static one. Please verify", dst_original_grid->get_grid_name(), dst_original_grid->get_comp_full_name());
     }
 
-	comp_comm_group_mgt_mgr->get_global_node_of_local_comp(dst_original_grid->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "vertical coord update");
+	Performance_timing_mgt *performance_timing_mgr = comp_comm_group_mgt_mgr->get_global_node_of_local_comp(dst_original_grid->get_comp_id(),false,"")->get_performance_timing_mgr();
+	performance_timing_mgr->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "vertical coord update");
     if (src_bottom_value_updated)
 		if (dynamic_V1D_remap_weight_of_operator->get_field_data_grid_src()->is_sigma_grid())
 	        dynamic_V1D_remap_weight_of_operator->get_field_data_grid_src()->calculate_lev_sigma_values();
@@ -337,12 +450,12 @@ void Runtime_remapping_weights::renew_dynamic_V1D_remapping_weights()
 		if (dynamic_V1D_remap_weight_of_operator->get_field_data_grid_dst()->is_sigma_grid())
 	        dynamic_V1D_remap_weight_of_operator->get_field_data_grid_dst()->calculate_lev_sigma_values();
 		else dynamic_V1D_remap_weight_of_operator->get_field_data_grid_dst()->update_grid_center_3D_level_field_from_external();
-	comp_comm_group_mgt_mgr->get_global_node_of_local_comp(dst_original_grid->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "vertical coord update");
+	performance_timing_mgr->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "vertical coord update");
 
-	comp_comm_group_mgt_mgr->get_global_node_of_local_comp(dst_original_grid->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "dyn v1d wgt");
+	performance_timing_mgr->performance_timing_start(TIMING_TYPE_COMPUTATION, -1, -1, "dyn v1d wgt");
     if (src_bottom_value_updated || dst_bottom_value_updated)
         dynamic_V1D_remap_weight_of_operator->renew_vertical_remap_weights(runtime_V1D_remap_grid_src, runtime_V1D_remap_grid_dst);
-	comp_comm_group_mgt_mgr->get_global_node_of_local_comp(dst_original_grid->get_comp_id(),false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "dyn v1d wgt");
+	performance_timing_mgr->performance_timing_stop(TIMING_TYPE_COMPUTATION, -1, -1, "dyn v1d wgt");
 }
 
 
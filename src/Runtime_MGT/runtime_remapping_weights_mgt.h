@@ -45,6 +45,10 @@ class Runtime_remapping_weights
         int size_dst_H2D_grid_area;
 
         void generate_parallel_remapping_weights();
+        void generate_H2D_grid_decomp_mask();
+        long calculate_H2D_remapping_wgt_cache_key();
+        void write_H2D_grid_checksums_into_array(Original_grid_info*, char**, long&, long&);
+        bool *generate_H2D_remapping_wgt_cache_covered_cells();
         
     public:
         Runtime_remapping_weights(const char*, const char*, Original_grid_info *, Original_grid_info *, Remapping_setting *, Decomp_info*);
@@ -16,36 +16,134 @@
 #include <unistd.h>
 
 
-template <class T> void Runtime_trans_algorithm::pack_segment_data(T *mpi_buf, T *field_data_buf, int segment_start, int segment_size, int field_2D_size, int num_lev, bool is_V1D_sub_grid_after_H2D_sub_grid)
+/* The MPI buffer always keeps the levels of a horizontal point together. When the levels of a point are also contiguous 
+   in the field (or there is only one level), the local index segments are merged into long byte runs copied with memcpy; 
+   otherwise (or when the runs are too short to amortize memcpy) the plan is a flat list of element indexes. */
+Runtime_trans_pack_plan::Runtime_trans_pack_plan(Routing_info *router, bool send_or_receive, int remote_proc_index, int data_type_size, int num_lev, bool is_V1D_sub_grid_after_H2D_sub_grid)
 {
-    int i, j, offset;
+    int num_segments = router->get_num_local_indx_segments_with_remote_proc(send_or_receive, remote_proc_index);
+    int *segment_starts = router->get_local_indx_segment_starts_with_remote_proc(send_or_receive, remote_proc_index);
+    int *num_elements_in_segments = router->get_local_indx_segment_lengths_with_remote_proc(send_or_receive, remote_proc_index);
+    int field_2D_size = send_or_receive? router->get_src_decomp_size() : router->get_dst_decomp_size();
+
+
+    this->data_type_size = data_type_size;
+    packed_size = 0;
+    for (int i = 0; i < num_segments; i ++)
+        packed_size += ((long)num_elements_in_segments[i]) * num_lev * data_type_size;
+
+    if (is_V1D_sub_grid_after_H2D_sub_grid && num_lev > 1) {
+        use_memcpy_runs = false;
+        gather_indexes.reserve(packed_size/data_type_size);
+        for (int i = 0; i < num_segments; i ++)
+            for (int k = segment_starts[i]; k < segment_starts[i]+num_elements_in_segments[i]; k ++)
+                for (int j = 0; j < num_lev; j ++)
+                    gather_indexes.push_back(k+j*field_2D_size);
+        return;
+    }
 
-    if (is_V1D_sub_grid_after_H2D_sub_grid) {
-        for (i = segment_start, offset = 0; i < segment_size+segment_start; i ++)
-            for (j = 0; j < num_lev; j ++)
-                mpi_buf[offset++] = field_data_buf[i+j*field_2D_size];
+    for (int i = 0; i < num_segments; i ++) {
+        long run_offset = ((long)segment_starts[i]) * num_lev * data_type_size;
+        long run_length = ((long)num_elements_in_segments[i]) * num_lev * data_type_size;
+        if (run_length == 0)
+            continue;
+        if (runs_field_offsets.size() > 0 && runs_field_offsets.back()+runs_lengths.back() == run_offset)
+            runs_lengths.back() += run_length;
+        else {
+            runs_field_offsets.push_back(run_offset);
+            runs_lengths.push_back(run_length);
+        }
     }
-    else {
-        for (i = segment_start, offset = 0; i < segment_size+segment_start; i ++)
-            for (j = 0; j < num_lev; j ++)
-                mpi_buf[offset++] = field_data_buf[i*num_lev+j];        
+    use_memcpy_runs = runs_lengths.size() == 0 || packed_size / runs_lengths.size() >= MIN_BYTES_OF_PACK_PLAN_MEMCPY_RUN;
+    if (!use_memcpy_runs) {
+        gather_indexes.reserve(packed_size/data_type_size);
+        for (int i = 0; i < runs_lengths.size(); i ++)
+            for (long k = runs_field_offsets[i]/data_type_size; k < (runs_field_offsets[i]+runs_lengths[i])/data_type_size; k ++)
+                gather_indexes.push_back(k);
+        runs_field_offsets.clear();
+        runs_lengths.clear();
     }
 }
 
 
-template <class T> void Runtime_trans_algorithm::unpack_segment_data(T *mpi_buf, T *field_data_buf, int segment_start, int segment_size, int field_2D_size, int num_lev, bool is_V1D_sub_grid_after_H2D_sub_grid)
+template <class T> void Runtime_trans_pack_plan::gather_elements(T *mpi_buf, const T *field_data_buf)
+{
+    const int *indexes = &gather_indexes[0];
+    long num_elements = gather_indexes.size();
+
+    for (long i = 0; i < num_elements; i ++)
+        mpi_buf[i] = field_data_buf[indexes[i]];
+}
+
+
+template <class T> void Runtime_trans_pack_plan::scatter_elements(const T *mpi_buf, T *field_data_buf)
+{
+    const int *indexes = &gather_indexes[0];
+    long num_elements = gather_indexes.size();
+
+    for (long i = 0; i < num_elements; i ++)
+        field_data_buf[indexes[i]] = mpi_buf[i];
+}
+
+
+void Runtime_trans_pack_plan::pack(char *mpi_buf, const char *field_data_buf)
 {
-    int i, j, offset;
+    if (use_memcpy_runs) {
+        long offset = 0;
+        for (int i = 0; i < runs_lengths.size(); offset += runs_lengths[i ++])
+            memcpy(mpi_buf+offset, field_data_buf+runs_field_offsets[i], runs_lengths[i]);
+        return;
+    }
 
-    if (is_V1D_sub_grid_after_H2D_sub_grid) {
-        for (i = segment_start, offset = 0; i < segment_size+segment_start; i ++)
-            for (j = 0; j < num_lev; j ++)
-                field_data_buf[i+j*field_2D_size] = mpi_buf[offset++];
+    if (gather_indexes.size() == 0)
+        return;
+    switch (data_type_size) {
+        case 1:
+            gather_elements((char*)mpi_buf, (const char*)field_data_buf);
+            break;
+        case 2:
+            gather_elements((short*)mpi_buf, (const short*)field_data_buf);
+            break;
+        case 4:
+            gather_elements((int*)mpi_buf, (const int*)field_data_buf);
+            break;
+        case 8:
+            gather_elements((double*)mpi_buf, (const double*)field_data_buf);
+            break;
+        default:
+            EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR,-1, false, "Software error in Runtime_trans_pack_plan::pack: unsupported data type in runtime transfer algorithm. Please verify.");
+            break;
     }
-    else {
-        for (i = segment_start, offset = 0; i < segment_size+segment_start; i ++)
-            for (j = 0; j < num_lev; j ++)
-                field_data_buf[i*num_lev+j] = mpi_buf[offset++];        
+}
+
+
+void Runtime_trans_pack_plan::unpack(const char *mpi_buf, char *field_data_buf)
+{
+    if (use_memcpy_runs) {
+        long offset = 0;
+        for (int i = 0; i < runs_lengths.size(); offset += runs_lengths[i ++])
+            memcpy(field_data_buf+runs_field_offsets[i], mpi_buf+offset, runs_lengths[i]);
+        return;
+    }
+
+    if (gather_indexes.size() == 0)
+        return;
+    switch (data_type_size) {
+        case 1:
+            scatter_elements((const char*)mpi_buf, (char*)field_data_buf);
+            break;
+        case 2:
+            scatter_elements((const short*)mpi_buf, (short*)field_data_buf);
+            break;
+        case 4:
+            scatter_elements((const int*)mpi_buf, (int*)field_data_buf);
+            break;
+        case 8:
+            scatter_elements((const double*)mpi_buf, (double*)field_data_buf);
+            break;
+        default:
+            EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR,-1, false, "Software error in Runtime_trans_pack_plan::unpack: unsupported data type in runtime transfer algorithm. Please verify.");
+            break;
     }
 }
 
@@ -86,6 +184,15 @@ Runtime_trans_algorithm::Runtime_trans_algorithm(bool send_or_receive, int num_t
         remote_comp_node = fields_routers[0]->get_src_comp_node();
     }
     strcpy(remote_comp_full_name, remote_comp_node->get_comp_full_name());
+    performance_timing_mgr = local_comp_node->get_performance_timing_mgr();
+    send_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_SEND, -1, remote_comp_full_name);
+    send_wait_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_SEND_WAIT, -1, remote_comp_full_name);
+    send_query_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_SEND_QUERRY, -1, remote_comp_full_name);
+    recv_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV, -1, remote_comp_full_name);
+    recv_wait_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV_WAIT, -1, remote_comp_full_name);
+    recv_query_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV_QUERRY, -1, remote_comp_full_name);
+    recv_remote_wait_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV_REMOTE_WAIT, -1, remote_comp_full_name);
+    recv_transfer_timing_unit = performance_timing_mgr->register_timing_unit(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV_TRANSFER, -1, remote_comp_full_name);
     remote_comp_node_updated = false;
     timer_not_bypassed = false;
     comp_id = local_comp_node->get_comp_id();
@@ -100,10 +207,9 @@ Runtime_trans_algorithm::Runtime_trans_algorithm(bool send_or_receive, int num_t
     memcpy(remote_proc_ranks_in_union_comm, ranks, num_remote_procs*sizeof(int));
     sender_time_has_matched = false;
 
-#ifndef USE_ONE_SIDED_MPI
-    request = new MPI_Request[num_remote_procs];
-    is_first_run = true;
-#endif
+    persistent_requests = NULL;
+    num_persistent_requests = 0;
+    persistent_requests_active = false;
     transfer_size_with_remote_procs = new int [num_remote_procs];
     send_displs_in_remote_procs = new int [num_remote_procs];
     recv_displs_in_current_proc = new int [num_remote_procs];
@@ -221,11 +327,54 @@ Runtime_trans_algorithm::Runtime_trans_algorithm(bool send_or_receive, int num_t
     }
 
     delete [] total_transfer_size_with_remote_procs;
+
+    build_pack_plan_groups();
+}
+
+
+/* Fields sharing the same router, data type size and vertical layout share the same pack plans */
+void Runtime_trans_algorithm::build_pack_plan_groups()
+{
+    fields_pack_plan_groups = new int [num_transfered_fields];
+    for (int i = 0; i < num_transfered_fields; i ++) {
+        fields_pack_plan_groups[i] = -1;
+        if (fields_routers[i]->get_num_dimensions() == 0)
+            continue;
+        for (int j = 0; j < i; j ++)
+            if (fields_pack_plan_groups[j] != -1 && fields_routers[j] == fields_routers[i] && fields_data_type_sizes[j] == fields_data_type_sizes[i] && 
+                field_grids_num_lev[j] == field_grids_num_lev[i] && is_V1D_sub_grid_after_H2D_sub_grid[j] == is_V1D_sub_grid_after_H2D_sub_grid[i]) {
+                fields_pack_plan_groups[i] = fields_pack_plan_groups[j];
+                break;
+            }
+        if (fields_pack_plan_groups[i] == -1) {
+            fields_pack_plan_groups[i] = pack_plan_groups.size();
+            pack_plan_groups.push_back(std::vector<Runtime_trans_pack_plan*>(num_remote_procs, (Runtime_trans_pack_plan*)NULL));
+        }
+    }
+}
+
+
+Runtime_trans_pack_plan *Runtime_trans_algorithm::get_pack_plan(int field_index, int remote_proc_index)
+{
+    std::vector<Runtime_trans_pack_plan*> &group = pack_plan_groups[fields_pack_plan_groups[field_index]];
+
+
+    if (group[remote_proc_index] == NULL)
+        group[remote_proc_index] = new Runtime_trans_pack_plan(fields_routers[field_index], send_or_receive, remote_proc_index, fields_data_type_sizes[field_index], field_grids_num_lev[field_index], is_V1D_sub_grid_after_H2D_sub_grid[field_index]);
+
+    return group[remote_proc_index];
 }
 
 
 Runtime_trans_algorithm::~Runtime_trans_algorithm()
 {
+    if (persistent_requests != NULL) {
+        if (persistent_requests_active)
+            MPI_Waitall(num_persistent_requests, persistent_requests, MPI_STATUSES_IGNORE);
+        for (int i = 0; i < num_persistent_requests; i ++)
+            MPI_Request_free(&persistent_requests[i]);
+        delete [] persistent_requests;
+    }
     delete [] fields_mem;
     delete [] fields_data_buffers;
     delete [] fields_routers;
@@ -238,9 +387,46 @@ Runtime_trans_algorithm::~Runtime_trans_algorithm()
     delete [] recv_displs_in_current_proc;
     delete [] remote_proc_ranks_in_union_comm;
     delete [] temp_receive_data_buffer;
-#ifndef USE_ONE_SIDED_MPI
-    delete [] request;
-#endif
+    delete [] fields_pack_plan_groups;
+    for (int i = 0; i < pack_plan_groups.size(); i ++)
+        for (int j = 0; j < pack_plan_groups[i].size(); j ++)
+            if (pack_plan_groups[i][j] != NULL)
+                delete pack_plan_groups[i][j];
+}
+
+
+/* The routing info and the buffer layout do not change after the construction, so the send/receive channel with each 
+   remote process is created only once as a persistent MPI request and is restarted at each transfer. */
+void Runtime_trans_algorithm::build_persistent_requests()
+{
+    if (persistent_requests != NULL)
+        return;
+
+    persistent_requests = new MPI_Request[index_remote_procs_with_common_data.size()+1];
+    num_persistent_requests = 0;
+    for (int i = 0; i < index_remote_procs_with_common_data.size(); i ++) {
+        int remote_proc_index = index_remote_procs_with_common_data[i];
+        if (!send_or_receive && transfer_size_with_remote_procs[remote_proc_index] == 0) 
+            continue;
+        char *channel_buf = total_buf + recv_displs_in_current_proc[remote_proc_index];
+        int remote_proc_id = remote_proc_ranks_in_union_comm[remote_proc_index];
+        if (send_or_receive)
+            MPI_Send_init(channel_buf, 4*sizeof(long)+transfer_size_with_remote_procs[remote_proc_index], MPI_CHAR, remote_proc_id, comm_tag, union_comm, &persistent_requests[num_persistent_requests++]);
+        else MPI_Recv_init(channel_buf, 4*sizeof(long)+transfer_size_with_remote_procs[remote_proc_index], MPI_CHAR, remote_proc_id, comm_tag, union_comm, &persistent_requests[num_persistent_requests++]);
+    }
+    EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "Build %d persistent MPI requests for transferring data with component \"%s\"", num_persistent_requests, remote_comp_full_name);
+}
+
+
+void Runtime_trans_algorithm::complete_send()
+{
+    if (!persistent_requests_active)
+        return;
+
+    performance_timing_mgr->performance_timing_start(send_wait_timing_unit);
+    MPI_Waitall(num_persistent_requests, persistent_requests, MPI_STATUSES_IGNORE);
+    persistent_requests_active = false;
+    performance_timing_mgr->performance_timing_stop(send_wait_timing_unit);
 }
 
 
@@ -307,7 +493,7 @@ bool Runtime_trans_algorithm::is_remote_data_buf_ready(bool bypass_timer)
     last_field_remote_recv_count ++;
 
     wtime(&time2);
-    local_comp_node->get_performance_timing_mgr()->performance_timing_add(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_SEND_QUERRY, -1, remote_comp_full_name, time2-time1);
+    performance_timing_mgr->performance_timing_add(send_query_timing_unit, time2-time1);
     
     return true;
 }
@@ -331,25 +517,21 @@ void Runtime_trans_algorithm::receive_data_in_temp_buffer()
     }
 
 #ifndef USE_ONE_SIDED_MPI
-    local_comp_node->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV, -1, remote_comp_full_name);
-    for (int i = 0; i < index_remote_procs_with_common_data.size(); i ++) {
-        int remote_proc_index = index_remote_procs_with_common_data[i];
-        if (transfer_size_with_remote_procs[remote_proc_index] == 0) 
-            continue;
-        data_buf = (void *) (total_buf + recv_displs_in_current_proc[remote_proc_index]);
-        int remote_proc_id = remote_proc_ranks_in_union_comm[remote_proc_index];
-        MPI_Irecv((char *)data_buf, 4*sizeof(long)+transfer_size_with_remote_procs[remote_proc_index], MPI_CHAR, remote_proc_id, comm_tag, union_comm, &request[i]);
-    }    
-    local_comp_node->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV, -1, remote_comp_full_name);
-    local_comp_node->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV_WAIT, -1, remote_comp_full_name);
-    for (int i = 0; i < index_remote_procs_with_common_data.size(); i ++) {
-        int remote_proc_index = index_remote_procs_with_common_data[i];
-        if (transfer_size_with_remote_procs[remote_proc_index] == 0) 
-            continue;
-        MPI_Status state;
-        MPI_Wait(&request[i], &state);
-    }
-    local_comp_node->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV_WAIT, -1, remote_comp_full_name);
+    performance_timing_mgr->performance_timing_start(recv_timing_unit);
+    build_persistent_requests();
+    MPI_Startall(num_persistent_requests, persistent_requests);
+    performance_timing_mgr->performance_timing_stop(recv_timing_unit);
+    performance_timing_mgr->performance_timing_start(recv_wait_timing_unit);
+    if (num_persistent_requests > 0) {
+        int first_arrived_request;
+        performance_timing_mgr->performance_timing_start(recv_remote_wait_timing_unit);
+        MPI_Waitany(num_persistent_requests, persistent_requests, &first_arrived_request, MPI_STATUS_IGNORE);
+        performance_timing_mgr->performance_timing_stop(recv_remote_wait_timing_unit);
+    }
+    performance_timing_mgr->performance_timing_start(recv_transfer_timing_unit);
+    MPI_Waitall(num_persistent_requests, persistent_requests, MPI_STATUSES_IGNORE);
+    performance_timing_mgr->performance_timing_stop(recv_transfer_timing_unit);
+    performance_timing_mgr->performance_timing_stop(recv_wait_timing_unit);
 #endif
 
     wtime(&time1);
@@ -400,7 +582,7 @@ void Runtime_trans_algorithm::receive_data_in_temp_buffer()
 
 #ifdef USE_ONE_SIDED_MPI
     wtime(&time2);    
-    local_comp_node->get_performance_timing_mgr()->performance_timing_add(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV_QUERRY, -1, remote_comp_full_name, time2-time1);
+    performance_timing_mgr->performance_timing_add(recv_query_timing_unit, time2-time1);
 #endif    
 
     int empty_history_receive_buffer_index = -1;
@@ -493,7 +675,7 @@ void Runtime_trans_algorithm::receive_data_in_temp_buffer()
 #ifdef USE_ONE_SIDED_MPI
     set_local_tags();
     wtime(&time3);
-    local_comp_node->get_performance_timing_mgr()->performance_timing_add(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV, -1, remote_comp_full_name, time3-time2);
+    performance_timing_mgr->performance_timing_add(recv_timing_unit, time3-time2);
 #endif    
 }
 
@@ -521,21 +703,14 @@ bool Runtime_trans_algorithm::send(bool bypass_timer)
         remote_comp_node->allocate_proc_latest_model_time();
     }
 #ifndef USE_ONE_SIDED_MPI
-    comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_SEND_WAIT, -1, remote_comp_full_name);
-    if (!is_first_run) {
-        for (int i = 0; i < index_remote_procs_with_common_data.size(); i ++) {
-            int remote_proc_index = index_remote_procs_with_common_data[i];
-            MPI_Status state;
-            MPI_Wait(&request[i], &state);
-        }
-    }
-    comp_comm_group_mgt_mgr->get_global_node_of_local_comp(comp_id,false,"")->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_SEND_WAIT, -1, remote_comp_full_name);
-    is_first_run = false;
+    complete_send();
 #endif
 
     if (index_remote_procs_with_common_data.size() > 0) {
         preprocess();
-#ifdef USE_ONE_SIDED_MPI
+#ifndef USE_ONE_SIDED_MPI
+        build_persistent_requests();
+#else
         if (!is_remote_data_buf_ready(bypass_timer)) {
             inout_interface_mgr->runtime_receive_algorithms_receive_data();
             return false;
@@ -543,15 +718,14 @@ bool Runtime_trans_algorithm::send(bool bypass_timer)
 #endif
     }
 
-    for (int j = 0; j < num_transfered_fields; j ++) {
-        fields_mem[j]->check_field_sum("before sending data");
+    memory_manager->check_sum_of_fields(fields_mem, num_transfered_fields, "before sending data");
+    for (int j = 0; j < num_transfered_fields; j ++)
         fields_mem[j]->use_field_values("before sending data");
-    }  
 
     if (index_remote_procs_with_common_data.size() == 0)
         return true;
 
-    local_comp_node->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_SEND, -1, remote_comp_full_name);
+    performance_timing_mgr->performance_timing_start(send_timing_unit);
 
     long current_full_time = time_mgr->get_current_full_time();
     int offset = 0;
@@ -584,11 +758,8 @@ bool Runtime_trans_algorithm::send(bool bypass_timer)
         tag_buf[2] = (long) time_mgr->get_runtype_mark();
         tag_buf[3] = time_mgr->get_restart_full_time();
 
+#ifdef USE_ONE_SIDED_MPI
         int remote_proc_id = remote_proc_ranks_in_union_comm[remote_proc_index];
-
-#ifndef USE_ONE_SIDED_MPI
-        MPI_Isend(tag_buf, 4*sizeof(long)+transfer_size_with_remote_procs[remote_proc_index], MPI_CHAR, remote_proc_id, comm_tag, union_comm, &request[i]);
-#else
         MPI_Win_lock(MPI_LOCK_SHARED, remote_proc_id, 0, data_win);
         MPI_Put(tag_buf, 4*sizeof(long)+transfer_size_with_remote_procs[remote_proc_index], MPI_CHAR, remote_proc_id, send_displs_in_remote_procs[remote_proc_index], 4*sizeof(long)+transfer_size_with_remote_procs[remote_proc_index], MPI_CHAR, data_win);
         MPI_Win_unlock(remote_proc_id, data_win);
@@ -597,6 +768,11 @@ bool Runtime_trans_algorithm::send(bool bypass_timer)
         EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "Set remote tag to component \"%s\": %ld %ld", remote_comp_full_name, tag_buf[0], tag_buf[1]);
     }
 
+#ifndef USE_ONE_SIDED_MPI
+    MPI_Startall(num_persistent_requests, persistent_requests);
+    persistent_requests_active = true;
+#endif
+
     EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR, -1, offset <= data_buf_size, "Software error in Runtime_trans_algorithm::send: wrong data_buf_size: %d vs %d", offset, data_buf_size);
 
     if (bypass_timer)
@@ -605,7 +781,7 @@ bool Runtime_trans_algorithm::send(bool bypass_timer)
 
     EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "Finish sending data to component \"%s\": %d", remote_comp_full_name, comm_tag);
 
-    local_comp_node->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_SEND, -1, remote_comp_full_name);
+    performance_timing_mgr->performance_timing_stop(send_timing_unit);
 
     return true;
 }
@@ -617,7 +793,7 @@ bool Runtime_trans_algorithm::recv(bool bypass_timer)
     
 
 #ifdef USE_ONE_SIDED_MPI
-    local_comp_node->get_performance_timing_mgr()->performance_timing_start(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV_WAIT, -1, remote_comp_full_name);
+    performance_timing_mgr->performance_timing_start(recv_wait_timing_unit);
 #endif
     if (bypass_timer) {
         EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "Bypass timer to begin to receive data from component \"%s\": %ld: %d: %d", remote_comp_full_name, current_remote_fields_time, bypass_counter, comm_tag);
@@ -647,10 +823,9 @@ bool Runtime_trans_algorithm::recv(bool bypass_timer)
         last_receive_sender_time = (bypass_counter%8)*((long)10000000000000000);
     else last_receive_sender_time = current_remote_fields_time;
 
-    for (int j = 0; j < num_transfered_fields; j ++) {
-         fields_mem[j]->check_field_sum("after receiving data");
+    memory_manager->check_sum_of_fields(fields_mem, num_transfered_fields, "after receiving data");
+    for (int j = 0; j < num_transfered_fields; j ++)
          fields_mem[j]->define_field_values(false);
-    }    
 
     if (index_remote_procs_with_common_data.size() > 0) {
         history_receive_buffer_status[last_history_receive_buffer_index] = false;
@@ -660,7 +835,7 @@ bool Runtime_trans_algorithm::recv(bool bypass_timer)
     EXECUTION_REPORT_LOG(REPORT_LOG, comp_id, true, "Finish receiving data from component \"%s\" at the remote model time %ld vs %ld", remote_comp_full_name, last_receive_sender_time, current_remote_fields_time);
 
 #ifdef USE_ONE_SIDED_MPI
-    local_comp_node->get_performance_timing_mgr()->performance_timing_stop(TIMING_TYPE_COMMUNICATION, TIMING_COMMUNICATION_RECV_WAIT, -1, remote_comp_full_name);
+    performance_timing_mgr->performance_timing_stop(recv_wait_timing_unit);
 #endif
 
     return true;
@@ -691,76 +866,20 @@ void Runtime_trans_algorithm::preprocess()
 
 void Runtime_trans_algorithm::pack_MD_data(int remote_proc_index, int field_index, int * offset)
 {
-    int num_segments;
-    int *segment_starts, *num_elements_in_segments;
-    int i, j;
-    int field_2D_size;
+    Runtime_trans_pack_plan *pack_plan = get_pack_plan(field_index, remote_proc_index);
 
 
-    num_segments = fields_routers[field_index]->get_num_local_indx_segments_with_remote_proc(true, remote_proc_index);
-    if (num_segments == 0)
-        return;
-
-    segment_starts = fields_routers[field_index]->get_local_indx_segment_starts_with_remote_proc(true, remote_proc_index);
-    num_elements_in_segments = fields_routers[field_index]->get_local_indx_segment_lengths_with_remote_proc(true, remote_proc_index);
-    field_2D_size = fields_routers[field_index]->get_src_decomp_size();
-    for (i = 0; i < num_segments; i ++) {
-        switch (fields_data_type_sizes[field_index]) {
-            case 1:
-                pack_segment_data((char*)((char*)data_buf+(*offset)), (char*)fields_data_buffers[field_index], segment_starts[i], num_elements_in_segments[i], field_2D_size, field_grids_num_lev[field_index], is_V1D_sub_grid_after_H2D_sub_grid[field_index]);
-                break;
-            case 2:
-                pack_segment_data((short*)((char*)data_buf+(*offset)), (short*)fields_data_buffers[field_index], segment_starts[i], num_elements_in_segments[i], field_2D_size, field_grids_num_lev[field_index], is_V1D_sub_grid_after_H2D_sub_grid[field_index]);
-                break;
-            case 4:
-                pack_segment_data((int*)((char*)data_buf+(*offset)), (int*)fields_data_buffers[field_index], segment_starts[i], num_elements_in_segments[i], field_2D_size, field_grids_num_lev[field_index], is_V1D_sub_grid_after_H2D_sub_grid[field_index]);
-                break;
-            case 8:
-                pack_segment_data((double*)((char*)data_buf+(*offset)), (double*)fields_data_buffers[field_index], segment_starts[i], num_elements_in_segments[i], field_2D_size, field_grids_num_lev[field_index], is_V1D_sub_grid_after_H2D_sub_grid[field_index]);
-                break;
-            default:
-                EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR,-1, false, "Software error in Runtime_trans_algorithm::pack_MD_data: unsupported data type in runtime transfer algorithm. Please verify.");
-                break;
-        }
-        (*offset) += num_elements_in_segments[i]*field_grids_num_lev[field_index]*fields_data_type_sizes[field_index];
-    }
+    pack_plan->pack((char*)data_buf+(*offset), (const char*)fields_data_buffers[field_index]);
+    (*offset) += pack_plan->get_packed_size();
 }
 
 
 void Runtime_trans_algorithm::unpack_MD_data(void *data_buf, int remote_proc_index, int field_index, void *field_data_buffer, int * offset)
 {
-    int num_segments;
-    int *segment_starts, *num_elements_in_segments;
-    int i, j;
-    int field_2D_size;
+    Runtime_trans_pack_plan *pack_plan = get_pack_plan(field_index, remote_proc_index);
 
 
-    num_segments = fields_routers[field_index]->get_num_local_indx_segments_with_remote_proc(false, remote_proc_index);
-    if (num_segments == 0)
-        return;
-
-    segment_starts = fields_routers[field_index]->get_local_indx_segment_starts_with_remote_proc(false, remote_proc_index);
-    num_elements_in_segments = fields_routers[field_index]->get_local_indx_segment_lengths_with_remote_proc(false, remote_proc_index);
-    field_2D_size = fields_routers[field_index]->get_dst_decomp_size();
-    for (i = 0; i < num_segments; i ++) {
-        switch (fields_data_type_sizes[field_index]) {
-            case 1:
-                unpack_segment_data((char*)((char*)data_buf+(*offset)), (char*)field_data_buffer, segment_starts[i], num_elements_in_segments[i], field_2D_size, field_grids_num_lev[field_index], is_V1D_sub_grid_after_H2D_sub_grid[field_index]);
-                break;
-            case 2:
-                unpack_segment_data((short*)((char*)data_buf+(*offset)), (short*)field_data_buffer, segment_starts[i], num_elements_in_segments[i], field_2D_size, field_grids_num_lev[field_index], is_V1D_sub_grid_after_H2D_sub_grid[field_index]);
-                break;
-            case 4:
-                unpack_segment_data((int*)((char*)data_buf+(*offset)), (int*)field_data_buffer, segment_starts[i], num_elements_in_segments[i], field_2D_size, field_grids_num_lev[field_index], is_V1D_sub_grid_after_H2D_sub_grid[field_index]);
-                break;
-            case 8:
-                unpack_segment_data((double*)((char*)data_buf+(*offset)), (double*)field_data_buffer, segment_starts[i], num_elements_in_segments[i], field_2D_size, field_grids_num_lev[field_index], is_V1D_sub_grid_after_H2D_sub_grid[field_index]);
-                break;
-            default:
-                EXECUTION_REPORT_ERROR_OPTIONALLY(REPORT_ERROR,-1, false, "Software error in Runtime_trans_algorithm::unpack_MD_data: unsupported data type in runtime transfer algorithm. Please verify.");
-                break;
-        }
-        (*offset) += num_elements_in_segments[i]*field_grids_num_lev[field_index]*fields_data_type_sizes[field_index];
-    }
+    pack_plan->unpack((const char*)data_buf+(*offset), (char*)field_data_buffer);
+    (*offset) += pack_plan->get_packed_size();
 }
 
@@ -17,6 +17,32 @@
 #include "memory_mgt.h"
 #include "timer_mgt.h"
 
+
+#define MIN_BYTES_OF_PACK_PLAN_MEMCPY_RUN     64
+
+
+class Runtime_trans_pack_plan
+{
+    private:
+        int data_type_size;
+        bool use_memcpy_runs;
+        std::vector<long> runs_field_offsets;
+        std::vector<long> runs_lengths;
+        std::vector<int> gather_indexes;
+        long packed_size;
+
+        template <class T> void gather_elements(T *, const T *);
+        template <class T> void scatter_elements(const T *, T *);
+
+    public:
+        Runtime_trans_pack_plan(Routing_info *, bool, int, int, int, bool);
+        ~Runtime_trans_pack_plan() {}
+        void pack(char *, const char *);
+        void unpack(const char *, char *);
+        long get_packed_size() { return packed_size; }
+};
+
+
 class Runtime_trans_algorithm
 {
     private:
@@ -65,6 +91,15 @@ class Runtime_trans_algorithm
         Comp_comm_group_mgt_node * remote_comp_node;
         bool remote_comp_node_updated;
         char remote_comp_full_name[NAME_STR_SIZE];
+        Performance_timing_mgt *performance_timing_mgr;
+        int send_timing_unit;
+        int send_wait_timing_unit;
+        int send_query_timing_unit;
+        int recv_timing_unit;
+        int recv_wait_timing_unit;
+        int recv_query_timing_unit;
+        int recv_remote_wait_timing_unit;
+        int recv_transfer_timing_unit;
         int current_proc_local_id;
         int current_proc_global_id;
         MPI_Comm union_comm;
@@ -87,10 +122,14 @@ class Runtime_trans_algorithm
         void preprocess();
         void pack_MD_data(int, int, int *);
         void unpack_MD_data(void *, int, int, void*, int *);
-        template <class T> void pack_segment_data(T *, T *, int, int, int, int, bool);
-        template <class T> void unpack_segment_data(T *, T *, int, int, int, int, bool);
-        MPI_Request * request;
-        bool is_first_run;
+        void build_pack_plan_groups();
+        Runtime_trans_pack_plan *get_pack_plan(int, int);
+        std::vector<std::vector<Runtime_trans_pack_plan*> > pack_plan_groups;
+        int *fields_pack_plan_groups;
+        void build_persistent_requests();
+        MPI_Request * persistent_requests;
+        int num_persistent_requests;
+        bool persistent_requests_active;
 
     public:
         Runtime_trans_algorithm(bool, int, Field_mem_info **, Routing_info **, MPI_Comm, int *, int);
@@ -107,6 +146,7 @@ class Runtime_trans_algorithm
         void set_tag_win(MPI_Win win) {tag_win = win;}
         void receive_data_in_temp_buffer();
         long get_history_receive_sender_time();
+        void complete_send();
 };
 
 
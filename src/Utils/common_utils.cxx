@@ -21,25 +21,34 @@ void write_string_into_array_buffer(const char *full_string, long array_size, ch
 }
 
 
-void write_data_into_array_buffer(const void *data, long data_size, char **temp_array_buffer, long &buffer_max_size, long &buffer_content_size)
+void reserve_array_buffer(long required_size, char **temp_array_buffer, long &buffer_max_size, long &buffer_content_size)
 {
     if (*temp_array_buffer == NULL) {
-        buffer_max_size = 2 * data_size;
+        buffer_max_size = required_size;
         buffer_content_size = 0;
         *temp_array_buffer = new char [buffer_max_size];
+        return;
     }
 
-    if (buffer_max_size < buffer_content_size+data_size) {
-        buffer_max_size = (buffer_content_size+data_size) * 2;
-        char *temp_buffer = new char [buffer_max_size];
-        for (int i = 0; i < buffer_content_size; i ++)
-            temp_buffer[i] = (*temp_array_buffer)[i];
+    if (buffer_max_size < required_size) {
+        char *temp_buffer = new char [required_size];
+        memcpy(temp_buffer, *temp_array_buffer, buffer_content_size);
         delete [] *temp_array_buffer;
         *temp_array_buffer = temp_buffer;
+        buffer_max_size = required_size;
     }
+}
+
+
+void write_data_into_array_buffer(const void *data, long data_size, char **temp_array_buffer, long &buffer_max_size, long &buffer_content_size)
+{
+    if (*temp_array_buffer == NULL)
+        reserve_array_buffer(2*data_size, temp_array_buffer, buffer_max_size, buffer_content_size);
+    else if (buffer_max_size < buffer_content_size+data_size)
+        reserve_array_buffer((buffer_content_size+data_size)*2, temp_array_buffer, buffer_max_size, buffer_content_size);
 
-    for (int i = 0; i < data_size; i ++)
-        (*temp_array_buffer)[buffer_content_size++] = ((char*)data)[i];
+    memcpy(*temp_array_buffer+buffer_content_size, data, data_size);
+    buffer_content_size += data_size;
 }
 
 
@@ -50,8 +59,7 @@ bool read_data_from_array_buffer(void *data, long data_size, const char *temp_ar
             EXECUTION_REPORT(REPORT_ERROR,-1, false, "Software error in read_data_from_array_buffer");
         else return false;
     
-    for (int i = 0; i < data_size; i ++)
-        ((char*) data)[i] = temp_array_buffer[buffer_content_iter-data_size+i];
+    memcpy(data, temp_array_buffer+buffer_content_iter-data_size, data_size);
     
     buffer_content_iter -= data_size;
 
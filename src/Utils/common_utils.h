@@ -24,6 +24,7 @@ extern bool get_next_integer_attr(char **, int&);
 extern bool get_next_double_attr(char **line, double&);
 extern bool is_end_of_file(FILE *);
 extern void write_string_into_array_buffer(const char*, long, char**, long&, long&);
+extern void reserve_array_buffer(long, char **, long&, long&);
 extern void write_data_into_array_buffer(const void*, long, char **, long&, long&);
 extern bool read_data_from_array_buffer(void*, long, const char*, long &, bool);
 extern void check_for_coupling_registration_stage(int, int, bool, const char *);
@@ -20,14 +20,15 @@ bool report_error_enabled;
 bool report_progress_enabled;
 bool report_internal_log_enabled;
 bool flush_log_file;
+bool report_timing_trace_enabled;
 
 
 void import_report_setting()
 {
     char XML_file_name[NAME_STR_SIZE];
     int line_number;
-    char keywords[5][NAME_STR_SIZE];
-    bool report_setting[5];
+    char keywords[6][NAME_STR_SIZE];
+    bool report_setting[6];
 
 
     report_external_log_enabled = false;
@@ -35,6 +36,7 @@ void import_report_setting()
     report_internal_log_enabled = false;
     report_progress_enabled = false;
     flush_log_file = false;
+    report_timing_trace_enabled = false;
 
     sprintf(XML_file_name, "%s/all/CCPL_report.xml", comp_comm_group_mgt_mgr->get_config_root_dir());
     TiXmlDocument *XML_file = open_XML_file_to_read(-1, XML_file_name, MPI_COMM_WORLD, false);
@@ -46,9 +48,10 @@ void import_report_setting()
     sprintf(keywords[2], "report_progress");
     sprintf(keywords[3], "report_error");
     sprintf(keywords[4], "flush_log_file");
+    sprintf(keywords[5], "report_timing_trace");
     
     TiXmlElement *XML_element = XML_file->FirstChildElement();
-    for (int i = 0; i < 5; i ++) {
+    for (int i = 0; i < 6; i ++) {
         report_setting[i] = false;
         const char *setting = XML_element->Attribute(keywords[i], &line_number);
         if (setting == NULL)
@@ -64,6 +67,7 @@ void import_report_setting()
     report_progress_enabled = report_setting[2];
     report_error_enabled = report_setting[3];
     flush_log_file = report_setting[4];
+    report_timing_trace_enabled = report_setting[5];
 }
 
 
@@ -153,29 +157,33 @@ void report_header(int report_type, int comp_id, bool &condition, char *output_f
 }
 
 
+/* The header and the message are formatted once, directly into the output string. Logs are appended to the log 
+   buffers, which are written out for every report when flush_log_file is on or an error is reported, and otherwise
+   when they are full and at finalization */
 void execution_report(int report_type, int comp_id, bool condition, const char *format, ...)
 {
-    char output_format[NAME_STR_SIZE*16];
     char output_string[NAME_STR_SIZE*16*16];
+    int header_size, output_size;
 
 
-    report_header(report_type, comp_id, condition, output_format);
+    report_header(report_type, comp_id, condition, output_string);
     
     if (!condition)
         return;
-    
-    strcat(output_format, format);
-    strcat(output_format, "\n\n");
 
     if (comp_id != -1 && (comp_id == comp_comm_group_mgt_mgr->get_global_node_root()->get_comp_id() || !comp_comm_group_mgt_mgr->is_legal_local_comp_id(comp_id, true) || components_time_mgrs->get_time_mgr(comp_id) == NULL))
         comp_id = -1;
 
+    header_size = strlen(output_string);
     va_list pArgList;
     va_start(pArgList, format);
-    vsprintf(output_string, output_format, pArgList);
-    va_end(pArgList);    
+    output_size = header_size + vsnprintf(output_string+header_size, NAME_STR_SIZE*16*16-header_size-2, format, pArgList);
+    va_end(pArgList);
+    if (output_size > NAME_STR_SIZE*16*16-3)
+        output_size = NAME_STR_SIZE*16*16-3;
+    strcpy(output_string+output_size, "\n\n");
     if (comp_comm_group_mgt_mgr == NULL) {
-        fprintf(stdout, output_string);
+        fputs(output_string, stdout);
         if (flush_log_file || report_type == REPORT_ERROR)
             fflush(stdout);
     }
@@ -10,9 +10,29 @@
 #ifndef EXECUTION_REPORT_H
 #define EXECUTION_REPORT_H
 
-#define EXECUTION_REPORT                        execution_report
-#define EXECUTION_REPORT_LOG                    if (report_internal_log_enabled) execution_report
-#define EXECUTION_REPORT_ERROR_OPTIONALLY       if (report_error_enabled) execution_report
+#ifdef __GNUC__
+#define CCPL_UNLIKELY(x)                        __builtin_expect(!!(x), 0)
+#else
+#define CCPL_UNLIKELY(x)                        (x)
+#endif
+
+
+/* The condition is evaluated inline and the report (header lookups, formatting of the arguments) is only
+   produced when it is triggered, so that checks can be kept in per-element and per-step code */
+#define EXECUTION_REPORT(report_type, comp_id, condition, ...)          do { bool report_condition = (condition); if (CCPL_UNLIKELY(is_execution_report_triggered(report_type, report_condition))) execution_report(report_type, comp_id, report_condition, ##__VA_ARGS__); } while (0)
+#define EXECUTION_REPORT_LOG                    if (report_internal_log_enabled) EXECUTION_REPORT
+
+
+#define EXECUTION_REPORT_ERROR_OPTIONALLY       if (report_error_enabled) EXECUTION_REPORT
+
+
+/* Pure software consistency checks of C-Coupler are removed at compile time when DISABLE_INTERNAL_ERROR_REPORT 
+   is defined. EXECUTION_REPORT_ERROR_OPTIONALLY also guards checks of model inputs, so it is never removed */
+#ifdef DISABLE_INTERNAL_ERROR_REPORT
+#define EXECUTION_REPORT_INTERNAL_ERROR         if (false) execution_report
+#else
+#define EXECUTION_REPORT_INTERNAL_ERROR         EXECUTION_REPORT
+#endif
 
 
 
@@ -36,6 +56,7 @@ extern bool report_error_enabled;
 extern bool report_progress_enabled;
 extern bool report_internal_log_enabled;
 extern bool flush_log_file;
+extern bool report_timing_trace_enabled;
 
 
 extern void import_report_setting();
@@ -46,4 +67,22 @@ extern void execution_report(int, int, bool);
 extern void execution_report(int, int, bool, const char *, ...);
 
 
+inline bool is_execution_report_triggered(int report_type, bool condition)
+{
+    switch (report_type) {
+        case REPORT_ERROR:
+        case REPORT_WARNING:
+            return !condition;
+        case REPORT_LOG:
+            return report_internal_log_enabled;
+        case REPORT_EXTERNAL_LOG:
+            return report_external_log_enabled;
+        case REPORT_PROGRESS:
+            return report_progress_enabled;
+        default:
+            return true;
+    }
+}
+
+
 #endif